@@ -0,0 +1,149 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * baselinecache.cpp
+ * On-disk cache of SIFT baseline results.
+ */
+
+#include "baselinecache.h"
+#include "benchmark.h"
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+constexpr uint64_t FNV_PRIME = 1099511628211ull;
+constexpr int CACHE_FORMAT_VERSION = 1;
+
+void fnv1a(uint64_t& hash, const char* data, const size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= FNV_PRIME;
+    }
+}
+
+bool hashFile(uint64_t& hash, const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+
+    char buffer[1 << 16];
+    while (in.read(buffer, sizeof(buffer)) || in.gcount() > 0) {
+        fnv1a(hash, buffer, static_cast<size_t>(in.gcount()));
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+std::string BaselineCache::makeKey(const std::string& referencePath,
+                                   const std::string& registeredPath,
+                                   const std::string& settings) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    if (!hashFile(hash, referencePath)) return "";
+
+    // Separators keep (a+b, c) and (a, b+c) apart
+    fnv1a(hash, "\0", 1);
+    if (!hashFile(hash, registeredPath)) return "";
+    fnv1a(hash, "\0", 1);
+    fnv1a(hash, settings.data(), settings.size());
+
+    std::ostringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return key.str();
+}
+
+std::string BaselineCache::entryPath(const std::string& key) const {
+    return (fs::path(directory_) / (key + ".yml")).string();
+}
+
+bool BaselineCache::load(const std::string& key, StitchingMetrics& metrics) const {
+    if (key.empty()) return false;
+
+    std::error_code ec;
+    if (!fs::exists(entryPath(key), ec)) return false;
+
+    try {
+        cv::FileStorage fsIn(entryPath(key), cv::FileStorage::READ);
+        if (!fsIn.isOpened() || static_cast<int>(fsIn["version"]) != CACHE_FORMAT_VERSION) return false;
+
+        cv::Mat H;
+        fsIn["homography"] >> H;
+        if (H.empty()) return false;
+
+        metrics.homography = H;
+        metrics.referenceWidth = static_cast<int>(fsIn["referenceWidth"]);
+        metrics.referenceHeight = static_cast<int>(fsIn["referenceHeight"]);
+        metrics.registeredWidth = static_cast<int>(fsIn["registeredWidth"]);
+        metrics.registeredHeight = static_cast<int>(fsIn["registeredHeight"]);
+        metrics.numKeypointsReference = static_cast<int>(fsIn["numKeypointsReference"]);
+        metrics.numKeypointsRegistered = static_cast<int>(fsIn["numKeypointsRegistered"]);
+        metrics.numMatches = static_cast<int>(fsIn["numMatches"]);
+        metrics.numInliers = static_cast<int>(fsIn["numInliers"]);
+        metrics.detectionTimeReference = static_cast<double>(fsIn["detectionTimeReference"]);
+        metrics.detectionTimeRegistered = static_cast<double>(fsIn["detectionTimeRegistered"]);
+        metrics.descriptorTimeReference = static_cast<double>(fsIn["descriptorTimeReference"]);
+        metrics.descriptorTimeRegistered = static_cast<double>(fsIn["descriptorTimeRegistered"]);
+        metrics.matchingTime = static_cast<double>(fsIn["matchingTime"]);
+        metrics.homographyTime = static_cast<double>(fsIn["homographyTime"]);
+        metrics.warpingTime = static_cast<double>(fsIn["warpingTime"]);
+        metrics.totalStitchingTime = static_cast<double>(fsIn["totalStitchingTime"]);
+    } catch (const cv::Exception&) {
+        return false; // corrupt entry: treat as a miss and recompute
+    }
+
+    metrics.sizeCategory = getImageSizeCategory(metrics.referenceWidth, metrics.referenceHeight);
+    metrics.stitchingSuccess = true;
+    metrics.fromCache = true;
+    return true;
+}
+
+void BaselineCache::store(const std::string& key, const StitchingMetrics& metrics) const {
+    if (key.empty() || !metrics.stitchingSuccess || metrics.homography.empty()) return;
+
+    std::error_code ec;
+    fs::create_directories(directory_, ec);
+
+    // Unique temporary name, then an atomic rename: concurrent writers never expose a partial entry
+    std::ostringstream tmpName;
+    tmpName << key << ".tmp." << std::hash<std::thread::id>{}(std::this_thread::get_id());
+    const std::string tmpPath = (fs::path(directory_) / tmpName.str()).string();
+
+    {
+        cv::FileStorage fsOut(tmpPath, cv::FileStorage::WRITE);
+        if (!fsOut.isOpened()) return;
+        fsOut << "version" << CACHE_FORMAT_VERSION;
+        fsOut << "homography" << metrics.homography;
+        fsOut << "referenceWidth" << metrics.referenceWidth;
+        fsOut << "referenceHeight" << metrics.referenceHeight;
+        fsOut << "registeredWidth" << metrics.registeredWidth;
+        fsOut << "registeredHeight" << metrics.registeredHeight;
+        fsOut << "numKeypointsReference" << metrics.numKeypointsReference;
+        fsOut << "numKeypointsRegistered" << metrics.numKeypointsRegistered;
+        fsOut << "numMatches" << metrics.numMatches;
+        fsOut << "numInliers" << metrics.numInliers;
+        fsOut << "detectionTimeReference" << metrics.detectionTimeReference;
+        fsOut << "detectionTimeRegistered" << metrics.detectionTimeRegistered;
+        fsOut << "descriptorTimeReference" << metrics.descriptorTimeReference;
+        fsOut << "descriptorTimeRegistered" << metrics.descriptorTimeRegistered;
+        fsOut << "matchingTime" << metrics.matchingTime;
+        fsOut << "homographyTime" << metrics.homographyTime;
+        fsOut << "warpingTime" << metrics.warpingTime;
+        fsOut << "totalStitchingTime" << metrics.totalStitchingTime;
+        fsOut.release();
+    }
+
+    fs::rename(tmpPath, entryPath(key), ec);
+    if (ec) fs::remove(tmpPath, ec);
+}
@@ -0,0 +1,50 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * baselinecache.h
+ * On-disk cache of SIFT baseline results, keyed by the content of the image pair and the SIFT settings,
+ * so LP-only runs can compare against the baseline homography without rerunning SIFT.
+ */
+
+#ifndef BASELINECACHE_H
+#define BASELINECACHE_H
+
+#include <string>
+
+struct StitchingMetrics;
+
+/*
+ * BaselineCache - One YAML file per image pair in a cache directory.
+ * The key is a 64-bit FNV-1a hash of both image files' bytes and a settings string, so renamed or
+ * copied datasets hit the same entry and any change to the pixels or the SIFT pipeline misses.
+ */
+class BaselineCache {
+public:
+    explicit BaselineCache(std::string directory) : directory_(std::move(directory)) {}
+
+    /** @brief Content key of an image pair.
+     *  @param referencePath Reference image file.
+     *  @param registeredPath Registered image file.
+     *  @param settings Everything else the baseline depends on (detector and matcher parameters, ingest scale).
+     *  @return 16 hex digits, or an empty string if either file cannot be read.
+     */
+    static std::string makeKey(const std::string& referencePath,
+                               const std::string& registeredPath,
+                               const std::string& settings);
+
+    /** @brief Load a cached baseline into metrics (homography, keypoint/match counts, image sizes, timings).
+     *  @return False on a miss or an unreadable entry.
+     */
+    bool load(const std::string& key, StitchingMetrics& metrics) const;
+
+    /** @brief Store a successful baseline run. Written to a temporary file and renamed into place. */
+    void store(const std::string& key, const StitchingMetrics& metrics) const;
+
+private:
+    std::string directory_;
+
+    std::string entryPath(const std::string& key) const;
+};
+
+#endif //BASELINECACHE_H
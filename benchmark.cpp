@@ -12,6 +12,15 @@
 #include <fstream>
 #include <iomanip>
 #include <algorithm>
+#include <cmath>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include <opencv2/imgproc.hpp>
 #include <opencv2/imgcodecs.hpp>
@@ -19,10 +28,21 @@
 #include <opencv2/xfeatures2d.hpp>
 #include "lpsift.h"
 #include "lporb.h"
+#include "lpdog.h"
+#include "concurrency.h"
+#include "prefetch.h"
+#include "trace.h"
+#include "synthgen.h"
+#include "escalation.h"
 
 using namespace cv;
 using namespace std;
 
+string joinInts(const vector<int>& v);
+
+// Cleared by runRepeated during warm-ups and all but the last repetition, so outputs are written once per stitch
+static thread_local bool writeRunOutputs = true;
+
 // Helper function to limit keypoints by keeping the strongest ones
 static void limitKeypoints(std::vector<cv::KeyPoint>& kpts, size_t maxCount) {
     if (kpts.size() > maxCount) {
@@ -35,6 +55,507 @@ static void limitKeypoints(std::vector<cv::KeyPoint>& kpts, size_t maxCount) {
     }
 }
 
+// Runs detection and collects LP candidate statistics when the detector provides them
+static void detectKeypoints(const cv::Ptr<cv::Feature2D>& detector,
+                            const cv::Mat& image,
+                            std::vector<cv::KeyPoint>& kpts,
+                            LPDetectionStats& stats) {
+    if (const auto lpsift = detector.dynamicCast<LPSIFT>()) {
+        lpsift->detectWithStats(image, kpts, stats);
+    } else if (const auto lporb = detector.dynamicCast<LPORB>()) {
+        lporb->detectWithStats(image, kpts, stats);
+    } else {
+        detector->detect(image, kpts);
+        stats = LPDetectionStats{};
+        stats.candidates = kpts.size();
+    }
+}
+
+// One zeroed entry per LP window size, ascending; other detectors get no breakdown
+static void initWindowSizeStats(StitchingMetrics& metrics, const std::vector<int>& windowSizes) {
+    metrics.windowSizeStats.clear();
+    const std::string& name = metrics.algorithmName;
+    if (name != "LP-SIFT" && name != "LP-ORB" && name != "LP-DoG") return;
+
+    std::vector<int> sorted(windowSizes);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    for (const int windowSize : sorted) {
+        WindowSizeStats entry;
+        entry.windowSize = windowSize;
+        metrics.windowSizeStats.push_back(entry);
+    }
+}
+
+// Entry of a window size, or nullptr. Stage tasks never add entries, so the two images' tasks may update
+// their own fields concurrently
+static WindowSizeStats* findWindowSize(std::vector<WindowSizeStats>& stats, const int windowSize) {
+    const auto it = std::lower_bound(stats.begin(), stats.end(), windowSize,
+                                     [](const WindowSizeStats& s, const int w) { return s.windowSize < w; });
+    return it != stats.end() && it->windowSize == windowSize ? &*it : nullptr;
+}
+
+// Entry of a window size, inserted zeroed at its ascending position if missing. Only for window sizes
+// used beyond the configured ones (the escalation ladder's finer scales), once no stage task is running
+static WindowSizeStats& windowSizeEntry(std::vector<WindowSizeStats>& stats, const int windowSize) {
+    auto it = std::lower_bound(stats.begin(), stats.end(), windowSize,
+                               [](const WindowSizeStats& s, const int w) { return s.windowSize < w; });
+    if (it == stats.end() || it->windowSize != windowSize) {
+        WindowSizeStats entry;
+        entry.windowSize = windowSize;
+        it = stats.insert(it, entry);
+    }
+    return *it;
+}
+
+// Adds each keypoint to the counter of its window size (kp.class_id)
+static void countByWindowSize(std::vector<WindowSizeStats>& stats,
+                              const std::vector<cv::KeyPoint>& kpts,
+                              int WindowSizeStats::* counter) {
+    if (stats.empty()) return;
+    for (const auto& kp : kpts) {
+        if (WindowSizeStats* entry = findWindowSize(stats, kp.class_id)) ++(entry->*counter);
+    }
+}
+
+// Adds the per-scale detection times of an LP detector that reports them
+static void addWindowSizeTimes(std::vector<WindowSizeStats>& stats,
+                               const LPDetectionStats& detection,
+                               double WindowSizeStats::* time) {
+    for (const auto& [windowSize, seconds] : detection.windowSeconds) {
+        if (WindowSizeStats* entry = findWindowSize(stats, windowSize)) {
+            entry->*time = std::max(0.0, entry->*time) + seconds;
+        }
+    }
+}
+
+// Attributes each match (and RANSAC inlier, mask in match order) to its reference keypoint's window size
+static void countMatchesByWindowSize(std::vector<WindowSizeStats>& stats,
+                                     const KnnMatches& matches,
+                                     const std::vector<cv::KeyPoint>& kpts1,
+                                     const std::vector<uchar>& inlierMask) {
+    if (stats.empty()) return;
+    for (size_t i = 0; i < matches.size(); ++i) {
+        WindowSizeStats* entry = findWindowSize(stats, kpts1[matches.queryIdx(i)].class_id);
+        if (!entry) continue;
+        ++entry->matches;
+        if (i < inlierMask.size() && inlierMask[i]) ++entry->inliers;
+    }
+}
+
+// Milliseconds with microsecond precision, for repetition statistics
+static std::string formatMs(const int64_t ns) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(3) << ns / 1e6;
+    return oss.str();
+}
+
+// A derived counter ratio, or "x" when its counters were unavailable (negative)
+static std::string formatRatio(const double value, const int precision) {
+    if (value < 0.0) return "x";
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(precision) << value;
+    return oss.str();
+}
+
+constexpr double KIB = 1024.0;
+constexpr double MIB = 1024.0 * 1024.0;
+
+// A byte count in KiB or MiB (unit), two decimals
+static std::string formatBytes(const double bytes, const double unit) {
+    return formatRatio(bytes / unit, 2);
+}
+
+// A heap count, or "x" when operator new was not counted (no --mem-stats)
+static std::string formatHeapCount(const uint64_t count) {
+    return heapCounting() ? std::to_string(count) : "x";
+}
+
+static std::string formatHeapBytes(const double bytes, const double unit) {
+    return heapCounting() ? formatBytes(bytes, unit) : "x";
+}
+
+// Prints the outcome of one detector run: " Done (...)" or " Failed: ...", then the stage timeline if any
+static void printRunResult(std::ostream& out, const StitchingMetrics& metrics) {
+    if (metrics.stitchingSuccess) {
+        out << " Done (" << StitchingMetrics::formatTime(metrics.totalStitchingTime) << "s";
+        if (metrics.repetitions > 1 && !metrics.stageStats.empty()) {
+            const TimingStats& total = metrics.stageStats.back();
+            out << " median of " << metrics.repetitions << ", "
+                << BOOTSTRAP_CONFIDENCE * 100 << "% CI " << formatMs(total.ciLowNs) << "-"
+                << formatMs(total.ciHighNs) << " ms";
+        }
+        out << ", " << metrics.numKeypointsReference << "/"
+            << metrics.numKeypointsRegistered << " keypoints";
+        if (metrics.numBorderRejectedReference + metrics.numBorderRejectedRegistered > 0) {
+            out << ", " << std::fixed << std::setprecision(1)
+                << metrics.getBorderRejectedFraction() * 100.0 << "% border-rejected";
+        }
+        if (metrics.numPrunedReference + metrics.numPrunedRegistered > 0) {
+            out << ", " << std::fixed << std::setprecision(1)
+                << metrics.getPrunedFraction() * 100.0 << "% pruned";
+        }
+        if (!metrics.stageSpans.empty()) {
+            out << ", " << StitchingMetrics::formatTime(metrics.getSummedStageTime())
+                << "s summed stages, " << StitchingMetrics::formatTime(metrics.getStageOverlap()) << "x overlap";
+        }
+        if (metrics.earlyStopped) {
+            out << ", stopped after " << metrics.scalesProcessed << "/" << metrics.scalesTotal << " scales";
+        }
+        if (metrics.budgetSeconds > 0.0) {
+            out << ", " << std::fixed << std::setprecision(0)
+                << metrics.getBudgetShare(metrics.totalStitchingTime) * 100.0 << "% of budget";
+            if (!metrics.degradations.empty()) out << ": " << metrics.degradations;
+        }
+        out << ")" << std::endl;
+    } else {
+        out << " Failed: " << metrics.failureReason << std::endl;
+    }
+
+    // Stage timeline of the task-graph pipeline
+    for (const auto& span : metrics.stageSpans) {
+        out << "    " << std::left << std::setw(22) << span.name
+            << std::right << std::fixed << std::setprecision(3)
+            << std::setw(8) << span.start << " - " << std::setw(8) << span.end << "s"
+            << "  [" << (span.worker >= 0 ? "worker " + std::to_string(span.worker) : "caller") << "]"
+            << std::endl;
+    }
+}
+
+// Streams LP keypoints coarse-to-fine; returns false if the detector has no streaming API
+static bool detectKeypointScales(const cv::Ptr<cv::Feature2D>& detector,
+                                 const cv::Mat& image,
+                                 const LPScaleCallback& onBatch,
+                                 LPDetectionStats& stats) {
+    if (const auto lpsift = detector.dynamicCast<LPSIFT>()) {
+        lpsift->detectScales(image, onBatch, stats);
+    } else if (const auto lporb = detector.dynamicCast<LPORB>()) {
+        lporb->detectScales(image, onBatch, stats);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Budgeted detection: LP scales are added coarsest first until share of the budget is spent or maxScales
+// are done (at least one always is). Returns the scales detected, or -1 after plain detection of a
+// detector without scale streaming
+static int detectKeypointsWithin(const cv::Ptr<cv::Feature2D>& detector,
+                                 const cv::Mat& image,
+                                 std::vector<cv::KeyPoint>& kpts,
+                                 LPDetectionStats& stats,
+                                 const Deadline& deadline,
+                                 const double share,
+                                 const int maxScales) {
+    kpts.clear();
+    int scales = 0;
+    const bool streamed = detectKeypointScales(detector, image, [&](LPScaleBatch& batch) {
+        kpts.insert(kpts.end(), batch.keypoints.begin(), batch.keypoints.end());
+        ++scales;
+        return scales < maxScales && !deadline.pastShare(share);
+    }, stats);
+    if (streamed) return scales;
+
+    detectKeypoints(detector, image, kpts, stats);
+    return -1;
+}
+
+// Warp and blend at a fraction of the resolution: both images are downscaled and H conjugated to match
+static cv::Mat warpAndBlendAtScale(const cv::Mat& imgToWarp, const cv::Mat& baseImg, const cv::Mat& H,
+                                   const double scale) {
+    cv::Mat smallToWarp, smallBase;
+    cv::resize(imgToWarp, smallToWarp, cv::Size(), scale, scale, cv::INTER_AREA);
+    cv::resize(baseImg, smallBase, cv::Size(), scale, scale, cv::INTER_AREA);
+    const cv::Mat toSmall = (cv::Mat_<double>(3, 3) << scale, 0.0, 0.0, 0.0, scale, 0.0, 0.0, 0.0, 1.0);
+    const cv::Mat toFull = (cv::Mat_<double>(3, 3) << 1.0 / scale, 0.0, 0.0, 0.0, 1.0 / scale, 0.0, 0.0, 0.0, 1.0);
+    const cv::Mat scaledH = toSmall * H * toFull;
+    return BenchmarkRunner::warpAndBlend(smallToWarp, smallBase, scaledH);
+}
+
+// Appends a degradation to the "; "-separated list
+static void addDegradation(StitchingMetrics& metrics, const std::string& degradation) {
+    metrics.degradations += (metrics.degradations.empty() ? "" : "; ") + degradation;
+}
+
+// Escalation ladder (--escalate) of a stage-by-stage stitch whose plain run failed or gave a degenerate
+// homography. Each level adds to the features of the levels before it, then matches and estimates again;
+// the first sound homography wins. Works on copies, so the plain run's result stands if every level
+// fails. Ladder time is added to the stage times it belongs to and to escalationTime
+static bool escalateRegistration(const BenchmarkRunner::DetectorConfig& config,
+                                 const cv::Mat& gray1,
+                                 const cv::Mat& gray2,
+                                 const std::vector<int>& windowSizes,
+                                 const bool denseDetection,
+                                 const Deadline& deadline,
+                                 std::vector<cv::KeyPoint>& kpts1,
+                                 std::vector<cv::KeyPoint>& kpts2,
+                                 cv::Mat& desc1,
+                                 cv::Mat& desc2,
+                                 KnnMatches& matches,
+                                 std::vector<uchar>& inlierMask,
+                                 cv::Mat& H,
+                                 StitchingMetrics& metrics) {
+    std::vector<cv::KeyPoint> k1 = kpts1, k2 = kpts2;
+    cv::Mat d1 = desc1.clone(), d2 = desc2.clone();
+    KnnMatches m;
+    std::vector<uchar> mask;
+    cv::Mat h;
+
+    BenchmarkRunner::DetectorConfig matchConfig = config;
+    std::vector<int> allSizes = windowSizes;
+    const bool lpFeatures = !makeLPDetector(config.detector, windowSizes, false).empty();
+
+    Timer timer;
+    auto timed = [&](double StitchingMetrics::* stage, const std::function<void()>& body) {
+        timer.start();
+        body();
+        timer.stop();
+        metrics.*stage += timer.elapsedSeconds();
+        metrics.escalationTime += timer.elapsedSeconds();
+    };
+
+    // Detects with detector on both images and appends the described keypoints not found before
+    auto addFeatures = [&](const cv::Ptr<cv::Feature2D>& detector) {
+        std::vector<cv::KeyPoint> new1, new2;
+        LPDetectionStats stats;
+        timed(&StitchingMetrics::detectionTimeReference, [&] { detectKeypoints(detector, gray1, new1, stats); });
+        timed(&StitchingMetrics::detectionTimeRegistered, [&] { detectKeypoints(detector, gray2, new2, stats); });
+        removeKnownKeypoints(k1, new1);
+        removeKnownKeypoints(k2, new2);
+
+        auto append = [&](const cv::Mat& gray, std::vector<cv::KeyPoint>& found, std::vector<cv::KeyPoint>& kpts,
+                          cv::Mat& desc, double StitchingMetrics::* stage) {
+            if (found.empty()) return;
+            cv::Mat foundDesc;
+            timed(stage, [&] { detector->compute(gray, found, foundDesc); });
+            if (foundDesc.empty()) return;
+            kpts.insert(kpts.end(), found.begin(), found.end());
+            if (desc.empty()) desc = foundDesc;
+            else cv::vconcat(desc, foundDesc, desc);
+        };
+        append(gray1, new1, k1, d1, &StitchingMetrics::descriptorTimeReference);
+        append(gray2, new2, k2, d2, &StitchingMetrics::descriptorTimeRegistered);
+    };
+
+    for (int level = 1; level < ESCALATION_LEVEL_COUNT && !deadline.expired(); ++level) {
+        switch (static_cast<EscalationLevel>(level)) {
+            case EscalationLevel::FinerScales: {
+                const std::vector<int> finer = finerWindowSizes(windowSizes);
+                const cv::Ptr<cv::Feature2D> detector = makeLPDetector(config.detector, finer, false);
+                if (finer.empty() || detector.empty()) continue;
+                addFeatures(detector);
+                allSizes.insert(allSizes.end(), finer.begin(), finer.end());
+                break;
+            }
+            case EscalationLevel::DenseStride: {
+                // The grid's keypoints are a subset of the dense ones; only the others are described
+                const cv::Ptr<cv::Feature2D> detector = makeLPDetector(config.detector, allSizes, true);
+                if (denseDetection || detector.empty()) continue;
+                addFeatures(detector);
+                break;
+            }
+            case EscalationLevel::Orientation: {
+                // Detection is kept; every keypoint is described again with its dominant orientation
+                if (!lpFeatures) continue;
+                timed(&StitchingMetrics::descriptorTimeReference, [&] {
+                    lp::assignOrientations(gray1, k1, ESCALATION_ORIENTATION_RADIUS);
+                    config.detector->compute(gray1, k1, d1);
+                });
+                timed(&StitchingMetrics::descriptorTimeRegistered, [&] {
+                    lp::assignOrientations(gray2, k2, ESCALATION_ORIENTATION_RADIUS);
+                    config.detector->compute(gray2, k2, d2);
+                });
+                break;
+            }
+            case EscalationLevel::SiftOverlap: {
+                // SIFT where the images are predicted to overlap; features already in SIFT's descriptor space
+                // (LP-SIFT, LP-DoG) are kept, the others are replaced since they cannot be matched with SIFT's
+                const cv::Ptr<cv::Feature2D> sift = cv::SIFT::create();
+                cv::Rect roi1, roi2;
+                timed(&StitchingMetrics::detectionTimeReference, [&] { predictOverlap(gray1, gray2, roi1, roi2); });
+
+                std::vector<cv::KeyPoint> new1, new2;
+                cv::Mat new1Desc, new2Desc;
+                auto detectIn = [&](const cv::Mat& gray, const cv::Rect& roi, std::vector<cv::KeyPoint>& found,
+                                    cv::Mat& foundDesc, double StitchingMetrics::* detectStage,
+                                    double StitchingMetrics::* describeStage) {
+                    cv::Mat roiMask = cv::Mat::zeros(gray.size(), CV_8U);
+                    roiMask(roi).setTo(255);
+                    timed(detectStage, [&] { sift->detect(gray, found, roiMask); });
+                    timed(describeStage, [&] { sift->compute(gray, found, foundDesc); });
+                };
+                detectIn(gray1, roi1, new1, new1Desc, &StitchingMetrics::detectionTimeReference,
+                         &StitchingMetrics::descriptorTimeReference);
+                detectIn(gray2, roi2, new2, new2Desc, &StitchingMetrics::detectionTimeRegistered,
+                         &StitchingMetrics::descriptorTimeRegistered);
+
+                auto siftSpace = [&sift](const cv::Mat& desc) {
+                    return desc.cols == sift->descriptorSize() && desc.type() == sift->descriptorType();
+                };
+                if (config.matcherNorm == cv::NORM_L2 && siftSpace(d1) && siftSpace(d2)) {
+                    k1.insert(k1.end(), new1.begin(), new1.end());
+                    k2.insert(k2.end(), new2.begin(), new2.end());
+                    if (!new1Desc.empty()) cv::vconcat(d1, new1Desc, d1);
+                    if (!new2Desc.empty()) cv::vconcat(d2, new2Desc, d2);
+                } else {
+                    k1 = std::move(new1);
+                    k2 = std::move(new2);
+                    d1 = new1Desc;
+                    d2 = new2Desc;
+                    matchConfig = {"SIFT", sift, cv::NORM_L2, MatcherType::FLANN};
+                }
+                break;
+            }
+            case EscalationLevel::None:
+                continue;
+        }
+        metrics.escalationLevelsTried.push_back(level);
+
+        if (d1.empty() || d2.empty()) continue;
+        timed(&StitchingMetrics::matchingTime, [&] {
+            BenchmarkRunner::matchDescriptors(matchConfig, d1, d2, m);
+        });
+        if (m.size() < MIN_MATCHES) continue;
+
+        timed(&StitchingMetrics::homographyTime, [&] {
+            std::vector<cv::Point2f> pts1, pts2;
+            m.appendPoints(k1, k2, pts1, pts2);
+            cv::setRNGSeed(RNG_SEED);
+            h = cv::findHomography(pts2, pts1, cv::RANSAC, RANSAC_THRESHOLD, mask);
+        });
+        const int inliers = h.empty() ? 0 : cv::countNonZero(mask);
+        if (isDegenerateHomography(h, gray2.size(), inliers)) continue;
+
+        metrics.escalationLevel = level;
+
+        // The finer scales get entries of their own (keypoints are all described), so their matches count
+        if (!metrics.windowSizeStats.empty()) {
+            for (const int windowSize : allSizes) {
+                if (findWindowSize(metrics.windowSizeStats, windowSize)) continue;
+                WindowSizeStats& entry = windowSizeEntry(metrics.windowSizeStats, windowSize);
+                for (const auto& kp : k1) entry.keypointsReference += kp.class_id == windowSize ? 1 : 0;
+                for (const auto& kp : k2) entry.keypointsRegistered += kp.class_id == windowSize ? 1 : 0;
+                entry.descriptorsReference = entry.keypointsReference;
+                entry.descriptorsRegistered = entry.keypointsRegistered;
+            }
+        }
+
+        kpts1 = std::move(k1);
+        kpts2 = std::move(k2);
+        desc1 = d1;
+        desc2 = d2;
+        matches = m;
+        inlierMask = std::move(mask);
+        H = h;
+        return true;
+    }
+
+    metrics.escalationLevel = -1;
+    return false;
+}
+
+// Matches desc1 (query) against desc2 (train) with the configured matcher
+// Throws if the brute-force matcher exceeds its size limit
+void BenchmarkRunner::matchDescriptors(const DetectorConfig& config,
+                                       const cv::Mat& desc1,
+                                       const cv::Mat& desc2,
+                                       KnnMatches& matches,
+                                       size_t* indexBytes,
+                                       const std::function<bool()>& proceed) {
+    matches.clear();
+    if (indexBytes) *indexBytes = 0;
+    if (desc1.empty() || desc2.empty()) return;
+
+    if (config.matcherType == MatcherType::FLANN) {
+        // FLANN index searched directly (what FlannBasedMatcher does internally), so the 2-NN results
+        // stay in two flat matrices instead of a std::vector<DMatch> per query keypoint
+        const cv::flann::SearchParams searchParams(50);
+        const HeapCounters beforeIndex = threadHeapCounters();
+
+        if (config.matcherNorm == cv::NORM_HAMMING || config.matcherNorm == cv::NORM_HAMMING2) {
+            // Binary descriptors (ORB, BRISK) - use LSH index
+            cv::flann::Index index(desc2, cv::flann::LshIndexParams(12, 20, 2), cvflann::FLANN_DIST_HAMMING);
+            if (indexBytes) *indexBytes = threadHeapCounters().bytes - beforeIndex.bytes;
+            if (proceed) {
+                matches.searchBatched(index, desc1, searchParams, BUDGET_MATCH_BATCH_ROWS, proceed);
+            } else {
+                matches.search(index, desc1, searchParams);
+            }
+        } else {
+            // Float descriptors (SIFT) - use KDTree index
+            cv::flann::Index index(desc2, cv::flann::KDTreeIndexParams(5), cvflann::FLANN_DIST_L2);
+            if (indexBytes) *indexBytes = threadHeapCounters().bytes - beforeIndex.bytes;
+            if (proceed) {
+                matches.searchBatched(index, desc1, searchParams, BUDGET_MATCH_BATCH_ROWS, proceed);
+            } else {
+                matches.search(index, desc1, searchParams);
+            }
+        }
+
+        // Apply Lowe's ratio test
+        matches.ratioTest(RATIO_TEST_THRESHOLD);
+    } else {
+        // BFMatcher - exact matching but limited to ~65k keypoints
+        cv::Ptr<cv::BFMatcher> matcher = cv::BFMatcher::create(config.matcherNorm);
+        std::vector<cv::DMatch> bfMatches;
+        matcher->match(desc1, desc2, bfMatches);
+        matches.assign(bfMatches);
+    }
+}
+
+// A time budget and the fallback ladder are implemented by the stage-by-stage pipeline only
+static bool forcesStageByStage(const BenchmarkRunner::Options& options) {
+    return options.budgetMs > 0.0 || options.escalate;
+}
+
+// Everything besides the image bytes that the SIFT baseline depends on (its baseline cache key)
+static std::string baselineSettings(const BenchmarkRunner::Options& options) {
+    std::ostringstream settings;
+    settings << "SIFT(0,3,0.04,10,1.6)" // cv::SIFT::create() defaults
+             << ";FLANN-KDTree(5,50);ratio=" << RATIO_TEST_THRESHOLD
+             << ";RANSAC(" << RANSAC_THRESHOLD << ",seed=" << RNG_SEED << ")"
+             << ";ingest=1/" << options.ingestReduction << (options.cameraFrames ? ",nv12" : "")
+             << ";opencv=" << CV_VERSION;
+
+    // The cached timings are reported as SIFT's measurements, so they must come from the same execution mode
+    if (options.throughputMode) {
+        settings << ";mode=throughput" << (options.pinThreads ? ",pinned" : "");
+    } else {
+        settings << ";mode=latency" << (options.concurrentStages ? ",concurrent-stages" : "")
+                 << (options.streamScales ? ",stream" : "");
+    }
+    settings << ";threads=" << options.threads
+             << ";runs=" << options.warmupRuns << "+" << options.repetitions;
+    return settings.str();
+}
+
+// Records the ingested image dimensions, grayscale decode times and sizes
+static void recordInputImages(StitchingMetrics& metrics,
+                              const IngestedImage& reference,
+                              const IngestedImage& registered) {
+    metrics.referenceWidth = reference.gray().cols;
+    metrics.referenceHeight = reference.gray().rows;
+    metrics.registeredWidth = registered.gray().cols;
+    metrics.registeredHeight = registered.gray().rows;
+    metrics.sizeCategory = getImageSizeCategory(metrics.referenceWidth, metrics.referenceHeight);
+
+    metrics.ingestTimeReference = reference.grayDecodeTime();
+    metrics.ingestTimeRegistered = registered.grayDecodeTime();
+    metrics.ingestBytesReference = reference.sourceBytes();
+    metrics.ingestBytesRegistered = registered.sourceBytes();
+}
+
+// Decodes the color images for the composite (once per dataset, shared by every detector)
+// Returns the seconds this call spent decoding or waiting for another run's decode
+static double decodeColor(const IngestedImage& reference, const IngestedImage& registered) {
+    Timer timer;
+    timer.start();
+    reference.color();
+    registered.color();
+    timer.stop();
+    return timer.elapsedSeconds();
+}
+
 // ============================================================================
 // CSVExporter Implementation
 // ============================================================================
@@ -64,12 +585,88 @@ void CSVExporter::writeHeader() {
          << "Homography Time (s),"
          << "Warping Time (s),"
          << "Total Stitching Time (s),"
+         << "Candidates (Reference),"
+         << "Candidates (Registered),"
+         << "Border-Rejected Fraction,"
+         << "Pruned Fraction,"
+         << "Prune Time (s),"
+         << "Est. Time Saved by Filtering (s),"
+         << "Scales Processed,"
+         << "Early Stop,"
+         << "Summed Stage Time (s),"
+         << "Stage Overlap (x),"
+         << "Ingest Time Ref (s),"
+         << "Ingest Time Reg (s),"
+         << "Ingest Memory Ref (MiB),"
+         << "Ingest Memory Reg (MiB),"
+         << "Load Wait (s),"
+         << "Color Decode Time (s),"
+         << "Mat Allocations,"
+         << "Mat Pool Reuses,"
+         << "Minor Page Faults,"
+         << "Major Page Faults,"
+         << "Mat Allocated (MiB),"
+         << "Heap Allocations,"
+         << "Heap Allocated (MiB),"
+         << "Peak RSS (MiB),"
+         << "Keypoint Memory Ref (KiB),"
+         << "Keypoint Memory Reg (KiB),"
+         << "Descriptor Memory Ref (KiB),"
+         << "Descriptor Memory Reg (KiB),"
+         << "Index Memory (KiB),"
+         << "Match Memory (KiB),"
+         << "Execution Mode,"
+         << "From Cache,"
          << "Homography Matrix,"
          << "Homography Difference from SIFT,"
          << "Homography L2 Norm,"
+         << "Corner Error (px),"
          << "Success,"
-         << "Failure Reason"
-         << "\n";
+         << "Failure Reason,"
+         << "Warm-up Runs,"
+         << "Repetitions,"
+         << "Budget (ms),"
+         << "Budget Used (%),"
+         << "Degradations,"
+         << "Escalation Level,"
+         << "Escalation Levels Tried,"
+         << "Escalation Time (s)";
+
+    // Repetition statistics per stage
+    for (const auto& stage : timedStages()) {
+        const std::string prefix = std::string(",") + stage.label;
+        file << prefix << " Median (ms)"
+             << prefix << " P90 (ms)"
+             << prefix << " P99 (ms)"
+             << prefix << " Min (ms)"
+             << prefix << " CI Low (ms)"
+             << prefix << " CI High (ms)";
+    }
+
+    // Hardware counters per stage (--perf-counters)
+    for (const auto& stage : timedStages()) {
+        const std::string prefix = std::string(",") + stage.label;
+        file << prefix << " IPC"
+             << prefix << " Cache Miss Rate"
+             << prefix << " Branch MPKI"
+             << prefix << " CPU Time (ms)";
+    }
+
+    // Memory per stage
+    for (const auto& stage : timedStages()) {
+        const std::string prefix = std::string(",") + stage.label;
+        file << prefix << " Peak RSS (MiB)"
+             << prefix << " Heap Allocations"
+             << prefix << " Heap Allocated (KiB)"
+             << prefix << " Mat Allocations"
+             << prefix << " Mat Allocated (KiB)";
+    }
+
+    // Share of the time budget per stage (--budget)
+    for (const auto& stage : timedStages()) {
+        file << "," << stage.label << " Budget Used (%)";
+    }
+    file << "\n";
 
     file.close();
 }
@@ -131,13 +728,87 @@ void CSVExporter::writeMetrics(const StitchingMetrics& m) {
         StitchingMetrics::formatTime(m.homographyTime),
         StitchingMetrics::formatTime(m.warpingTime),
         StitchingMetrics::formatTime(m.totalStitchingTime),
+        m.numCandidatesReference,
+        m.numCandidatesRegistered,
+        m.getBorderRejectedFraction(),
+        m.getPrunedFraction(),
+        StitchingMetrics::formatTime(m.pruneTime),
+        StitchingMetrics::formatTime(m.estimatedPruneTimeSaved),
+        (m.scalesTotal > 0 ? std::to_string(m.scalesProcessed) + "/" + std::to_string(m.scalesTotal) : "x"),
+        (m.scalesTotal > 0 ? (m.earlyStopped ? "Yes" : "No") : "x"),
+        StitchingMetrics::formatTime(m.getSummedStageTime()),
+        StitchingMetrics::formatTime(m.getStageOverlap()),
+        StitchingMetrics::formatTime(m.ingestTimeReference),
+        StitchingMetrics::formatTime(m.ingestTimeRegistered),
+        formatBytes(m.ingestBytesReference, MIB),
+        formatBytes(m.ingestBytesRegistered, MIB),
+        StitchingMetrics::formatTime(m.loadWaitTime),
+        StitchingMetrics::formatTime(m.colorDecodeTime),
+        m.matAllocations,
+        (m.matPooledAllocations > 0 ? std::to_string(m.matReusedAllocations) + "/" + std::to_string(m.matPooledAllocations) : "x"),
+        (m.minorPageFaults >= 0 ? std::to_string(m.minorPageFaults) : "x"),
+        (m.majorPageFaults >= 0 ? std::to_string(m.majorPageFaults) : "x"),
+        formatBytes(m.matAllocatedBytes, MIB),
+        formatHeapCount(m.heapAllocations),
+        formatHeapBytes(m.heapBytes, MIB),
+        (m.peakRssKiB >= 0 ? formatBytes(m.peakRssKiB * KIB, MIB) : "x"),
+        formatBytes(m.keypointBytesReference, KIB),
+        formatBytes(m.keypointBytesRegistered, KIB),
+        formatBytes(m.descriptorBytesReference, KIB),
+        formatBytes(m.descriptorBytesRegistered, KIB),
+        formatHeapBytes(m.indexBytes, KIB),
+        formatBytes(m.matchBytes, KIB),
+        m.executionMode,
+        (m.fromCache ? "Yes" : "No"),
         m.printHomography(m.homography),
         m.printHomography(m.homography - m.baselineH),
 		cv::norm(m.homography - m.baselineH, cv::NORM_L2),
+        (m.cornerError >= 0.0 ? StitchingMetrics::formatTime(m.cornerError) : "x"),
         (m.stitchingSuccess ? "Yes" : "No"),
-        m.failureReason
+        m.failureReason,
+        m.warmupRuns,
+        m.repetitions,
+        (m.budgetSeconds > 0.0 ? formatRatio(m.budgetSeconds * 1000.0, 3) : "x"),
+        formatRatio(m.getBudgetShare(m.totalStitchingTime) * 100.0, 1),
+        (m.budgetSeconds > 0.0 ? (m.degradations.empty() ? "None" : m.degradations) : "x"),
+        (m.escalationLevelsTried.empty() ? "x" : std::to_string(m.escalationLevel)),
+        (m.escalationLevelsTried.empty() ? "x" : joinInts(m.escalationLevelsTried)),
+        (m.escalationLevelsTried.empty() ? "x" : StitchingMetrics::formatTime(m.escalationTime))
     );
 
+    for (size_t i = 0; i < timedStages().size(); ++i) {
+        if (i < m.stageStats.size()) {
+            const TimingStats& s = m.stageStats[i];
+            csvRow += "," + makeCsvRow(formatMs(s.medianNs), formatMs(s.p90Ns), formatMs(s.p99Ns),
+                                       formatMs(s.minNs), formatMs(s.ciLowNs), formatMs(s.ciHighNs));
+        } else {
+            csvRow += "," + makeCsvRow("x", "x", "x", "x", "x", "x");
+        }
+    }
+
+    for (size_t i = 0; i < timedStages().size(); ++i) {
+        const PerfSample c = i < m.stageCounters.size() ? m.stageCounters[i] : PerfSample{};
+        csvRow += "," + makeCsvRow(formatRatio(c.ipc(), 3), formatRatio(c.cacheMissRate(), 4),
+                                   formatRatio(c.branchMpki(), 3),
+                                   c.threadCpuNs >= 0 ? formatMs(c.threadCpuNs) : "x");
+    }
+
+    for (size_t i = 0; i < timedStages().size(); ++i) {
+        if (i < m.stageMemory.size()) {
+            const StageMemory& s = m.stageMemory[i];
+            csvRow += "," + makeCsvRow(
+                s.peakRssKiB >= 0 ? formatBytes(s.peakRssKiB * KIB, MIB) : "x",
+                formatHeapCount(s.heapAllocations), formatHeapBytes(s.heapBytes, KIB),
+                s.matAllocations, formatBytes(s.matBytes, KIB));
+        } else {
+            csvRow += "," + makeCsvRow("x", "x", "x", "x", "x");
+        }
+    }
+
+    for (const auto& stage : timedStages()) {
+        csvRow += "," + makeCsvRow(formatRatio(m.getBudgetShare(m.*(stage.seconds)) * 100.0, 1));
+    }
+
     file << csvRow << "\n";
 
     file.close();
@@ -166,6 +837,168 @@ void CSVExporter::writeAllMetrics(const std::vector<StitchingMetrics>& metrics)
     }
 
     cout << "\nResults saved to: " << filename_ << endl;
+    writeWindowSizeMetrics(metrics);
+}
+
+void CSVExporter::writeWindowSizeMetrics(const std::vector<StitchingMetrics>& metrics) {
+    const bool any = std::any_of(metrics.begin(), metrics.end(),
+                                 [](const StitchingMetrics& m) { return !m.windowSizeStats.empty(); });
+    if (!any) return;
+
+    // results_N.csv -> results_N_windows.csv
+    const size_t dot = filename_.rfind('.');
+    const std::string path = filename_.substr(0, dot) + "_windows" +
+                             (dot == std::string::npos ? ".csv" : filename_.substr(dot));
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << path << " for writing." << std::endl;
+        return;
+    }
+
+    file << makeCsvRow("Dataset", "Algorithm", "Window Size (L)", "Window", "Success",
+                       "Keypoints Reference", "Keypoints Registered",
+                       "Descriptors Reference", "Descriptors Registered",
+                       "Matches", "Inliers", "Inlier Share (%)",
+                       "Detection Time Reference (ms)", "Detection Time Registered (ms)",
+                       "Detection Time Share (%)", "Inliers per Detection ms") << "\n";
+
+    for (const auto& m : metrics) {
+        int inliers = 0;
+        double detectionTime = 0.0;
+        bool timed = false;
+        for (const auto& w : m.windowSizeStats) {
+            inliers += w.inliers;
+            detectionTime += w.detectionTime();
+            timed = timed || w.detectionTimeReference >= 0.0 || w.detectionTimeRegistered >= 0.0;
+        }
+
+        for (const auto& w : m.windowSizeStats) {
+            file << makeCsvRow(
+                m.datasetName, m.algorithmName, m.windowSizes, w.windowSize, (m.stitchingSuccess ? "Yes" : "No"),
+                w.keypointsReference, w.keypointsRegistered,
+                w.descriptorsReference, w.descriptorsRegistered,
+                w.matches, w.inliers,
+                (inliers > 0 ? formatRatio(100.0 * w.inliers / inliers, 2) : "x"),
+                formatRatio(w.detectionTimeReference * 1000.0, 3), formatRatio(w.detectionTimeRegistered * 1000.0, 3),
+                (timed && detectionTime > 0.0 ? formatRatio(100.0 * w.detectionTime() / detectionTime, 2) : "x"),
+                (timed && w.detectionTime() > 0.0 ? formatRatio(w.inliers / (w.detectionTime() * 1000.0), 3) : "x")
+            ) << "\n";
+        }
+    }
+
+    cout << "Window size breakdown saved to: " << path << endl;
+}
+
+// ============================================================================
+// JSONExporter Implementation
+// ============================================================================
+
+namespace {
+
+std::string escapeJson(const std::string& s) {
+    std::ostringstream r;
+    for (const char c : s) {
+        switch (c) {
+            case '"': r << "\\\""; break;
+            case '\\': r << "\\\\"; break;
+            case '\n': r << "\\n"; break;
+            case '\t': r << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    r << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec;
+                } else {
+                    r << c;
+                }
+        }
+    }
+    return r.str();
+}
+
+} // anonymous namespace
+
+void JSONExporter::writeAllMetrics(const std::vector<StitchingMetrics>& metrics) {
+    std::ofstream file(filename_, std::ios::out | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << filename_ << " for writing." << std::endl;
+        return;
+    }
+
+    file << "{\n  \"confidence\": " << BOOTSTRAP_CONFIDENCE
+         << ",\n  \"bootstrap_resamples\": " << BOOTSTRAP_RESAMPLES
+         << ",\n  \"results\": [";
+
+    for (size_t r = 0; r < metrics.size(); ++r) {
+        const StitchingMetrics& m = metrics[r];
+        file << (r ? "," : "") << "\n    {"
+             << "\"dataset\": \"" << escapeJson(m.datasetName) << "\", "
+             << "\"algorithm\": \"" << escapeJson(m.algorithmName) << "\", "
+             << "\"window_sizes\": \"" << escapeJson(m.windowSizes) << "\", "
+             << "\"execution_mode\": \"" << escapeJson(m.executionMode) << "\", "
+             << "\"success\": " << (m.stitchingSuccess ? "true" : "false") << ", "
+             << "\"from_cache\": " << (m.fromCache ? "true" : "false") << ", "
+             << "\"keypoints_reference\": " << m.numKeypointsReference << ", "
+             << "\"keypoints_registered\": " << m.numKeypointsRegistered << ", "
+             << "\"matches\": " << m.numMatches << ", "
+             << "\"inliers\": " << m.numInliers << ", "
+             << "\"corner_error_px\": " << (m.cornerError >= 0.0 ? std::to_string(m.cornerError) : "null") << ", "
+             << "\"warmup_runs\": " << m.warmupRuns << ", "
+             << "\"repetitions\": " << m.repetitions << ",\n";
+
+        if (!m.escalationLevelsTried.empty()) {
+            file << "     \"escalation_level\": " << m.escalationLevel
+                 << ", \"escalation_levels_tried\": [" << joinInts(m.escalationLevelsTried) << "]"
+                 << ", \"escalation_ns\": " << std::llround(m.escalationTime * 1e9) << ",\n";
+        }
+
+        if (m.budgetSeconds > 0.0) {
+            file << "     \"budget_ms\": " << m.budgetSeconds * 1000.0
+                 << ", \"degradations\": \"" << escapeJson(m.degradations) << "\", \"budget_used\": {";
+            for (size_t i = 0; i < timedStages().size(); ++i) {
+                file << (i ? ", " : "") << "\"" << timedStages()[i].key << "\": "
+                     << m.getBudgetShare(m.*(timedStages()[i].seconds));
+            }
+            file << "},\n";
+        }
+
+        if (!m.windowSizeStats.empty()) {
+            file << "     \"window_size_breakdown\": [";
+            for (size_t i = 0; i < m.windowSizeStats.size(); ++i) {
+                const WindowSizeStats& w = m.windowSizeStats[i];
+                file << (i ? "," : "") << "\n       {"
+                     << "\"window_size\": " << w.windowSize << ", "
+                     << "\"keypoints_reference\": " << w.keypointsReference << ", "
+                     << "\"keypoints_registered\": " << w.keypointsRegistered << ", "
+                     << "\"descriptors_reference\": " << w.descriptorsReference << ", "
+                     << "\"descriptors_registered\": " << w.descriptorsRegistered << ", "
+                     << "\"matches\": " << w.matches << ", "
+                     << "\"inliers\": " << w.inliers << ", "
+                     << "\"detection_ns_reference\": "
+                     << (w.detectionTimeReference >= 0.0 ? std::to_string(std::llround(w.detectionTimeReference * 1e9)) : "null")
+                     << ", \"detection_ns_registered\": "
+                     << (w.detectionTimeRegistered >= 0.0 ? std::to_string(std::llround(w.detectionTimeRegistered * 1e9)) : "null")
+                     << "}";
+            }
+            file << "\n     ],\n";
+        }
+
+        file << "     \"stages_ns\": {";
+
+        for (size_t i = 0; i < m.stageStats.size() && i < timedStages().size(); ++i) {
+            const TimingStats& s = m.stageStats[i];
+            file << (i ? "," : "") << "\n       \"" << timedStages()[i].key << "\": {"
+                 << "\"samples\": " << s.samples << ", "
+                 << "\"min\": " << s.minNs << ", "
+                 << "\"median\": " << s.medianNs << ", "
+                 << "\"p90\": " << s.p90Ns << ", "
+                 << "\"p99\": " << s.p99Ns << ", "
+                 << "\"ci_low\": " << s.ciLowNs << ", "
+                 << "\"ci_high\": " << s.ciHighNs << "}";
+        }
+        file << (m.stageStats.empty() ? "}" : "\n     }") << "}";
+    }
+    file << "\n  ]\n}\n";
+
+    cout << "Statistics saved to: " << filename_ << endl;
 }
 
 // ============================================================================
@@ -219,10 +1052,97 @@ string joinInts(const vector<int>& v) {
     return oss.str();
 }
 
+namespace {
+
+// Stage timer for runSingleBenchmark. Also records each stage's memory (heap and Mat allocations, and the
+// RSS high-water mark when sampled), its hardware counters when given, and a trace span. They are read
+// outside the timed interval and stored at the stage's timedStages() index, and added to the total entry
+class StageMeter {
+public:
+    StageMeter(StitchingMetrics& metrics, PerfCounters* counters, const bool sampleRss)
+        : metrics_(metrics), counters_(counters), sampleRss_(sampleRss) {
+        metrics_.stageMemory.assign(timedStages().size(), StageMemory{});
+        if (!counters_) return;
+        metrics_.stageCounters.assign(timedStages().size(), PerfSample{});
+        metrics_.stageCounters.back() = PerfSample{0, 0, 0, 0, 0, 0};
+    }
+
+    // A stage still running when the stitch returns early or throws ends here
+    ~StageMeter() { stop(); }
+
+    StageMeter(const StageMeter&) = delete;
+    StageMeter& operator=(const StageMeter&) = delete;
+
+    // Starts timing the stage whose time goes to the given metrics field
+    void start(double StitchingMetrics::* seconds) {
+        seconds_ = seconds;
+        rssReset_ = sampleRss_ && resetPeakRss();
+        heapStart_ = threadHeapCounters();
+        matScope_ = MatPoolScope::current();
+        matStartAllocations_ = matScope_ ? matScope_->allocations() : 0;
+        matStartBytes_ = matScope_ ? matScope_->allocatedBytes() : 0;
+        span_.begin(timedStages()[stageIndex(seconds)].key);
+        if (counters_) counters_->start();
+        timer_.start();
+    }
+
+    // Ends the running stage; no-op if none is running
+    void stop() {
+        if (!seconds_) return;
+        timer_.stop();
+        metrics_.*seconds_ = timer_.elapsedSeconds();
+        const size_t index = stageIndex(seconds_);
+
+        if (counters_) {
+            const PerfSample sample = counters_->stop();
+            metrics_.stageCounters[index] = sample;
+            metrics_.stageCounters.back() += sample;
+        }
+
+        const HeapCounters heap = threadHeapCounters();
+        StageMemory memory;
+        memory.heapAllocations = heap.allocations - heapStart_.allocations;
+        memory.heapBytes = heap.bytes - heapStart_.bytes;
+        if (matScope_) {
+            memory.matAllocations = matScope_->allocations() - matStartAllocations_;
+            memory.matBytes = matScope_->allocatedBytes() - matStartBytes_;
+        }
+        span_.end();
+        if (rssReset_) memory.peakRssKiB = readPeakRssKiB();
+
+        metrics_.stageMemory[index] = memory;
+        metrics_.stageMemory.back() += memory;
+        seconds_ = nullptr;
+    }
+
+private:
+    static size_t stageIndex(double StitchingMetrics::* seconds) {
+        const auto& stages = timedStages();
+        for (size_t i = 0; i + 1 < stages.size(); ++i) {
+            if (stages[i].seconds == seconds) return i;
+        }
+        return stages.size() - 1;
+    }
+
+    StitchingMetrics& metrics_;
+    PerfCounters* counters_;
+    bool sampleRss_;
+    bool rssReset_ = false;
+    HeapCounters heapStart_;
+    MatPoolScope* matScope_ = nullptr;
+    size_t matStartAllocations_ = 0;
+    size_t matStartBytes_ = 0;
+    double StitchingMetrics::* seconds_ = nullptr;
+    Timer timer_;
+    trace::Span span_;
+};
+
+} // anonymous namespace
+
 StitchingMetrics BenchmarkRunner::runSingleBenchmark(
     const std::string& datasetName,
-    const cv::Mat& referenceImg,
-    const cv::Mat& registeredImg,
+    const IngestedImage& referenceImg,
+    const IngestedImage& registeredImg,
     const DetectorConfig& config,
 	const vector<int>& lpsiftWindowSizes,
     const std::string& outputPath
@@ -232,45 +1152,88 @@ StitchingMetrics BenchmarkRunner::runSingleBenchmark(
     metrics.algorithmName = config.name;
 
     // Only set window sizes for LP-SIFT algorithm, use "x" for others
-    if (config.name == "LP-SIFT" || config.name == "LP-ORB") {
+    if (config.name == "LP-SIFT" || config.name == "LP-ORB" || config.name == "LP-DoG") {
         metrics.windowSizes = joinInts(lpsiftWindowSizes);
+        if (options_.denseDetection && config.name != "LP-DoG") {
+            metrics.windowSizes += "@L/2"; // dense windows at stride L/2
+        }
     } else {
         metrics.windowSizes = "x";
     }
 
-    // Record image dimensions
-    metrics.referenceWidth = referenceImg.cols;
-    metrics.referenceHeight = referenceImg.rows;
-    metrics.registeredWidth = registeredImg.cols;
-    metrics.registeredHeight = registeredImg.rows;
-    metrics.sizeCategory = getImageSizeCategory(referenceImg.cols, referenceImg.rows);
+    recordInputImages(metrics, referenceImg, registeredImg);
+    initWindowSizeStats(metrics, lpsiftWindowSizes);
+    const trace::ContextScope traceContext(datasetName, config.name, metrics.windowSizes);
 
-    Timer totalTimer, stepTimer;
+    std::unique_ptr<PerfCounters> counters;
+    if (options_.perfCounters) counters = std::make_unique<PerfCounters>();
+
+    // --budget: SIFT always runs in full, it provides the reference homography of the other detectors
+    const bool budgeted = options_.budgetMs > 0.0 && config.name != "SIFT";
+    const bool escalating = options_.escalate &&
+                            (config.name == "LP-SIFT" || config.name == "LP-ORB" || config.name == "LP-DoG");
+    metrics.budgetSeconds = budgeted ? options_.budgetMs / 1000.0 : 0.0;
+
+    Timer totalTimer;
+    StageMeter stepTimer(metrics, counters.get(), options_.memStats && !options_.throughputMode);
+    Deadline deadline(metrics.budgetSeconds);
     totalTimer.start();
 
+    // Outside the try: saved once the stitch is done
+    std::vector<cv::KeyPoint> kpts1, kpts2;
+    cv::Mat desc1, desc2;
+
     try {
-        // Convert to grayscale
-        cv::Mat gray1, gray2;
-        cv::cvtColor(referenceImg, gray1, cv::COLOR_BGR2GRAY);
-        cv::cvtColor(registeredImg, gray2, cv::COLOR_BGR2GRAY);
+        // Images are ingested as grayscale
+        const cv::Mat& gray1 = referenceImg.gray();
+        const cv::Mat& gray2 = registeredImg.gray();
 
         // Feature detection - Reference image
-        std::vector<cv::KeyPoint> kpts1, kpts2;
-        cv::Mat desc1, desc2;
 
-        stepTimer.start();
-        config.detector->detect(gray1, kpts1);
+        LPDetectionStats stats1, stats2;
+        const int totalScales = static_cast<int>(lpsiftWindowSizes.size());
+        int scales1 = -1, scales2 = -1; // LP scales detected within the budget
+
+        stepTimer.start(&StitchingMetrics::detectionTimeReference);
+        if (budgeted) {
+            scales1 = detectKeypointsWithin(config.detector, gray1, kpts1, stats1, deadline,
+                                            BUDGET_DETECT_SHARE / 2.0, totalScales);
+        } else {
+            detectKeypoints(config.detector, gray1, kpts1, stats1);
+        }
         stepTimer.stop();
-        metrics.detectionTimeReference = stepTimer.elapsedSeconds();
         metrics.numKeypointsReference = static_cast<int>(kpts1.size());
 
-        // Feature detection - Registered image
-        stepTimer.start();
-        config.detector->detect(gray2, kpts2);
+        // Feature detection - Registered image (no more scales than the reference got)
+        stepTimer.start(&StitchingMetrics::detectionTimeRegistered);
+        if (budgeted) {
+            scales2 = detectKeypointsWithin(config.detector, gray2, kpts2, stats2, deadline,
+                                            BUDGET_DETECT_SHARE, scales1 > 0 ? scales1 : totalScales);
+        } else {
+            detectKeypoints(config.detector, gray2, kpts2, stats2);
+        }
         stepTimer.stop();
-        metrics.detectionTimeRegistered = stepTimer.elapsedSeconds();
         metrics.numKeypointsRegistered = static_cast<int>(kpts2.size());
 
+        if (scales1 >= 0 && (scales1 < totalScales || scales2 < totalScales)) {
+            addDegradation(metrics, "scales " + std::to_string(scales1) + "/" + std::to_string(totalScales) +
+                                    " reference, " + std::to_string(scales2) + "/" + std::to_string(totalScales) +
+                                    " registered");
+        }
+
+        metrics.numCandidatesReference = static_cast<int>(stats1.candidates);
+        metrics.numCandidatesRegistered = static_cast<int>(stats2.candidates);
+        metrics.numBorderRejectedReference = static_cast<int>(stats1.borderRejected);
+        metrics.numBorderRejectedRegistered = static_cast<int>(stats2.borderRejected);
+        metrics.numPrunedReference = static_cast<int>(stats1.pruned);
+        metrics.numPrunedRegistered = static_cast<int>(stats2.pruned);
+        metrics.pruneTime = stats1.pruneSeconds + stats2.pruneSeconds;
+
+        countByWindowSize(metrics.windowSizeStats, kpts1, &WindowSizeStats::keypointsReference);
+        countByWindowSize(metrics.windowSizeStats, kpts2, &WindowSizeStats::keypointsRegistered);
+        addWindowSizeTimes(metrics.windowSizeStats, stats1, &WindowSizeStats::detectionTimeReference);
+        addWindowSizeTimes(metrics.windowSizeStats, stats2, &WindowSizeStats::detectionTimeRegistered);
+
         // Check for empty keypoints
         if (kpts1.empty() || kpts2.empty()) {
             metrics.stitchingSuccess = false;
@@ -290,20 +1253,24 @@ StitchingMetrics BenchmarkRunner::runSingleBenchmark(
         }
 
         // Descriptor computation - Reference image
-        stepTimer.start();
+        stepTimer.start(&StitchingMetrics::descriptorTimeReference);
         config.detector->compute(gray1, kpts1, desc1);
         stepTimer.stop();
-        metrics.descriptorTimeReference = stepTimer.elapsedSeconds();
 
         // Descriptor computation - Registered image
-        stepTimer.start();
+        stepTimer.start(&StitchingMetrics::descriptorTimeRegistered);
         config.detector->compute(gray2, kpts2, desc2);
         stepTimer.stop();
-        metrics.descriptorTimeRegistered = stepTimer.elapsedSeconds();
 
         // Update keypoint counts after potential filtering during compute
         metrics.numKeypointsReference = static_cast<int>(kpts1.size());
         metrics.numKeypointsRegistered = static_cast<int>(kpts2.size());
+        metrics.keypointBytesReference = kpts1.capacity() * sizeof(cv::KeyPoint);
+        metrics.keypointBytesRegistered = kpts2.capacity() * sizeof(cv::KeyPoint);
+        metrics.descriptorBytesReference = desc1.total() * desc1.elemSize();
+        metrics.descriptorBytesRegistered = desc2.total() * desc2.elemSize();
+        countByWindowSize(metrics.windowSizeStats, kpts1, &WindowSizeStats::descriptorsReference);
+        countByWindowSize(metrics.windowSizeStats, kpts2, &WindowSizeStats::descriptorsRegistered);
 
         // Check for empty descriptors
         if (desc1.empty() || desc2.empty()) {
@@ -315,54 +1282,82 @@ StitchingMetrics BenchmarkRunner::runSingleBenchmark(
         }
 
         // Feature matching
-        stepTimer.start();
-        std::vector<cv::DMatch> matches;
-
-        if (config.matcherType == MatcherType::FLANN) {
-            // FLANN matcher - can handle unlimited keypoints
-            cv::Ptr<cv::DescriptorMatcher> matcher;
-
-            if (config.matcherNorm == cv::NORM_HAMMING || config.matcherNorm == cv::NORM_HAMMING2) {
-                // Binary descriptors (ORB, BRISK) - use LSH index
-                cv::Ptr<cv::flann::IndexParams> indexParams = cv::makePtr<cv::flann::LshIndexParams>(12, 20, 2);
-                cv::Ptr<cv::flann::SearchParams> searchParams = cv::makePtr<cv::flann::SearchParams>(50);
-                matcher = cv::makePtr<cv::FlannBasedMatcher>(indexParams, searchParams);
-            } else {
-                // Float descriptors (SIFT) - use KDTree index
-                cv::Ptr<cv::flann::IndexParams> indexParams = cv::makePtr<cv::flann::KDTreeIndexParams>(5);
-                cv::Ptr<cv::flann::SearchParams> searchParams = cv::makePtr<cv::flann::SearchParams>(50);
-                matcher = cv::makePtr<cv::FlannBasedMatcher>(indexParams, searchParams);
-            }
+        // Budgeted: query batches are searched while matching is within its share
+        int searchedBatches = 1;
+        std::function<bool()> proceed;
+        if (budgeted) {
+            proceed = [&deadline, &searchedBatches] {
+                if (deadline.pastShare(BUDGET_MATCH_SHARE)) return false;
+                ++searchedBatches;
+                return true;
+            };
+        }
 
-            // Use knnMatch with ratio test for better quality matches
-            std::vector<std::vector<cv::DMatch>> knnMatches;
-            matcher->knnMatch(desc1, desc2, knnMatches, 2);
+        stepTimer.start(&StitchingMetrics::matchingTime);
+        KnnMatches matches;
+
+        try {
+            matchDescriptors(config, desc1, desc2, matches, &metrics.indexBytes, proceed);
+        }
+        catch (exception& e) {
+            if (config.matcherType != MatcherType::BRUTE_FORCE) throw;
 
-            // Apply Lowe's ratio test
-            const float ratioThresh = 0.75f;
-            for (const auto& knn : knnMatches) {
-                if (knn.size() >= 2 && knn[0].distance < ratioThresh * knn[1].distance) {
-                    matches.push_back(knn[0]);
-                }
-            }
-        } else {
             // BFMatcher - exact matching but limited to ~65k keypoints
-            cv::Ptr<cv::BFMatcher> matcher = cv::BFMatcher::create(config.matcherNorm);
-            try {
-                matcher->match(desc1, desc2, matches);
-            }
-            catch (exception& e) {
-                metrics.stitchingSuccess = false;
-                metrics.failureReason = std::string("Over size");
-                totalTimer.stop();
-                metrics.totalStitchingTime = totalTimer.elapsedSeconds();
-                return metrics;
-            }
+            stepTimer.stop();
+            metrics.stitchingSuccess = false;
+            metrics.failureReason = std::string("Over size");
+            totalTimer.stop();
+            metrics.totalStitchingTime = totalTimer.elapsedSeconds();
+            return metrics;
         }
-        
+
         stepTimer.stop();
-        metrics.matchingTime = stepTimer.elapsedSeconds();
         metrics.numMatches = static_cast<int>(matches.size());
+        metrics.matchBytes = matches.bytes();
+
+        const int searchedRows = std::min(desc1.rows, searchedBatches * BUDGET_MATCH_BATCH_ROWS);
+        if (budgeted && config.matcherType == MatcherType::FLANN && searchedRows < desc1.rows) {
+            addDegradation(metrics, "matched " + std::to_string(searchedRows) + "/" + std::to_string(desc1.rows) +
+                                    " reference descriptors");
+        }
+
+        std::vector<uchar> inlierMask;
+        cv::Mat H;
+        if (matches.size() >= MIN_MATCHES) {
+            // Extract matched points
+            std::vector<cv::Point2f> pts1, pts2;
+            matches.appendPoints(kpts1, kpts2, pts1, pts2);
+
+            // RANSAC homography estimation, capped once matching ran past its share of the budget
+            const bool capRansac = budgeted && deadline.pastShare(BUDGET_MATCH_SHARE);
+            stepTimer.start(&StitchingMetrics::homographyTime);
+            cv::setRNGSeed(RNG_SEED);
+            H = capRansac
+                ? cv::findHomography(pts2, pts1, cv::RANSAC, RANSAC_THRESHOLD, inlierMask,
+                                     BUDGET_RANSAC_ITERATIONS, BUDGET_RANSAC_CONFIDENCE)
+                : cv::findHomography(pts2, pts1, cv::RANSAC, RANSAC_THRESHOLD, inlierMask);
+            stepTimer.stop();
+            if (capRansac) {
+                addDegradation(metrics, "RANSAC capped at " + std::to_string(BUDGET_RANSAC_ITERATIONS) + " iterations");
+            }
+
+            // Count inliers
+            metrics.numInliers = cv::countNonZero(inlierMask);
+        }
+
+        // --escalate: retry a failed or degenerate LP registration with progressively costlier features
+        if (escalating && isDegenerateHomography(H, gray2.size(), metrics.numInliers) &&
+            escalateRegistration(config, gray1, gray2, lpsiftWindowSizes, options_.denseDetection, deadline,
+                                 kpts1, kpts2, desc1, desc2, matches, inlierMask, H, metrics)) {
+            metrics.numKeypointsReference = static_cast<int>(kpts1.size());
+            metrics.numKeypointsRegistered = static_cast<int>(kpts2.size());
+            metrics.numMatches = static_cast<int>(matches.size());
+            metrics.numInliers = cv::countNonZero(inlierMask);
+            for (auto& entry : metrics.windowSizeStats) {
+                entry.matches = entry.inliers = 0;
+            }
+        }
+        countMatchesByWindowSize(metrics.windowSizeStats, matches, kpts1, inlierMask);
 
         // Check for sufficient matches
         if (matches.size() < MIN_MATCHES) {
@@ -373,24 +1368,6 @@ StitchingMetrics BenchmarkRunner::runSingleBenchmark(
             return metrics;
         }
 
-        // Extract matched points
-        std::vector<cv::Point2f> pts1, pts2;
-        for (const auto& m : matches) {
-            pts1.push_back(kpts1[m.queryIdx].pt);
-            pts2.push_back(kpts2[m.trainIdx].pt);
-        }
-
-        // RANSAC homography estimation
-        stepTimer.start();
-        cv::setRNGSeed(RNG_SEED);
-        std::vector<uchar> inlierMask;
-        cv::Mat H = cv::findHomography(pts2, pts1, cv::RANSAC, RANSAC_THRESHOLD, inlierMask);
-        stepTimer.stop();
-        metrics.homographyTime = stepTimer.elapsedSeconds();
-
-        // Count inliers
-        metrics.numInliers = cv::countNonZero(inlierMask);
-
         // Check for valid homography
         if (H.empty()) {
             metrics.stitchingSuccess = false;
@@ -400,65 +1377,508 @@ StitchingMetrics BenchmarkRunner::runSingleBenchmark(
             return metrics;
         }
 
-        // Image warping and blending
-        stepTimer.start();
-        cv::Mat stitched = warpAndBlend(registeredImg, referenceImg, H);
+        // Color is only needed for the composite; its decode is ingest, not stitching
+        metrics.colorDecodeTime = decodeColor(referenceImg, registeredImg);
+        deadline.discount(metrics.colorDecodeTime);
+
+        // Image warping and blending; budgeted, at 1/2 resolution past the homography share, 1/4 once expired
+        const double warpScale = !budgeted ? 1.0 : deadline.expired() ? 0.25
+                               : deadline.pastShare(BUDGET_HOMOGRAPHY_SHARE) ? 0.5 : 1.0;
+        stepTimer.start(&StitchingMetrics::warpingTime);
+        cv::Mat stitched = warpScale < 1.0
+            ? warpAndBlendAtScale(registeredImg.color(), referenceImg.color(), H, warpScale)
+            : warpAndBlend(registeredImg.color(), referenceImg.color(), H);
         stepTimer.stop();
-        metrics.warpingTime = stepTimer.elapsedSeconds();
+        if (warpScale < 1.0) {
+            addDegradation(metrics, std::string("warp at ") + (warpScale < 0.5 ? "1/4" : "1/2") + " resolution");
+        }
 
         totalTimer.stop();
-        metrics.totalStitchingTime = totalTimer.elapsedSeconds();
+        metrics.totalStitchingTime = totalTimer.elapsedSeconds() - metrics.colorDecodeTime;
         metrics.stitchingSuccess = true;
+        metrics.estimatePruneSavings();
 
         metrics.homography = cv::Mat(H);
 
-        if (config.name == "SIFT") {
-            this->baselineH = cv::Mat(H);
-        }
-
-        metrics.baselineH = this->baselineH;
-
         // Save stitched image if requested
-        if (!outputPath.empty()) {
+        if (!outputPath.empty() && writeRunOutputs) {
             std::string outFile = outputPath + "/" + datasetName + "_" + config.name + "_stitched.jpg";
             cv::imwrite(outFile, stitched);
         }
-
     } catch (const std::exception& e) {
+        stepTimer.stop(); // close the stage that threw before metrics is filled in and returned
         metrics.stitchingSuccess = false;
         metrics.failureReason = std::string("Exception: ") + e.what();
         totalTimer.stop();
-        metrics.totalStitchingTime = totalTimer.elapsedSeconds();
+        metrics.totalStitchingTime = totalTimer.elapsedSeconds() - metrics.colorDecodeTime;
+    }
+
+    // A feature file error does not fail a finished stitch
+    if (metrics.stitchingSuccess) {
+        saveFeatures(datasetName, config, "reference", kpts1, desc1);
+        saveFeatures(datasetName, config, "registered", kpts2, desc2);
     }
 
     return metrics;
 }
 
-std::vector<StitchingMetrics> BenchmarkRunner::runAllDetectors(
+StitchingMetrics BenchmarkRunner::runConcurrentBenchmark(
     const std::string& datasetName,
-    const cv::Mat& referenceImg,
-    const cv::Mat& registeredImg,
-	const vector<int>& windowSizes,
+    const IngestedImage& referenceImg,
+    const IngestedImage& registeredImg,
+    const DetectorConfig& config,
+    const vector<int>& lpsiftWindowSizes,
     const std::string& outputPath
 ) {
-    std::vector<StitchingMetrics> results;
-
-    for (const auto& config : detectors_) {
-        std::cout << "  Running " << config.name << "..." << std::flush;
-
-        StitchingMetrics metrics = runSingleBenchmark(
-            datasetName, referenceImg, registeredImg, config, windowSizes,
-            outputPath
-        );
+    StitchingMetrics metrics;
+    metrics.datasetName = datasetName;
+    metrics.algorithmName = config.name;
 
-        if (metrics.stitchingSuccess) {
-            std::cout << " Done (" << StitchingMetrics::formatTime(metrics.totalStitchingTime)
-                      << "s, " << metrics.numKeypointsReference << "/"
-                      << metrics.numKeypointsRegistered << " keypoints)" << std::endl;
-        } else {
-            std::cout << " Failed: " << metrics.failureReason << std::endl;
+    // Only set window sizes for LP-SIFT algorithm, use "x" for others
+    if (config.name == "LP-SIFT" || config.name == "LP-ORB" || config.name == "LP-DoG") {
+        metrics.windowSizes = joinInts(lpsiftWindowSizes);
+        if (options_.denseDetection && config.name != "LP-DoG") {
+            metrics.windowSizes += "@L/2"; // dense windows at stride L/2
+        }
+    } else {
+        metrics.windowSizes = "x";
+    }
+
+    recordInputImages(metrics, referenceImg, registeredImg);
+    initWindowSizeStats(metrics, lpsiftWindowSizes);
+    const trace::ContextScope traceContext(datasetName, config.name, metrics.windowSizes);
+
+    // State shared by the stage tasks; each image's tasks only touch their own half
+    std::vector<cv::KeyPoint> kpts1, kpts2;
+    cv::Mat desc1, desc2;
+    LPDetectionStats stats1, stats2;
+    KnnMatches matches;
+    std::vector<uchar> inlierMask;
+    cv::Mat H, stitched;
+
+    // First failure wins; it makes the failing task skip everything downstream
+    std::mutex failureMutex;
+    auto fail = [&](const std::string& reason) {
+        std::lock_guard<std::mutex> lock(failureMutex);
+        if (metrics.failureReason.empty()) metrics.failureReason = reason;
+        return false;
+    };
+
+    // Stage wrapper: times the body into the given metrics field; worker threads join this stitch's Mat scope
+    // and trace context
+    MatPoolScope* matScope = MatPoolScope::current();
+    const trace::Context stitchContext = trace::currentContext();
+    auto timed = [matScope, stitchContext](double& seconds, auto body) {
+        return [&seconds, body, matScope, stitchContext]() {
+            MatPoolScope::Attach attach(matScope);
+            const trace::ContextScope context(stitchContext);
+            Timer timer;
+            timer.start();
+            const bool ok = body();
+            timer.stop();
+            seconds = timer.elapsedSeconds();
+            return ok;
+        };
+    };
+
+    // Per image: detect -> describe on the ingested grayscale; the two chains are independent
+    auto addImageStages = [&](TaskGraph& graph, const std::string& label, const cv::Mat& gray,
+                              std::vector<cv::KeyPoint>& kpts, cv::Mat& desc, LPDetectionStats& stats,
+                              double& detectTime, double& describeTime, int WindowSizeStats::* detected) {
+        const auto detectTask = graph.add("detect(" + label + ")", timed(detectTime, [&, detected] {
+            detectKeypoints(config.detector, gray, kpts, stats);
+            countByWindowSize(metrics.windowSizeStats, kpts, detected);
+            if (kpts.empty()) return fail("Empty keypoints");
+
+            // Limit keypoints only for BFMatcher (has ~65536 limit due to IMGIDX_ONE)
+            if (config.matcherType == MatcherType::BRUTE_FORCE) {
+                limitKeypoints(kpts, MAX_KEYPOINTS_BF);
+            }
+            return true;
+        }));
+        return graph.add("describe(" + label + ")", timed(describeTime, [&] {
+            config.detector->compute(gray, kpts, desc);
+            return desc.empty() ? fail("Empty descriptors") : true;
+        }), {detectTask});
+    };
+
+    TaskGraph graph;
+    const auto describe1 = addImageStages(graph, "reference", referenceImg.gray(), kpts1, desc1, stats1,
+                                          metrics.detectionTimeReference, metrics.descriptorTimeReference,
+                                          &WindowSizeStats::keypointsReference);
+    const auto describe2 = addImageStages(graph, "registered", registeredImg.gray(), kpts2, desc2, stats2,
+                                          metrics.detectionTimeRegistered, metrics.descriptorTimeRegistered,
+                                          &WindowSizeStats::keypointsRegistered);
+
+    const auto matchTask = graph.add("match", timed(metrics.matchingTime, [&] {
+        try {
+            matchDescriptors(config, desc1, desc2, matches);
+        }
+        catch (exception& e) {
+            if (config.matcherType != MatcherType::BRUTE_FORCE) throw;
+            return fail("Over size");
+        }
+        return matches.size() < MIN_MATCHES ? fail("Insufficient matches (<4)") : true;
+    }), {describe1, describe2});
+
+    const auto homographyTask = graph.add("homography", timed(metrics.homographyTime, [&] {
+        // Extract matched points
+        std::vector<cv::Point2f> pts1, pts2;
+        matches.appendPoints(kpts1, kpts2, pts1, pts2);
+
+        // RANSAC homography estimation
+        cv::setRNGSeed(RNG_SEED);
+        H = cv::findHomography(pts2, pts1, cv::RANSAC, RANSAC_THRESHOLD, inlierMask);
+        return H.empty() ? fail("Homography computation failed") : true;
+    }), {matchTask});
+
+    // Color is only decoded once registration has succeeded
+    const auto colorTask = graph.add("color", [&] {
+        MatPoolScope::Attach attach(matScope);
+        metrics.colorDecodeTime = decodeColor(referenceImg, registeredImg);
+        return true;
+    }, {homographyTask});
+
+    graph.add("warp", timed(metrics.warpingTime, [&] {
+        stitched = warpAndBlend(registeredImg.color(), referenceImg.color(), H);
+        return true;
+    }), {colorTask});
+
+    Timer totalTimer;
+    totalTimer.start();
+
+    try {
+        metrics.stageSpans = pool_ ? graph.run(*pool_) : graph.run(); // no pool at one thread
+    } catch (const std::exception& e) {
+        metrics.failureReason = std::string("Exception: ") + e.what();
+    }
+
+    totalTimer.stop();
+    metrics.totalStitchingTime = totalTimer.elapsedSeconds() - metrics.colorDecodeTime;
+
+    metrics.numKeypointsReference = static_cast<int>(kpts1.size());
+    metrics.numKeypointsRegistered = static_cast<int>(kpts2.size());
+    metrics.numMatches = static_cast<int>(matches.size());
+    metrics.numInliers = inlierMask.empty() ? 0 : cv::countNonZero(inlierMask);
+
+    metrics.numCandidatesReference = static_cast<int>(stats1.candidates);
+    metrics.numCandidatesRegistered = static_cast<int>(stats2.candidates);
+    metrics.numBorderRejectedReference = static_cast<int>(stats1.borderRejected);
+    metrics.numBorderRejectedRegistered = static_cast<int>(stats2.borderRejected);
+    metrics.numPrunedReference = static_cast<int>(stats1.pruned);
+    metrics.numPrunedRegistered = static_cast<int>(stats2.pruned);
+    metrics.pruneTime = stats1.pruneSeconds + stats2.pruneSeconds;
+
+    addWindowSizeTimes(metrics.windowSizeStats, stats1, &WindowSizeStats::detectionTimeReference);
+    addWindowSizeTimes(metrics.windowSizeStats, stats2, &WindowSizeStats::detectionTimeRegistered);
+    if (!desc1.empty()) countByWindowSize(metrics.windowSizeStats, kpts1, &WindowSizeStats::descriptorsReference);
+    if (!desc2.empty()) countByWindowSize(metrics.windowSizeStats, kpts2, &WindowSizeStats::descriptorsRegistered);
+    countMatchesByWindowSize(metrics.windowSizeStats, matches, kpts1, inlierMask);
+
+    if (!metrics.failureReason.empty()) {
+        metrics.stitchingSuccess = false;
+        return metrics;
+    }
+
+    metrics.stitchingSuccess = true;
+    metrics.estimatePruneSavings();
+
+    metrics.homography = cv::Mat(H);
+
+    // Save stitched image if requested
+    if (!outputPath.empty() && writeRunOutputs) {
+        std::string outFile = outputPath + "/" + datasetName + "_" + config.name + "_stitched.jpg";
+        cv::imwrite(outFile, stitched);
+    }
+
+    saveFeatures(datasetName, config, "reference", kpts1, desc1);
+    saveFeatures(datasetName, config, "registered", kpts2, desc2);
+
+    return metrics;
+}
+
+StitchingMetrics BenchmarkRunner::runStreamingBenchmark(
+    const std::string& datasetName,
+    const IngestedImage& referenceImg,
+    const IngestedImage& registeredImg,
+    const DetectorConfig& config,
+    const vector<int>& lpsiftWindowSizes,
+    const std::string& outputPath
+) {
+    StitchingMetrics metrics;
+    metrics.datasetName = datasetName;
+    metrics.algorithmName = config.name;
+    metrics.windowSizes = joinInts(lpsiftWindowSizes);
+    if (options_.denseDetection) {
+        metrics.windowSizes += "@L/2"; // dense windows at stride L/2
+    }
+    metrics.scalesTotal = static_cast<int>(lpsiftWindowSizes.size());
+
+    recordInputImages(metrics, referenceImg, registeredImg);
+    initWindowSizeStats(metrics, lpsiftWindowSizes);
+    const trace::ContextScope traceContext(datasetName, config.name, metrics.windowSizes);
+
+    // Keypoints and descriptors of one scale of one image
+    struct ScaleFeatures {
+        int windowSize = 0;
+        std::vector<cv::KeyPoint> keypoints;
+        cv::Mat descriptors;
+        double detectSeconds = 0.0;
+        double describeSeconds = 0.0;
+    };
+
+    Timer totalTimer, stepTimer;
+    totalTimer.start();
+
+    const cv::Mat& gray1 = referenceImg.gray();
+    const cv::Mat& gray2 = registeredImg.gray();
+
+    BoundedQueue<ScaleFeatures> queue1(STREAM_QUEUE_CAPACITY), queue2(STREAM_QUEUE_CAPACITY);
+    LPDetectionStats stats1, stats2;
+    std::exception_ptr error1, error2;
+
+    // Producer: detect and describe one scale at a time, coarsest first.
+    // A closed queue (consumer is done) makes push fail, which stops detection of the finer scales.
+    MatPoolScope* matScope = MatPoolScope::current();
+    const trace::Context stitchContext = trace::currentContext();
+    auto produce = [&config, matScope, stitchContext](const cv::Mat& gray, BoundedQueue<ScaleFeatures>& queue,
+                                                      LPDetectionStats& stats, std::exception_ptr& error) {
+        MatPoolScope::Attach attach(matScope);
+        trace::setThreadName("stream producer");
+        const trace::ContextScope context(stitchContext);
+        try {
+            detectKeypointScales(config.detector, gray, [&](LPScaleBatch& batch) {
+                ScaleFeatures features;
+                features.windowSize = batch.windowSize;
+                features.detectSeconds = batch.seconds;
+                features.keypoints = std::move(batch.keypoints);
+
+                trace::Span span("describe scale");
+                span.arg("window_size", features.windowSize).arg("keypoints", features.keypoints.size());
+                Timer describeTimer;
+                describeTimer.start();
+                if (!features.keypoints.empty()) {
+                    config.detector->compute(gray, features.keypoints, features.descriptors);
+                }
+                describeTimer.stop();
+                span.end();
+                features.describeSeconds = describeTimer.elapsedSeconds();
+
+                return queue.push(std::move(features));
+            }, stats);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        queue.close();
+    };
+
+    std::thread producer1(produce, std::cref(gray1), std::ref(queue1), std::ref(stats1), std::ref(error1));
+    std::thread producer2(produce, std::cref(gray2), std::ref(queue2), std::ref(stats2), std::ref(error2));
+
+    // Consumer: match each scale pair as it arrives and re-estimate the homography on all matches so far
+    std::vector<cv::Point2f> pts1, pts2;
+    KnnMatches matches; // reused across scales
+    std::vector<uchar> inlierMask;
+    cv::Mat H;
+    std::vector<ScaleFeatures> consumed1, consumed2; // kept for --save-features
+    const bool keepFeatures = featureWriter_ && writeRunOutputs;
+    std::vector<std::pair<int, size_t>> matchedScales; // window size and match count of each matched scale, in pts order
+
+    try {
+        while (true) {
+            std::optional<ScaleFeatures> scale1 = queue1.pop();
+            std::optional<ScaleFeatures> scale2 = queue2.pop();
+            if (!scale1 || !scale2) break;
+
+            // --save-features: moved, not copied, and read from there for the rest of the iteration
+            if (keepFeatures) {
+                consumed1.push_back(std::move(*scale1));
+                consumed2.push_back(std::move(*scale2));
+            }
+            const ScaleFeatures& s1 = keepFeatures ? consumed1.back() : *scale1;
+            const ScaleFeatures& s2 = keepFeatures ? consumed2.back() : *scale2;
+
+            ++metrics.scalesProcessed;
+            metrics.detectionTimeReference += s1.detectSeconds;
+            metrics.detectionTimeRegistered += s2.detectSeconds;
+            metrics.descriptorTimeReference += s1.describeSeconds;
+            metrics.descriptorTimeRegistered += s2.describeSeconds;
+            metrics.numKeypointsReference += static_cast<int>(s1.keypoints.size());
+            metrics.numKeypointsRegistered += static_cast<int>(s2.keypoints.size());
+            if (WindowSizeStats* entry = findWindowSize(metrics.windowSizeStats, s1.windowSize)) {
+                entry->keypointsReference += static_cast<int>(s1.keypoints.size());
+                entry->descriptorsReference += s1.descriptors.rows;
+                entry->detectionTimeReference = std::max(0.0, entry->detectionTimeReference) + s1.detectSeconds;
+            }
+            if (WindowSizeStats* entry = findWindowSize(metrics.windowSizeStats, s2.windowSize)) {
+                entry->keypointsRegistered += static_cast<int>(s2.keypoints.size());
+                entry->descriptorsRegistered += s2.descriptors.rows;
+                entry->detectionTimeRegistered = std::max(0.0, entry->detectionTimeRegistered) + s2.detectSeconds;
+            }
+
+            if (s1.descriptors.empty() || s2.descriptors.empty()) continue;
+
+            // Same-scale matching: both producers emit window sizes in the same order
+            trace::Span span("match scale");
+            stepTimer.start();
+            matchDescriptors(config, s1.descriptors, s2.descriptors, matches);
+            stepTimer.stop();
+            span.arg("window_size", s1.windowSize).arg("matches", matches.size());
+            span.end();
+            metrics.matchingTime += stepTimer.elapsedSeconds();
+
+            matches.appendPoints(s1.keypoints, s2.keypoints, pts1, pts2);
+            metrics.numMatches = static_cast<int>(pts1.size());
+            matchedScales.emplace_back(s1.windowSize, matches.size());
+
+            if (pts1.size() < MIN_MATCHES) continue;
+
+            // RANSAC homography estimation
+            span.begin("homography scale");
+            stepTimer.start();
+            cv::setRNGSeed(RNG_SEED);
+            H = cv::findHomography(pts2, pts1, cv::RANSAC, RANSAC_THRESHOLD, inlierMask);
+            stepTimer.stop();
+            span.arg("matches", pts1.size());
+            span.end();
+            metrics.homographyTime += stepTimer.elapsedSeconds();
+            metrics.numInliers = H.empty() ? 0 : cv::countNonZero(inlierMask);
+
+            // Confident homography: skip the remaining (finer, most expensive) scales
+            const double inlierRatio = static_cast<double>(metrics.numInliers) / pts1.size();
+            if (metrics.numInliers >= STREAM_MIN_INLIERS && inlierRatio >= STREAM_MIN_INLIER_RATIO &&
+                metrics.scalesProcessed < metrics.scalesTotal) {
+                metrics.earlyStopped = true;
+                break;
+            }
+        }
+    } catch (const std::exception& e) {
+        metrics.failureReason = std::string("Exception: ") + e.what();
+    }
+
+    // Stop the producers (their next push fails) and wait for them
+    queue1.close();
+    queue2.close();
+    producer1.join();
+    producer2.join();
+
+    metrics.numCandidatesReference = static_cast<int>(stats1.candidates);
+    metrics.numCandidatesRegistered = static_cast<int>(stats2.candidates);
+    metrics.numBorderRejectedReference = static_cast<int>(stats1.borderRejected);
+    metrics.numBorderRejectedRegistered = static_cast<int>(stats2.borderRejected);
+    metrics.numPrunedReference = static_cast<int>(stats1.pruned);
+    metrics.numPrunedRegistered = static_cast<int>(stats2.pruned);
+    metrics.pruneTime = stats1.pruneSeconds + stats2.pruneSeconds;
+
+    // Matches and inliers of the last homography estimate, by the scale they were matched at
+    size_t first = 0;
+    for (const auto& [windowSize, count] : matchedScales) {
+        WindowSizeStats* entry = findWindowSize(metrics.windowSizeStats, windowSize);
+        for (size_t i = first; entry && i < first + count; ++i) {
+            ++entry->matches;
+            if (i < inlierMask.size() && inlierMask[i]) ++entry->inliers;
+        }
+        first += count;
+    }
+
+    for (const auto& error : { error1, error2 }) {
+        if (!error || !metrics.failureReason.empty()) continue;
+        try {
+            std::rethrow_exception(error);
+        } catch (const std::exception& e) {
+            metrics.failureReason = std::string("Exception: ") + e.what();
+        }
+    }
+
+    if (metrics.failureReason.empty()) {
+        if (metrics.numKeypointsReference == 0 || metrics.numKeypointsRegistered == 0) {
+            metrics.failureReason = "Empty keypoints";
+        } else if (pts1.size() < MIN_MATCHES) {
+            metrics.failureReason = "Insufficient matches (<4)";
+        } else if (H.empty()) {
+            metrics.failureReason = "Homography computation failed";
+        }
+    }
+
+    if (!metrics.failureReason.empty()) {
+        metrics.stitchingSuccess = false;
+        totalTimer.stop();
+        metrics.totalStitchingTime = totalTimer.elapsedSeconds();
+        return metrics;
+    }
+
+    // Color is only needed for the composite; its decode is ingest, not stitching
+    metrics.colorDecodeTime = decodeColor(referenceImg, registeredImg);
+
+    // Image warping and blending
+    stepTimer.start();
+    cv::Mat stitched = warpAndBlend(registeredImg.color(), referenceImg.color(), H);
+    stepTimer.stop();
+    metrics.warpingTime = stepTimer.elapsedSeconds();
+
+    totalTimer.stop();
+    metrics.totalStitchingTime = totalTimer.elapsedSeconds() - metrics.colorDecodeTime;
+    metrics.stitchingSuccess = true;
+    metrics.estimatePruneSavings();
+
+    metrics.homography = cv::Mat(H);
+
+    // Save stitched image if requested
+    if (!outputPath.empty() && writeRunOutputs) {
+        std::string outFile = outputPath + "/" + datasetName + "_" + config.name + "_stitched.jpg";
+        cv::imwrite(outFile, stitched);
+    }
+
+    // One record per consumed scale
+    for (const auto& scale : consumed1) {
+        saveFeatures(datasetName, config, "reference/L=" + std::to_string(scale.windowSize),
+                     scale.keypoints, scale.descriptors);
+    }
+    for (const auto& scale : consumed2) {
+        saveFeatures(datasetName, config, "registered/L=" + std::to_string(scale.windowSize),
+                     scale.keypoints, scale.descriptors);
+    }
+
+    return metrics;
+}
+
+std::vector<StitchingMetrics> BenchmarkRunner::runAllDetectors(
+    const std::string& datasetName,
+    const IngestedImage& referenceImg,
+    const IngestedImage& registeredImg,
+	const vector<int>& windowSizes,
+    const std::string& outputPath
+) {
+    std::vector<StitchingMetrics> results;
+
+    for (const auto& config : detectors_) {
+        std::cout << "  Running " << config.name << "..." << std::flush;
+
+        // LP-SIFT/LP-ORB can stream keypoints per scale; everything else runs stage by stage
+        const bool streamable = config.detector.dynamicCast<LPSIFT>() || config.detector.dynamicCast<LPORB>();
+
+        const bool stageByStage = forcesStageByStage(options_);
+
+        StitchingMetrics metrics = runRepeated([&] {
+            if (options_.streamScales && streamable && !stageByStage) {
+                return runStreamingBenchmark(datasetName, referenceImg, registeredImg, config, windowSizes, outputPath);
+            }
+            if (options_.concurrentStages && !stageByStage) {
+                return runConcurrentBenchmark(datasetName, referenceImg, registeredImg, config, windowSizes, outputPath);
+            }
+            return runSingleBenchmark(datasetName, referenceImg, registeredImg, config, windowSizes, outputPath);
+        });
+
+        // SIFT runs first and provides the reference homography for the other detectors
+        if (metrics.stitchingSuccess) {
+            if (config.name == "SIFT") {
+                this->baselineH = metrics.homography;
+            }
+            metrics.baselineH = this->baselineH;
         }
 
+        printRunResult(std::cout, metrics);
+
         results.push_back(metrics);
     }
 
@@ -478,6 +1898,63 @@ std::vector<StitchingMetrics> BenchmarkRunner::runOnDirectory(
         return allResults;
     }
 
+    int savedOpenCVThreads = -1;
+    if (options_.throughputMode) {
+        // Jobs are the unit of parallelism: one job per worker, OpenCV single-threaded inside each job
+        if (!pool_) {
+            pool_ = std::make_shared<ThreadPool>(options_.threads);
+        }
+        savedOpenCVThreads = cv::getNumThreads();
+        cv::setNumThreads(1);
+        if (options_.streamScales || options_.concurrentStages) {
+            std::cout << "Note: --stream and --concurrent-stages are ignored in throughput mode" << std::endl;
+        }
+    } else if (options_.concurrentStages && !forcesStageByStage(options_) && !pool_) {
+        // One pool for the stage tasks and OpenCV's own parallel loops, so they do not oversubscribe the cores.
+        // The calling thread helps run the graph, so the pool gets one worker less than the thread count.
+        const unsigned threads = options_.threads > 0 ? options_.threads
+                                                      : std::max(1u, std::thread::hardware_concurrency());
+        if (threads > 1) {
+            pool_ = std::make_shared<ThreadPool>(threads - 1);
+            setOpenCVParallelBackend(pool_);
+        }
+        std::cout << "Concurrent stages on " << threads << " thread(s)" << std::endl;
+    }
+
+    // One Mat pool per thread that runs stitches, kept across image sets so their buffers are reused
+    if (options_.poolMats && matPools_.empty()) {
+        const size_t threads = (options_.throughputMode ? pool_->size() : 0) + 1;
+        for (size_t i = 0; i < threads; ++i) {
+            matPools_.push_back(std::make_unique<PooledMatAllocator>());
+        }
+    }
+
+    if (!options_.throughputMode && forcesStageByStage(options_) &&
+        (options_.streamScales || options_.concurrentStages)) {
+        std::cout << "Note: " << (options_.budgetMs > 0.0 ? "--budget" : "--escalate")
+                  << " runs every stitch stage by stage; --stream and --concurrent-stages are ignored" << std::endl;
+    }
+
+    // operator new is only counted when asked for, so other runs (and binaries) do not pay for it
+    if (options_.memStats) {
+        setHeapCounting(true);
+        if (!heapCounting()) {
+            std::cout << "Note: heap counters are compiled out (configure with -DLP_HEAP_COUNTERS=ON)" << std::endl;
+        }
+    }
+
+    // Counters are only read around the stages of stage-by-stage stitches
+    if (options_.perfCounters) {
+        if (!PerfCounters().available()) {
+            std::cout << "Note: hardware counters unavailable (unsupported or restricted by "
+                      << "kernel.perf_event_paranoid), reporting thread CPU time only" << std::endl;
+        }
+        if (!options_.throughputMode && (options_.streamScales || options_.concurrentStages)) {
+            std::cout << "Note: --perf-counters only covers stage-by-stage runs, not --stream or --concurrent-stages"
+                      << std::endl;
+        }
+    }
+
     // Collect and sort image set directories
     std::vector<std::string> imageSets;
     for (const auto& entry : fs::directory_iterator(imageDir)) {
@@ -487,6 +1964,53 @@ std::vector<StitchingMetrics> BenchmarkRunner::runOnDirectory(
     }
     std::sort(imageSets.begin(), imageSets.end());
 
+    std::vector<std::string> selectedSets;
+    for (const auto& setPath : imageSets) {
+        std::string setName = fs::path(setPath).filename().string();
+        if (filteredImageSets.empty() || filteredImageSets.find(setName) != filteredImageSets.end()) {
+            selectedSets.push_back(setPath);
+        }
+    }
+
+    // Decode the next sets in the background while the current one is benchmarked
+    ImageSetPrefetcher::Options loaderOptions;
+    if (!options_.prefetchImages) {
+        loaderOptions.decodeThreads = 0; // --no-prefetch: decode each set when it is needed
+    }
+    loaderOptions.reduction = options_.ingestReduction;
+    loaderOptions.cameraFrames = options_.cameraFrames;
+
+    if (!options_.featureStorePath.empty() && !featureWriter_) {
+        try {
+            featureWriter_ = std::make_unique<FeatureStoreWriter>(options_.featureStorePath);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << " (features will not be saved)" << std::endl;
+        }
+    }
+    ImageSetPrefetcher loader(selectedSets, loaderOptions);
+
+    const BaselineCache baselineCache(options_.baselineCacheDir);
+    std::map<std::string, std::string> baselineKeys; // dataset -> cache key of a SIFT run to store
+
+    // Throughput mode: result slots in submission order, and image sets with unfinished jobs
+    const std::string mode = executionMode();
+    std::deque<StitchingMetrics> jobResults;
+    std::mutex jobMutex; // guards console output, inFlightSets and runningJobs
+    std::condition_variable setFinished;
+    int inFlightSets = 0;
+    int runningJobs = 0;
+
+    // Jobs reference the state above: wait for them on every exit path, so an exception cannot unwind it
+    struct JobDrain {
+        std::mutex& mutex;
+        std::condition_variable& finished;
+        const int& running;
+        ~JobDrain() {
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [this] { return running == 0; });
+        }
+    } drainJobs{jobMutex, setFinished, runningJobs};
+
     for (const auto& setPath : imageSets) {
         std::string setName = fs::path(setPath).filename().string();
 
@@ -495,16 +2019,28 @@ std::vector<StitchingMetrics> BenchmarkRunner::runOnDirectory(
             std::cout << "\nProcessing: " << setName << std::endl;
 
             // Load images (registered.jpg and reference.jpg as per main.cpp convention)
-            cv::Mat registered = cv::imread(setPath + "/registered.jpg");
-            cv::Mat reference = cv::imread(setPath + "/reference.jpg");
+            // The loader returns the selected sets in this loop's order, decoded ahead in the background
+            const std::optional<LoadedImageSet> loaded = loader.next();
+            if (!loaded || loaded->path != setPath) {
+                std::cerr << "  Error: image loader returned "
+                          << (loaded ? loaded->path : std::string("no set")) << " for " << setPath
+                          << "; stopping" << std::endl;
+                break;
+            }
+            const IngestedImage& registered = loaded->registered;
+            const IngestedImage& reference = loaded->reference;
 
             if (registered.empty() || reference.empty()) {
                 std::cerr << "  Warning: Could not load images from " << setPath << std::endl;
                 continue;
             }
 
-            std::cout << "  Reference: " << reference.cols << "x" << reference.rows
-                << ", Registered: " << registered.cols << "x" << registered.rows << std::endl;
+            std::cout << "  Reference: " << reference.gray().cols << "x" << reference.gray().rows
+                << ", Registered: " << registered.gray().cols << "x" << registered.gray().rows
+                << (options_.ingestReduction > 1 ? " (1/" + std::to_string(options_.ingestReduction) + " scale)" : "")
+                << (options_.cameraFrames ? " (NV12 frames)" : "")
+                << " (decoded in " << StitchingMetrics::formatTime(loaded->decodeTime)
+                << "s, waited " << StitchingMetrics::formatTime(loaded->waitTime) << "s)" << std::endl;
 
             clearDetectors(); // Clear previous detectors if any
 
@@ -528,6 +2064,7 @@ std::vector<StitchingMetrics> BenchmarkRunner::runOnDirectory(
 				detectorFilterProfile.SURF = detectorFilterProfile.SURF || sourceProfile.SURF;
 				detectorFilterProfile.LPSIFT = detectorFilterProfile.LPSIFT || sourceProfile.LPSIFT;
 				detectorFilterProfile.LPORB = detectorFilterProfile.LPORB || sourceProfile.LPORB;
+				detectorFilterProfile.LPDOG = detectorFilterProfile.LPDOG || sourceProfile.LPDOG;
 
             }
 
@@ -535,7 +2072,29 @@ std::vector<StitchingMetrics> BenchmarkRunner::runOnDirectory(
                 allFilters = false;
             }
 
-			addDetector("SIFT", cv::SIFT::create(), cv::NORM_L2); // SIFT always has to run regardless of filters
+            // SIFT provides the reference homography: LP-only selections load it from the baseline cache,
+            // otherwise it runs (and refreshes the cache)
+            const std::string baselineKey = options_.baselineCacheDir.empty() ? "" :
+                BaselineCache::makeKey(setPath + "/reference.jpg", setPath + "/registered.jpg",
+                                       baselineSettings(options_));
+            StitchingMetrics cachedBaseline;
+            const bool siftRequested = allFilters || detectorFilterProfile.SIFT;
+            const bool useCachedBaseline = !siftRequested && !options_.refreshBaseline &&
+                                           baselineCache.load(baselineKey, cachedBaseline);
+
+            if (useCachedBaseline) {
+                cachedBaseline.datasetName = setName;
+                cachedBaseline.algorithmName = "SIFT";
+                cachedBaseline.windowSizes = "x";
+                cachedBaseline.executionMode = mode;
+                cachedBaseline.baselineH = cachedBaseline.homography;
+                cachedBaseline.loadWaitTime = loaded->waitTime;
+                recordInputImages(cachedBaseline, reference, registered);
+                std::cout << "  SIFT baseline loaded from cache (" << baselineKey << ")" << std::endl;
+            } else {
+                addDetector("SIFT", cv::SIFT::create(), cv::NORM_L2);
+                baselineKeys[setName] = baselineKey;
+            }
             
 			if (allFilters || detectorFilterProfile.ORB)
                 addDetector("ORB", ORB::create(250000), NORM_HAMMING);
@@ -546,27 +2105,289 @@ std::vector<StitchingMetrics> BenchmarkRunner::runOnDirectory(
 			if (allFilters || detectorFilterProfile.SURF)
                 addDetector("SURF", xfeatures2d::SURF::create(), NORM_L2);
 
-            std::vector<int> windowSizes = getWindowSize(reference.cols, reference.rows);
+            std::vector<int> windowSizes = getWindowSize(reference.gray().cols, reference.gray().rows);
 
             std::cout << "  Using window sizes L = " << joinInts(windowSizes) << std::endl;
 
-            if (allFilters || detectorFilterProfile.LPSIFT)
-                addDetector("LP-SIFT", LPSIFT::create(windowSizes), NORM_L2);
+            LPPruneParams pruneParams;
+            pruneParams.enabled = options_.pruneCandidates;
+            LPBorderCheckParams borderCheckParams;
+            borderCheckParams.enabled = options_.checkBorderPeaks;
+            LPDenseParams denseParams;
+            denseParams.enabled = options_.denseDetection;
+
+            if (allFilters || detectorFilterProfile.LPSIFT) {
+                auto lpsift = LPSIFT::create(windowSizes);
+                lpsift->setPruneParams(pruneParams);
+                lpsift->setBorderCheckParams(borderCheckParams);
+                lpsift->setDenseParams(denseParams);
+                addDetector("LP-SIFT", lpsift, NORM_L2);
+            }
+
+            if (allFilters || detectorFilterProfile.LPORB) {
+                auto lporb = LPORB::create(windowSizes);
+                lporb->setPruneParams(pruneParams);
+                lporb->setBorderCheckParams(borderCheckParams);
+                lporb->setDenseParams(denseParams);
+                addDetector("LP-ORB", lporb, NORM_HAMMING);
+            }
 
-            if (allFilters || detectorFilterProfile.LPORB)
-                addDetector("LP-ORB", LPORB::create(windowSizes), NORM_HAMMING);
+            if (allFilters || detectorFilterProfile.LPDOG)
+                addDetector("LP-DoG", LPDOG::create(windowSizes), NORM_L2);
+
+            if (options_.throughputMode) {
+                // Bound memory: jobs keep their image set alive until the last one finishes
+                {
+                    std::unique_lock<std::mutex> lock(jobMutex);
+                    setFinished.wait(lock, [&] { return inFlightSets < THROUGHPUT_MAX_INFLIGHT_SETS; });
+                    ++inFlightSets;
+                }
+
+                if (useCachedBaseline) {
+                    jobResults.push_back(cachedBaseline);
+                }
+
+                const double loadWaitTime = loaded->waitTime;
+                auto remaining = std::make_shared<std::atomic<size_t>>(detectors_.size());
+
+                for (const auto& config : detectors_) {
+                    jobResults.emplace_back();
+                    StitchingMetrics* slot = &jobResults.back();
+                    {
+                        std::lock_guard<std::mutex> lock(jobMutex);
+                        ++runningJobs;
+                    }
+
+                    // Captures share the decoded images (and their one lazy color decode) with the other jobs
+                    pool_->submit([this, slot, remaining, config, reference, registered, setName, windowSizes,
+                                   outputPath, loadWaitTime, &mode, &jobMutex, &setFinished, &inFlightSets,
+                                   &runningJobs]() {
+                        if (options_.pinThreads) {
+                            pinCurrentThread(static_cast<unsigned>(pool_->currentWorker()));
+                        }
+
+                        StitchingMetrics metrics;
+                        try {
+                            metrics = runRepeated([&] {
+                                return runSingleBenchmark(setName, reference, registered, config, windowSizes, outputPath);
+                            });
+                        } catch (const std::exception& e) {
+                            metrics.datasetName = setName;
+                            metrics.algorithmName = config.name;
+                            metrics.failureReason = std::string("Exception: ") + e.what();
+                        }
+                        metrics.loadWaitTime = loadWaitTime;
+                        metrics.executionMode = mode;
+
+                        std::lock_guard<std::mutex> lock(jobMutex);
+                        *slot = std::move(metrics);
+                        std::cout << "  [" << setName << "] " << config.name << ":";
+                        printRunResult(std::cout, *slot);
+
+                        if (--*remaining == 0) {
+                            --inFlightSets;
+                        }
+                        --runningJobs;
+                        setFinished.notify_all();
+                    });
+                }
+                continue;
+            }
+
+            if (useCachedBaseline) {
+                this->baselineH = cachedBaseline.homography;
+                allResults.push_back(cachedBaseline);
+            }
 
             auto results = runAllDetectors(setName, reference, registered,
                 windowSizes, outputPath);
+            for (auto& m : results) {
+                m.loadWaitTime = loaded->waitTime;
+                if (m.algorithmName == "SIFT") {
+                    baselineCache.store(baselineKey, m);
+                }
+            }
             allResults.insert(allResults.end(), results.begin(), results.end());
 
         }
 
     }
 
+    if (options_.throughputMode) {
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            setFinished.wait(lock, [&] { return inFlightSets == 0; });
+        }
+        cv::setNumThreads(savedOpenCVThreads);
+
+        // Jobs ran in any order: fill in each dataset's SIFT reference homography afterwards
+        std::map<std::string, cv::Mat> baselineByDataset;
+        for (const auto& m : jobResults) {
+            if (m.algorithmName == "SIFT" && m.stitchingSuccess) {
+                baselineByDataset[m.datasetName] = m.homography;
+                if (!m.fromCache) {
+                    baselineCache.store(baselineKeys[m.datasetName], m);
+                }
+            }
+        }
+        for (auto& m : jobResults) {
+            if (m.stitchingSuccess) {
+                m.baselineH = baselineByDataset[m.datasetName];
+            }
+        }
+
+        allResults.insert(allResults.end(), jobResults.begin(), jobResults.end());
+    }
+
+    // Synthetic sets carry their true homography: score every estimate against it
+    std::map<std::string, GroundTruth> groundTruth;
+    for (const auto& setPath : selectedSets) {
+        GroundTruth truth;
+        if (loadGroundTruth(setPath, truth)) {
+            groundTruth[fs::path(setPath).filename().string()] = truth;
+        }
+    }
+    for (auto& m : allResults) {
+        const auto truth = groundTruth.find(m.datasetName);
+        if (truth != groundTruth.end() && m.stitchingSuccess && !m.homography.empty()) {
+            m.cornerError = cornerReprojectionError(m.homography, truth->second, options_.ingestReduction);
+        }
+    }
+
+    if (options_.prefetchImages) {
+        std::cout << "\nPrefetch peak decoded memory: "
+                  << formatBytes(static_cast<double>(loader.peakBytes()), MIB) << " MiB" << std::endl;
+    }
+
     return allResults;
 }
 
+void BenchmarkRunner::saveFeatures(const std::string& datasetName,
+                                   const DetectorConfig& config,
+                                   const std::string& imageName,
+                                   const std::vector<cv::KeyPoint>& keypoints,
+                                   const cv::Mat& descriptors) {
+    if (!featureWriter_ || !writeRunOutputs) return;
+
+    // CV_8U descriptors matched with Hamming are bit strings; with L2 they are quantized vectors
+    const DescriptorKind kind = (config.matcherNorm == cv::NORM_HAMMING || config.matcherNorm == cv::NORM_HAMMING2)
+        ? DescriptorKind::Binary : DescriptorKind::UInt8;
+
+    const std::string key = datasetName + "/" + config.name + "/" + imageName;
+    try {
+        std::lock_guard<std::mutex> lock(featureMutex_);
+        featureWriter_->append(key, keypoints, descriptors, kind);
+    } catch (const std::exception& e) {
+        std::cerr << "  Warning: could not save features of " << key << ": " << e.what() << std::endl;
+    }
+}
+
+StitchingMetrics BenchmarkRunner::runWithMatScope(const std::function<StitchingMetrics()>& stitch) {
+    PooledMatAllocator* matPool = nullptr;
+    if (!matPools_.empty()) {
+        const size_t index = pool_ ? static_cast<size_t>(pool_->currentWorker() + 1) : 0;
+        matPool = matPools_[index < matPools_.size() ? index : 0].get();
+    }
+
+    // Concurrent throughput jobs share the process: count only this thread's page faults
+    const auto faults = options_.throughputMode ? MatPoolScope::FaultScope::Thread : MatPoolScope::FaultScope::Process;
+
+    // The RSS high-water mark is process-wide, so it is only reset when stitches run one at a time
+    if (options_.memStats && !options_.throughputMode) resetPeakRss();
+    const HeapCounters heapStart = threadHeapCounters();
+
+    StitchingMetrics metrics;
+    MatPoolStats stats;
+    {
+        MatPoolScope scope(matPool, faults);
+        metrics = stitch();
+        stats = scope.stats();
+    }
+
+    const HeapCounters heapEnd = threadHeapCounters();
+    metrics.heapAllocations = heapEnd.allocations - heapStart.allocations;
+    metrics.heapBytes = heapEnd.bytes - heapStart.bytes;
+    metrics.peakRssKiB = readPeakRssKiB();
+
+    metrics.matAllocations = stats.allocations;
+    metrics.matAllocatedBytes = stats.allocatedBytes;
+    metrics.matPooledAllocations = stats.pooledAllocations;
+    metrics.matReusedAllocations = stats.reusedAllocations;
+    metrics.minorPageFaults = stats.minorPageFaults;
+    metrics.majorPageFaults = stats.majorPageFaults;
+    return metrics;
+}
+
+// Ends a span around a whole stitch with its keypoint counts, under the stitch's context
+// (spans take the thread's context when they end, and the stitch only set it while running)
+static void endStitchSpan(trace::Span& span, const StitchingMetrics& metrics) {
+    const trace::ContextScope context(metrics.datasetName, metrics.algorithmName, metrics.windowSizes);
+    span.arg("keypoints_reference", metrics.numKeypointsReference)
+        .arg("keypoints_registered", metrics.numKeypointsRegistered);
+    span.end();
+}
+
+StitchingMetrics BenchmarkRunner::runRepeated(const std::function<StitchingMetrics()>& stitch) {
+    const int warmups = std::max(0, options_.warmupRuns);
+    const int repetitions = std::max(1, options_.repetitions);
+
+    // Later stitches on this thread write their outputs again on every exit path, exceptions included
+    struct OutputsRestore {
+        ~OutputsRestore() { writeRunOutputs = true; }
+    } restoreOutputs;
+
+    // Warm-ups: caches, lazy color decode, allocator pools; a failing stitch fails every time, so stop early
+    writeRunOutputs = false;
+    for (int i = 0; i < warmups; ++i) {
+        trace::Span span("warm-up");
+        StitchingMetrics warmup = runWithMatScope(stitch);
+        endStitchSpan(span.arg("run", i), warmup);
+        if (!warmup.stitchingSuccess) {
+            // Reported like a failure among the measured runs: the failing run is the only sample
+            warmup.warmupRuns = i + 1;
+            warmup.repetitions = 0;
+            warmup.stageStats.clear();
+            for (const auto& stage : timedStages()) {
+                const int64_t ns = static_cast<int64_t>(std::llround(warmup.*(stage.seconds) * 1e9));
+                warmup.stageStats.push_back(computeTimingStats({ns}));
+            }
+            return warmup;
+        }
+    }
+
+    std::vector<std::vector<int64_t>> samples(timedStages().size());
+    StitchingMetrics metrics;
+    int measured = 0;
+    while (measured < repetitions) {
+        writeRunOutputs = (measured == repetitions - 1);
+        trace::Span span("stitch");
+        metrics = runWithMatScope(stitch);
+        endStitchSpan(span.arg("repetition", measured), metrics);
+        ++measured;
+
+        for (size_t i = 0; i < timedStages().size(); ++i) {
+            samples[i].push_back(static_cast<int64_t>(std::llround(metrics.*(timedStages()[i].seconds) * 1e9)));
+        }
+        if (!metrics.stitchingSuccess) break;
+    }
+
+    metrics.warmupRuns = warmups;
+    metrics.repetitions = measured;
+    metrics.stageStats.clear();
+    for (size_t i = 0; i < timedStages().size(); ++i) {
+        metrics.stageStats.push_back(computeTimingStats(samples[i]));
+        metrics.*(timedStages()[i].seconds) = metrics.stageStats.back().medianNs / 1e9;
+    }
+    return metrics;
+}
+
+std::string BenchmarkRunner::executionMode() const {
+    if (!options_.throughputMode) return "latency";
+
+    const unsigned jobs = pool_ ? pool_->size() : std::max(1u, std::thread::hardware_concurrency());
+    return "throughput (" + std::to_string(jobs) + " jobs" + (options_.pinThreads ? ", pinned" : "") + ")";
+}
+
 void BenchmarkRunner::printSummaryTable(const std::vector<StitchingMetrics>& results) {
     std::cout << "\n" << std::string(120, '=') << std::endl;
     std::cout << "BENCHMARK SUMMARY" << std::endl;
@@ -607,6 +2428,236 @@ void BenchmarkRunner::printSummaryTable(const std::vector<StitchingMetrics>& res
     std::cout << std::string(120, '=') << std::endl;
 }
 
+void BenchmarkRunner::printPruningSummary(const std::vector<StitchingMetrics>& results) {
+    auto removedCount = [](const StitchingMetrics& m) {
+        return m.numPrunedReference + m.numPrunedRegistered +
+               m.numBorderRejectedReference + m.numBorderRejectedRegistered;
+    };
+
+    bool anyPruned = false;
+    for (const auto& m : results) {
+        anyPruned = anyPruned || removedCount(m) > 0;
+    }
+    if (!anyPruned) return;
+
+    std::cout << "\nLP Candidate Filtering:" << std::endl;
+    std::cout << std::string(94, '-') << std::endl;
+    std::cout << std::left
+              << std::setw(15) << "Dataset"
+              << std::setw(12) << "Algorithm"
+              << std::setw(14) << "Candidates"
+              << std::setw(14) << "Border(%)"
+              << std::setw(12) << "Pruned(%)"
+              << std::setw(14) << "Prune(s)"
+              << std::setw(14) << "Est. Saved(s)"
+              << std::endl;
+
+    for (const auto& m : results) {
+        if (removedCount(m) == 0) continue;
+        std::ostringstream borderPct, prunedPct;
+        borderPct << std::fixed << std::setprecision(1) << m.getBorderRejectedFraction() * 100.0;
+        prunedPct << std::fixed << std::setprecision(1) << m.getPrunedFraction() * 100.0;
+        std::cout << std::left
+                  << std::setw(15) << m.datasetName.substr(0, 14)
+                  << std::setw(12) << m.algorithmName
+                  << std::setw(14) << (m.numCandidatesReference + m.numCandidatesRegistered)
+                  << std::setw(14) << borderPct.str()
+                  << std::setw(12) << prunedPct.str()
+                  << std::setw(14) << StitchingMetrics::formatTime(m.pruneTime)
+                  << std::setw(14) << (m.stitchingSuccess ? StitchingMetrics::formatTime(m.estimatedPruneTimeSaved) : "x")
+                  << std::endl;
+    }
+}
+
+void BenchmarkRunner::printWindowSizeSummary(const std::vector<StitchingMetrics>& results) {
+    // Summed over datasets per (algorithm, window size set), ascending window sizes
+    std::map<std::pair<std::string, std::string>, std::vector<WindowSizeStats>> groups;
+    for (const auto& m : results) {
+        if (m.windowSizeStats.empty()) continue;
+        std::vector<WindowSizeStats>& group = groups[{m.algorithmName, m.windowSizes}];
+        if (group.empty()) {
+            group = m.windowSizeStats;
+            continue;
+        }
+        for (const auto& w : m.windowSizeStats) {
+            WindowSizeStats* entry = &windowSizeEntry(group, w.windowSize); // escalated stitches may add sizes
+            entry->keypointsReference += w.keypointsReference;
+            entry->keypointsRegistered += w.keypointsRegistered;
+            entry->matches += w.matches;
+            entry->inliers += w.inliers;
+            if (w.detectionTimeReference >= 0.0) {
+                entry->detectionTimeReference = std::max(0.0, entry->detectionTimeReference) + w.detectionTimeReference;
+            }
+            if (w.detectionTimeRegistered >= 0.0) {
+                entry->detectionTimeRegistered = std::max(0.0, entry->detectionTimeRegistered) + w.detectionTimeRegistered;
+            }
+        }
+    }
+    if (groups.empty()) return;
+
+    auto percent = [](const double part, const double whole) {
+        return whole > 0.0 ? StitchingMetrics::formatTime(100.0 * part / whole) : std::string("x");
+    };
+
+    std::cout << "\nLP Window Size Contribution (all datasets):" << std::endl;
+    std::cout << std::string(100, '-') << std::endl;
+    std::cout << std::left
+              << std::setw(12) << "Algorithm"
+              << std::setw(24) << "Window(L)"
+              << std::setw(8) << "L"
+              << std::setw(14) << "Keypoints(%)"
+              << std::setw(12) << "Matches(%)"
+              << std::setw(12) << "Inliers(%)"
+              << std::setw(12) << "Detect(%)"
+              << "Yield" << std::endl;
+
+    for (const auto& [key, group] : groups) {
+        double keypoints = 0.0, matches = 0.0, inliers = 0.0, detectionTime = 0.0;
+        for (const auto& w : group) {
+            keypoints += w.keypointsReference + w.keypointsRegistered;
+            matches += w.matches;
+            inliers += w.inliers;
+            detectionTime += w.detectionTime();
+        }
+
+        for (const auto& w : group) {
+            // A scale is low-yield when its share of the inliers is under half its share of the cost
+            // (detection time, or the keypoints that feed description and matching where it is not timed)
+            const double scaleKeypoints = w.keypointsReference + w.keypointsRegistered;
+            const double cost = detectionTime > 0.0 ? w.detectionTime() / detectionTime
+                                                    : (keypoints > 0.0 ? scaleKeypoints / keypoints : 0.0);
+            const double yield = inliers > 0.0 ? w.inliers / inliers : 0.0;
+            std::cout << std::left
+                      << std::setw(12) << key.first
+                      << std::setw(24) << key.second
+                      << std::setw(8) << w.windowSize
+                      << std::setw(14) << percent(scaleKeypoints, keypoints)
+                      << std::setw(12) << percent(w.matches, matches)
+                      << std::setw(12) << percent(w.inliers, inliers)
+                      << std::setw(12) << percent(w.detectionTime(), detectionTime)
+                      << (inliers > 0.0 && yield < 0.5 * cost ? "low" : "ok") << std::endl;
+        }
+    }
+}
+
+void BenchmarkRunner::printEscalationSummary(const std::vector<StitchingMetrics>& results) {
+    const bool anyEscalated = std::any_of(results.begin(), results.end(),
+                                          [](const StitchingMetrics& m) { return !m.escalationLevelsTried.empty(); });
+    if (!anyEscalated) return;
+
+    std::cout << "\nEscalation Ladder (registered / tried per level, all datasets):" << std::endl;
+    std::cout << std::string(120, '-') << std::endl;
+    std::cout << std::left
+              << std::setw(12) << "Algorithm"
+              << std::setw(10) << "Stitches"
+              << std::setw(10) << "Plain";
+    for (int level = 1; level < ESCALATION_LEVEL_COUNT; ++level) {
+        std::cout << std::setw(17) << escalationLevelName(static_cast<EscalationLevel>(level));
+    }
+    std::cout << std::setw(10) << "Success"
+              << std::setw(10) << "Mean(s)"
+              << "Ladder(s)" << std::endl;
+
+    std::vector<std::string> algorithms;
+    for (const auto& m : results) {
+        if (std::find(algorithms.begin(), algorithms.end(), m.algorithmName) == algorithms.end()) {
+            algorithms.push_back(m.algorithmName);
+        }
+    }
+
+    for (const auto& algorithm : algorithms) {
+        int stitches = 0, plain = 0, successes = 0;
+        double totalTime = 0.0, ladderTime = 0.0;
+        std::vector<int> tried(ESCALATION_LEVEL_COUNT, 0), hits(ESCALATION_LEVEL_COUNT, 0);
+        for (const auto& m : results) {
+            if (m.algorithmName != algorithm || m.fromCache) continue;
+            ++stitches;
+            if (m.stitchingSuccess) ++successes;
+            if (m.stitchingSuccess && m.escalationLevelsTried.empty()) ++plain;
+            for (const int level : m.escalationLevelsTried) {
+                if (level > 0 && level < ESCALATION_LEVEL_COUNT) ++tried[level];
+            }
+            if (m.escalationLevel > 0 && m.escalationLevel < ESCALATION_LEVEL_COUNT) ++hits[m.escalationLevel];
+            totalTime += m.totalStitchingTime;
+            ladderTime += m.escalationTime;
+        }
+        if (stitches == 0) continue;
+
+        std::cout << std::left
+                  << std::setw(12) << algorithm
+                  << std::setw(10) << stitches
+                  << std::setw(10) << (std::to_string(plain) + "/" + std::to_string(stitches));
+        for (int level = 1; level < ESCALATION_LEVEL_COUNT; ++level) {
+            std::cout << std::setw(17) << (tried[level] > 0 ? std::to_string(hits[level]) + "/" + std::to_string(tried[level]) : "x");
+        }
+        std::cout << std::setw(10) << (std::to_string(successes) + "/" + std::to_string(stitches))
+                  << std::setw(10) << StitchingMetrics::formatTime(totalTime / stitches)
+                  << StitchingMetrics::formatTime(ladderTime / stitches) << std::endl;
+    }
+}
+
+void BenchmarkRunner::printBudgetSummary(const std::vector<StitchingMetrics>& results) {
+    const bool anyBudget = std::any_of(results.begin(), results.end(),
+                                       [](const StitchingMetrics& m) { return m.budgetSeconds > 0.0; });
+    if (!anyBudget) return;
+
+    // Stage shares abbreviated to fit: Det Ref, Det Reg, Desc Ref, Desc Reg, Match, H, Warp, Total
+    const std::vector<std::string> headers = {"DetRef", "DetReg", "DscRef", "DscReg", "Match", "H", "Warp", "Total"};
+
+    std::cout << "\nTime Budget Use (% of the budget per stage):" << std::endl;
+    std::cout << std::string(120, '-') << std::endl;
+    std::cout << std::left
+              << std::setw(15) << "Dataset"
+              << std::setw(12) << "Algorithm"
+              << std::setw(12) << "Budget(ms)";
+    for (size_t i = 0; i < timedStages().size() && i < headers.size(); ++i) {
+        std::cout << std::setw(8) << headers[i];
+    }
+    std::cout << "Degradations" << std::endl;
+
+    for (const auto& m : results) {
+        if (m.budgetSeconds <= 0.0) continue;
+        std::cout << std::left
+                  << std::setw(15) << m.datasetName.substr(0, 14)
+                  << std::setw(12) << m.algorithmName
+                  << std::setw(12) << formatRatio(m.budgetSeconds * 1000.0, 1);
+        for (size_t i = 0; i < timedStages().size() && i < headers.size(); ++i) {
+            std::cout << std::setw(8) << formatRatio(m.getBudgetShare(m.*(timedStages()[i].seconds)) * 100.0, 1);
+        }
+        const bool met = m.totalStitchingTime <= m.budgetSeconds;
+        std::cout << (m.stitchingSuccess ? (m.degradations.empty() ? "None" : m.degradations) : "Failed: " + m.failureReason)
+                  << (met ? "" : " (over budget)") << std::endl;
+    }
+}
+
+void BenchmarkRunner::printGroundTruthSummary(const std::vector<StitchingMetrics>& results) {
+    // Datasets with a ground truth: those with at least one scored estimate
+    std::set<std::string> synthetic;
+    for (const auto& m : results) {
+        if (m.cornerError >= 0.0) synthetic.insert(m.datasetName);
+    }
+    if (synthetic.empty()) return;
+
+    std::cout << "\nCorner Reprojection Error vs. Ground Truth (full-resolution px):" << std::endl;
+    std::cout << std::string(63, '-') << std::endl;
+    std::cout << std::left
+              << std::setw(15) << "Dataset"
+              << std::setw(12) << "Algorithm"
+              << std::setw(24) << "Window(L)"
+              << std::setw(12) << "Error(px)"
+              << std::endl;
+
+    for (const auto& m : results) {
+        if (synthetic.count(m.datasetName) == 0) continue;
+        std::cout << std::left
+                  << std::setw(15) << m.datasetName.substr(0, 14)
+                  << std::setw(12) << m.algorithmName
+                  << std::setw(24) << m.windowSizes
+                  << std::setw(12) << (m.cornerError >= 0.0 ? StitchingMetrics::formatTime(m.cornerError) : "Failed")
+                  << std::endl;
+    }
+}
+
 cv::Mat BenchmarkRunner::warpAndBlend(const cv::Mat& imgToWarp, const cv::Mat& baseImg, const cv::Mat& H) {
     // Calculate corners of images
     std::vector<cv::Point2f> cornersWarp = {
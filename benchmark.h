@@ -10,6 +10,7 @@
 #ifndef BENCHMARK_H
 #define BENCHMARK_H
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <chrono>
@@ -22,6 +23,17 @@
 #include <opencv2/core.hpp>
 #include <opencv2/features2d.hpp>
 
+#include "lppeaks.h"
+#include "concurrency.h"
+#include "prefetch.h"
+#include "featurestore.h"
+#include "baselinecache.h"
+#include "matpool.h"
+#include "knnmatches.h"
+#include "benchstats.h"
+#include "perfcounters.h"
+#include "memstats.h"
+
 namespace fs = std::filesystem;
 
 using namespace cv;
@@ -44,10 +56,32 @@ enum class MatcherType {
 // Minimum matches required for homography estimation
 constexpr size_t MIN_MATCHES = 4;
 
+// Lowe's ratio test threshold for FLANN kNN matching
+constexpr float RATIO_TEST_THRESHOLD = 0.75f;
+
 // RANSAC parameters
 constexpr double RANSAC_THRESHOLD = 3.0;
 constexpr int RNG_SEED = 12345;
 
+// Streaming (coarse-to-fine) pipeline: per-scale batches in flight per image,
+// and the homography confidence that stops it before the finer scales
+constexpr size_t STREAM_QUEUE_CAPACITY = 2;
+constexpr int STREAM_MIN_INLIERS = 50;
+constexpr double STREAM_MIN_INLIER_RATIO = 0.5;
+
+// Throughput mode: image sets whose detector jobs may be queued or running at once (bounds decoded memory)
+constexpr int THROUGHPUT_MAX_INFLIGHT_SETS = 4;
+
+// Time-budgeted stitching (--budget): cumulative share of the budget by which each stage should be done.
+// Past its share a stage degrades: the reference image stops adding scales at half the detection share,
+// matching stops between query batches, RANSAC is capped and the warp runs at a lower resolution
+constexpr double BUDGET_DETECT_SHARE = 0.4;
+constexpr double BUDGET_MATCH_SHARE = 0.7;      // description and matching
+constexpr double BUDGET_HOMOGRAPHY_SHARE = 0.8;
+constexpr int BUDGET_MATCH_BATCH_ROWS = 4096;   // query descriptors per deadline check while matching
+constexpr int BUDGET_RANSAC_ITERATIONS = 200;   // RANSAC cap once behind schedule (OpenCV default: 2000)
+constexpr double BUDGET_RANSAC_CONFIDENCE = 0.99;
+
 // ============================================================================
 // Image Size Category
 // ============================================================================
@@ -85,6 +119,23 @@ inline std::vector<int> getWindowSize(int width, int height) {
 // StitchingMetrics - Performance metrics structure
 // ============================================================================
 
+// Contribution of one LP interrogation window size (kp.class_id) to a stitch
+struct WindowSizeStats {
+    int windowSize = 0;
+    int keypointsReference = 0;    // detected
+    int keypointsRegistered = 0;
+    int descriptorsReference = 0;  // keypoints still described after compute()
+    int descriptorsRegistered = 0;
+    int matches = 0;               // ratio-test matches, by the reference keypoint's window size
+    int inliers = 0;               // RANSAC inliers among them
+    double detectionTimeReference = -1.0; // seconds of window scan and pruning; -1 if the detector has no per-scale timing
+    double detectionTimeRegistered = -1.0;
+
+    double detectionTime() const {
+        return std::max(0.0, detectionTimeReference) + std::max(0.0, detectionTimeRegistered);
+    }
+};
+
 /*
  * StitchingMetrics - Comprehensive metrics structure for performance evaluation
  * Based on Table 2 from the LP-SIFT paper
@@ -117,6 +168,46 @@ struct StitchingMetrics {
     double warpingTime = 0.0;
     double totalStitchingTime = 0.0;
 
+    // "latency" (one job at a time) or "throughput (...)" (concurrent dataset x detector jobs)
+    std::string executionMode = "latency";
+
+    // SIFT baseline loaded from the baseline cache instead of being run (timings are from the cached run)
+    bool fromCache = false;
+
+    // Image ingest, excluded from totalStitchingTime (same values for every detector of a dataset)
+    double ingestTimeReference = 0.0;   // grayscale decode of reference.jpg
+    double ingestTimeRegistered = 0.0;  // grayscale decode of registered.jpg
+    size_t ingestBytesReference = 0;    // decoded grayscale pixels
+    size_t ingestBytesRegistered = 0;
+    double loadWaitTime = 0.0;          // time the benchmark blocked on the loader (< ingest time when prefetched)
+    double colorDecodeTime = 0.0;       // lazy color decode for the composite, paid by the first run of a dataset
+
+    // cv::Mat buffers allocated during the stitch (see MatPoolScope) and page faults meanwhile
+    size_t matAllocations = 0;
+    size_t matAllocatedBytes = 0;
+    size_t matPooledAllocations = 0;    // served by the Mat pool (--mat-pool)
+    size_t matReusedAllocations = 0;    // served from the pool's free lists, no fresh memory touched
+    long minorPageFaults = -1;          // -1: not measured
+    long majorPageFaults = -1;
+
+    // Heap and RSS during the stitch: operator new on the stitching thread, and the process RSS
+    // high-water mark (over the stitch with --mem-stats in latency mode, otherwise since process start)
+    uint64_t heapAllocations = 0;
+    uint64_t heapBytes = 0;
+    int64_t peakRssKiB = -1;
+
+    // Sizes of the pipeline's data structures (stage-by-stage runs)
+    size_t keypointBytesReference = 0;    // std::vector<cv::KeyPoint> capacity
+    size_t keypointBytesRegistered = 0;
+    size_t descriptorBytesReference = 0;  // descriptor matrix
+    size_t descriptorBytesRegistered = 0;
+    size_t indexBytes = 0;                // heap allocated building the FLANN index over the registered descriptors
+    size_t matchBytes = 0;                // 2-NN result arrays
+
+    // Memory per stage of stage-by-stage runs, from the last repetition; one per timedStages() entry,
+    // the total summing the measured stages
+    std::vector<StageMemory> stageMemory;
+
     cv::Mat homography;  // Estimated homography matrix
     cv::Mat baselineH;
 
@@ -127,8 +218,93 @@ struct StitchingMetrics {
     bool stitchingSuccess = false;
     std::string failureReason;
 
+    // Time budget of the stitch (--budget), 0 when unlimited, and the degradations applied to meet it
+    double budgetSeconds = 0.0;
+    std::string degradations; // "; "-separated, empty if the stitch ran in full
+
+    // Fallback ladder (--escalate): level that registered the pair (0: the plain run, -1: every level tried
+    // failed), the levels tried in order, and the time they took (included in the stage and total times)
+    int escalationLevel = 0;
+    std::vector<int> escalationLevelsTried;
+    double escalationTime = 0.0;
+
+    // Per window size breakdown of LP detectors, ascending window sizes (empty for other detectors)
+    std::vector<WindowSizeStats> windowSizeStats;
+
     // Quality metrics (optional)
     double reprojectionError = 0.0;
+    // Mean corner distance (full-resolution px) from the true homography of a synthetic set, -1 without one
+    double cornerError = -1.0;
+
+    // LP candidate filtering (LP detectors only; candidates == keypoints when filtering is off)
+    int numCandidatesReference = 0;
+    int numCandidatesRegistered = 0;
+    int numBorderRejectedReference = 0;
+    int numBorderRejectedRegistered = 0;
+    int numPrunedReference = 0;
+    int numPrunedRegistered = 0;
+    double pruneTime = 0.0;               // both images, included in the detection times
+    double estimatedPruneTimeSaved = 0.0; // downstream time the removed points would have cost, minus pruneTime
+
+    // Fraction of LP candidates removed by contrast/edge pruning over both images
+    double getPrunedFraction() const {
+        const int candidates = numCandidatesReference + numCandidatesRegistered;
+        if (candidates == 0) return 0.0;
+        return static_cast<double>(numPrunedReference + numPrunedRegistered) / candidates;
+    }
+
+    // Fraction of LP candidates rejected as tile-border pseudo-peaks over both images
+    double getBorderRejectedFraction() const {
+        const int candidates = numCandidatesReference + numCandidatesRegistered;
+        if (candidates == 0) return 0.0;
+        return static_cast<double>(numBorderRejectedReference + numBorderRejectedRegistered) / candidates;
+    }
+
+    // Estimate the time candidate filtering saved, assuming descriptor, matching and RANSAC cost is linear in keypoints
+    void estimatePruneSavings() {
+        const int kept = numKeypointsReference + numKeypointsRegistered;
+        const int pruned = numPrunedReference + numPrunedRegistered +
+                           numBorderRejectedReference + numBorderRejectedRegistered;
+        if (kept == 0 || pruned == 0) return;
+        const double downstream = descriptorTimeReference + descriptorTimeRegistered + matchingTime + homographyTime;
+        estimatedPruneTimeSaved = downstream * pruned / kept - pruneTime;
+    }
+
+    // Streaming mode (LP detectors with --stream): scales matched before the pipeline stopped
+    int scalesProcessed = 0;
+    int scalesTotal = 0;
+    bool earlyStopped = false; // confident homography reached before the finest scale
+
+    // Repeated runs (--warmup / --repeat): the timing fields above hold per-stage medians over the
+    // measured repetitions, everything else comes from the last repetition
+    int warmupRuns = 0;
+    int repetitions = 1;
+    std::vector<TimingStats> stageStats; // one per timedStages() entry; empty for cached baselines
+
+    // Hardware counters (--perf-counters) of the stitching thread, from the last repetition; one per
+    // timedStages() entry, the total being the sum of the measured stages. Empty unless stage-by-stage
+    std::vector<PerfSample> stageCounters;
+
+    // Task-graph pipeline (--concurrent-stages): executed stages, seconds from the pipeline start
+    std::vector<TaskSpan> stageSpans;
+
+    // Share of the time budget a stage (or the total) used, -1 without a budget
+    double getBudgetShare(const double seconds) const {
+        return budgetSeconds > 0.0 ? seconds / budgetSeconds : -1.0;
+    }
+
+    // Sum of the individual stage times; exceeds totalStitchingTime when stages overlap
+    double getSummedStageTime() const {
+        return detectionTimeReference + detectionTimeRegistered +
+               descriptorTimeReference + descriptorTimeRegistered +
+               matchingTime + homographyTime + warpingTime;
+    }
+
+    // Summed stage time over wall-clock time (1.0 = fully sequential)
+    double getStageOverlap() const {
+        if (totalStitchingTime <= 0.0) return 0.0;
+        return getSummedStageTime() / totalStitchingTime;
+    }
 
     // Get resolution string
     std::string getReferenceResolution() const {
@@ -172,39 +348,66 @@ struct StitchingMetrics {
     }
 };
 
+// A stage timing summarized over repetitions: CSV column prefix, JSON key and metrics field
+struct TimedStage {
+    const char* label;
+    const char* key;
+    double StitchingMetrics::* seconds;
+};
+
+// Stages with repetition statistics, in StitchingMetrics::stageStats order
+inline const std::vector<TimedStage>& timedStages() {
+    static const std::vector<TimedStage> stages = {
+        {"Detection Ref", "detection_reference", &StitchingMetrics::detectionTimeReference},
+        {"Detection Reg", "detection_registered", &StitchingMetrics::detectionTimeRegistered},
+        {"Descriptor Ref", "descriptor_reference", &StitchingMetrics::descriptorTimeReference},
+        {"Descriptor Reg", "descriptor_registered", &StitchingMetrics::descriptorTimeRegistered},
+        {"Matching", "matching", &StitchingMetrics::matchingTime},
+        {"Homography", "homography", &StitchingMetrics::homographyTime},
+        {"Warping", "warping", &StitchingMetrics::warpingTime},
+        {"Total Stitching", "total_stitching", &StitchingMetrics::totalStitchingTime},
+    };
+    return stages;
+}
+
 // ============================================================================
-// Timer - High-resolution timer for benchmarking
+// Timer - Monotonic timer for benchmarking (nanosecond resolution)
 // ============================================================================
 
 class Timer {
 public:
     void start() {
-        startTime_ = std::chrono::high_resolution_clock::now();
+        startTime_ = std::chrono::steady_clock::now();
     }
 
     void stop() {
-        endTime_ = std::chrono::high_resolution_clock::now();
+        endTime_ = std::chrono::steady_clock::now();
+    }
+
+    int64_t elapsedNanoseconds() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(endTime_ - startTime_).count();
     }
 
     double elapsedSeconds() const {
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime_ - startTime_);
-        return duration.count() / 1000000.0;
+        return elapsedNanoseconds() / 1e9;
     }
 
     double elapsedMilliseconds() const {
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(endTime_ - startTime_);
-        return duration.count() / 1000.0;
+        return elapsedNanoseconds() / 1e6;
     }
 
 private:
-    std::chrono::high_resolution_clock::time_point startTime_;
-    std::chrono::high_resolution_clock::time_point endTime_;
+    std::chrono::steady_clock::time_point startTime_;
+    std::chrono::steady_clock::time_point endTime_;
 };
 
 // ============================================================================
 // CSVExporter - Exports benchmark results to CSV format
 // ============================================================================
 
+/** @brief First of base+extension, base_1+extension, base_2+extension, ... that does not exist yet. */
+void findAvailableFileName(std::string baseName, std::string extension, std::string& ref);
+
 class CSVExporter {
 public:
     explicit CSVExporter(const std::string& filename) : filename_(filename) {}
@@ -213,6 +416,27 @@ public:
     void writeMetrics(const StitchingMetrics& m);
     void writeAllMetrics(const std::vector<StitchingMetrics>& metrics);
 
+    // File actually written (a free results_N.csv name is picked by writeAllMetrics)
+    const std::string& filename() const { return filename_; }
+
+private:
+    // One row per (result, LP window size) in <results>_windows.csv; skipped when no result has a breakdown
+    void writeWindowSizeMetrics(const std::vector<StitchingMetrics>& metrics);
+
+    std::string filename_;
+};
+
+// ============================================================================
+// JSONExporter - Exports per-stage repetition statistics as JSON
+// ============================================================================
+
+class JSONExporter {
+public:
+    explicit JSONExporter(const std::string& filename) : filename_(filename) {}
+
+    // One object per result: identification, counts and {stage: timing statistics in nanoseconds}
+    void writeAllMetrics(const std::vector<StitchingMetrics>& metrics);
+
 private:
     std::string filename_;
 };
@@ -238,11 +462,39 @@ public:
         bool SURF;
         bool LPSIFT;
         bool LPORB;
+        bool LPDOG;
+    };
+
+    // Benchmark-wide options set from the command line
+    struct Options {
+        bool pruneCandidates = false; // --prune: contrast/edge pruning in the LP detectors
+        bool checkBorderPeaks = false; // --border-check: reject tile-border pseudo-peaks in the LP detectors
+        bool denseDetection = false;   // --dense: overlapping LP windows at stride L/2 instead of the grid
+        bool streamScales = false;     // --stream: pipeline LP detection, description and matching per scale
+        bool concurrentStages = false; // --concurrent-stages: run both images' stages concurrently on a task graph
+        bool prefetchImages = true;    // --no-prefetch: decode each image set only when it is benchmarked
+        bool throughputMode = false;   // --throughput: run (dataset, detector) jobs concurrently on the pool
+        bool pinThreads = false;       // --pin: pin each throughput job's worker thread to its own core
+        int ingestReduction = 1;       // --ingest-scale: decode images at 1/2, 1/4 or 1/8 resolution
+        bool cameraFrames = false;     // --ingest nv12: ingest NV12 camera frames (Y plane used in place)
+        std::string featureStorePath;  // --save-features: append registered pairs' features to this file
+        std::string baselineCacheDir = "baseline_cache"; // SIFT baseline cache; empty with --no-baseline-cache
+        bool refreshBaseline = false;  // --refresh-baseline: rerun SIFT and overwrite the cached baseline
+        bool poolMats = false;         // --mat-pool: serve each stitch's cv::Mat buffers from a reused pool
+        int warmupRuns = 0;            // --warmup: untimed runs of each stitch before the measured ones
+        int repetitions = 1;           // --repeat: measured runs of each stitch
+        bool perfCounters = false;     // --perf-counters: hardware counters and thread CPU time per stage
+        bool memStats = false;         // --mem-stats: sample the RSS high-water mark per stage and stitch
+        std::string tracePath;         // --trace: write a Chrome trace of the stages and worker threads here
+        unsigned threads = 0;          // threads running stitches (0: one per hardware thread); set by --scaling
+        double budgetMs = 0.0;         // --budget: time budget per stitch (0: unlimited); SIFT baselines run in full
+        bool escalate = false;         // --escalate: retry failed LP registrations up the fallback ladder
     };
 
     cv::Mat baselineH;
 
     BenchmarkRunner() = default;
+    explicit BenchmarkRunner(const Options& options) : options_(options) {}
 
     // Add a detector to benchmark
     void addDetector(const std::string& name,
@@ -255,17 +507,37 @@ public:
     // Run benchmark on a single image pair
     StitchingMetrics runSingleBenchmark(
         const std::string& datasetName,
-        const cv::Mat& referenceImg,
-        const cv::Mat& registeredImg,
+        const IngestedImage& referenceImg,
+        const IngestedImage& registeredImg,
         const DetectorConfig& config,
 		const vector<int>& lpsiftWindowSizes,
         const std::string& outputPath);
 
+    // Run the stitching stages as a task graph on the shared pool: both images are detected and
+    // described concurrently, then match -> homography -> color decode -> warp
+    StitchingMetrics runConcurrentBenchmark(
+        const std::string& datasetName,
+        const IngestedImage& referenceImg,
+        const IngestedImage& registeredImg,
+        const DetectorConfig& config,
+        const vector<int>& lpsiftWindowSizes,
+        const std::string& outputPath);
+
+    // Run an LP detector as a coarse-to-fine pipeline: one producer thread per image detects and
+    // describes each scale while this thread matches it, stopping once the homography is confident
+    StitchingMetrics runStreamingBenchmark(
+        const std::string& datasetName,
+        const IngestedImage& referenceImg,
+        const IngestedImage& registeredImg,
+        const DetectorConfig& config,
+        const vector<int>& lpsiftWindowSizes,
+        const std::string& outputPath);
+
     // Run benchmark on all detectors for a single image pair
     std::vector<StitchingMetrics> runAllDetectors(
         const std::string& datasetName,
-        const cv::Mat& referenceImg,
-        const cv::Mat& registeredImg,
+        const IngestedImage& referenceImg,
+        const IngestedImage& registeredImg,
 		const vector<int>& lpsiftWindowSizes,
         const std::string& outputPath
         );
@@ -277,14 +549,63 @@ public:
 		const map<string, DetectorFilter>& filteredDetectors,
         const string& outputPath);
 
+    // Execution mode label written to the console and CSV
+    std::string executionMode() const;
+
     // Print summary table (similar to paper's Table 2)
     static void printSummaryTable(const std::vector<StitchingMetrics>& results);
 
-private:
-    std::vector<DetectorConfig> detectors_;
+    // Print fraction of LP candidates border-rejected/pruned and estimated time saved per dataset
+    static void printPruningSummary(const std::vector<StitchingMetrics>& results);
+
+    // Print each LP window size's share of keypoints, inliers and detection time per detector
+    static void printWindowSizeSummary(const std::vector<StitchingMetrics>& results);
+
+    // Print each budgeted stitch's share of the budget per stage and the degradations applied
+    static void printBudgetSummary(const std::vector<StitchingMetrics>& results);
+
+    // Print per detector how many stitches each ladder level was tried on and registered (--escalate)
+    static void printEscalationSummary(const std::vector<StitchingMetrics>& results);
+
+    // Print corner reprojection error against the true homography of synthetic sets (css587synth)
+    static void printGroundTruthSummary(const std::vector<StitchingMetrics>& results);
+
+    // Match desc1 (query) against desc2 (train) as the pipeline does: FLANN 2-NN with the ratio test,
+    // or BFMatcher 1-NN; throws if the brute-force matcher exceeds its size limit.
+    // indexBytes, if given, receives the heap bytes allocated building the FLANN index (0 for brute force).
+    // proceed, if given, is asked between FLANN query batches and stops matching when it returns false
+    static void matchDescriptors(const DetectorConfig& config,
+                                 const cv::Mat& desc1,
+                                 const cv::Mat& desc2,
+                                 KnnMatches& matches,
+                                 size_t* indexBytes = nullptr,
+                                 const std::function<bool()>& proceed = nullptr);
 
     // Warp and blend images using homography
     static cv::Mat warpAndBlend(const cv::Mat& img1, const cv::Mat& img2, const cv::Mat& H);
+
+private:
+    Options options_;
+    std::vector<DetectorConfig> detectors_;
+    std::shared_ptr<ThreadPool> pool_; // created on first use with --concurrent-stages
+    std::unique_ptr<FeatureStoreWriter> featureWriter_; // opened by runOnDirectory with --save-features
+    std::mutex featureMutex_;                           // throughput jobs append concurrently
+    std::vector<std::unique_ptr<PooledMatAllocator>> matPools_; // --mat-pool: [0] calling thread, [1 + i] worker i
+
+    // Run one stitch inside a MatPoolScope and record its Mat allocations and page faults
+    StitchingMetrics runWithMatScope(const std::function<StitchingMetrics()>& stitch);
+
+    // Run a stitch for the warm-up and measured repetitions and summarize the stage timings;
+    // only the last repetition writes the stitched image and features
+    StitchingMetrics runRepeated(const std::function<StitchingMetrics()>& stitch);
+
+    // Append one image's features to the feature store as "<dataset>/<detector>/<image>" (no-op without one);
+    // a write error is reported as a warning, it does not fail the stitch
+    void saveFeatures(const std::string& datasetName,
+                      const DetectorConfig& config,
+                      const std::string& imageName,
+                      const std::vector<cv::KeyPoint>& keypoints,
+                      const cv::Mat& descriptors);
 };
 
 #endif // BENCHMARK_H
@@ -0,0 +1,71 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * benchstats.cpp
+ * Summary statistics of repeated timing measurements.
+ */
+
+#include "benchstats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+// Same seed as the RANSAC runs, so reruns on the same samples report the same interval
+constexpr unsigned BOOTSTRAP_SEED = 12345;
+
+int64_t roundNs(const double ns) {
+    return static_cast<int64_t>(std::llround(ns));
+}
+
+} // anonymous namespace
+
+double percentile(const std::vector<int64_t>& sorted, const double p) {
+    if (sorted.size() == 1) return static_cast<double>(sorted.front());
+
+    const double rank = std::clamp(p, 0.0, 100.0) / 100.0 * (sorted.size() - 1);
+    const size_t lower = static_cast<size_t>(rank);
+    const size_t upper = std::min(lower + 1, sorted.size() - 1);
+    const double fraction = rank - lower;
+    return sorted[lower] + fraction * (sorted[upper] - sorted[lower]);
+}
+
+TimingStats computeTimingStats(std::vector<int64_t> samplesNs, const double confidence, const int resamples) {
+    TimingStats stats;
+    stats.samples = samplesNs.size();
+    if (samplesNs.empty()) return stats;
+
+    std::sort(samplesNs.begin(), samplesNs.end());
+    stats.minNs = samplesNs.front();
+    stats.medianNs = roundNs(percentile(samplesNs, 50.0));
+    stats.p90Ns = roundNs(percentile(samplesNs, 90.0));
+    stats.p99Ns = roundNs(percentile(samplesNs, 99.0));
+
+    if (samplesNs.size() == 1 || resamples <= 0) {
+        stats.ciLowNs = stats.ciHighNs = stats.medianNs;
+        return stats;
+    }
+
+    // Percentile bootstrap: medians of resamples drawn with replacement
+    std::mt19937 rng(BOOTSTRAP_SEED);
+    std::uniform_int_distribution<size_t> pick(0, samplesNs.size() - 1);
+    std::vector<int64_t> resample(samplesNs.size());
+    std::vector<int64_t> medians(static_cast<size_t>(resamples));
+
+    for (auto& median : medians) {
+        for (auto& value : resample) {
+            value = samplesNs[pick(rng)];
+        }
+        std::sort(resample.begin(), resample.end());
+        median = roundNs(percentile(resample, 50.0));
+    }
+    std::sort(medians.begin(), medians.end());
+
+    const double tail = (1.0 - confidence) / 2.0 * 100.0;
+    stats.ciLowNs = roundNs(percentile(medians, tail));
+    stats.ciHighNs = roundNs(percentile(medians, 100.0 - tail));
+    return stats;
+}
@@ -0,0 +1,45 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * benchstats.h
+ * Summary statistics of repeated timing measurements (--warmup / --repeat).
+ */
+
+#ifndef BENCHSTATS_H
+#define BENCHSTATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bootstrap resamples for the confidence interval of the median
+constexpr int BOOTSTRAP_RESAMPLES = 2000;
+constexpr double BOOTSTRAP_CONFIDENCE = 0.95;
+
+// Statistics of one stage's repetitions, in nanoseconds
+struct TimingStats {
+    size_t samples = 0;
+    int64_t minNs = 0;
+    int64_t medianNs = 0;
+    int64_t p90Ns = 0;
+    int64_t p99Ns = 0;
+    int64_t ciLowNs = 0;  // bootstrap confidence interval of the median
+    int64_t ciHighNs = 0;
+};
+
+/** @brief Linear-interpolated percentile of sorted samples.
+ *  @param sorted Samples in ascending order (not empty).
+ *  @param p Percentile in [0, 100].
+ */
+double percentile(const std::vector<int64_t>& sorted, double p);
+
+/** @brief Min, median, p90, p99 and a percentile-bootstrap confidence interval of the median.
+ *  The bootstrap uses a fixed seed, so the same samples always give the same interval.
+ *  @param samplesNs Measurements in nanoseconds; empty gives all-zero statistics.
+ */
+TimingStats computeTimingStats(std::vector<int64_t> samplesNs,
+                               double confidence = BOOTSTRAP_CONFIDENCE,
+                               int resamples = BOOTSTRAP_RESAMPLES);
+
+#endif //BENCHSTATS_H
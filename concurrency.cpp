@@ -0,0 +1,354 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * concurrency.cpp
+ * Work-stealing thread pool, OpenCV parallel backend adapter and task-graph executor.
+ */
+
+#include "concurrency.h"
+#include "trace.h"
+
+#include <opencv2/core.hpp>
+
+#if __has_include(<opencv2/core/parallel/parallel_backend.hpp>)
+#include <opencv2/core/parallel/parallel_backend.hpp>
+#define LP_HAVE_OPENCV_PARALLEL_BACKEND 1
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+// Pool and worker index of the calling thread (null/-1 outside any pool)
+thread_local const ThreadPool* tlsPool = nullptr;
+thread_local int tlsWorker = -1;
+
+#ifdef LP_HAVE_OPENCV_PARALLEL_BACKEND
+// parallel_for_ backend that runs OpenCV's stripes as pool tasks
+class ThreadPoolParallelBackend final : public cv::parallel::ParallelForAPI {
+public:
+    explicit ThreadPoolParallelBackend(std::shared_ptr<ThreadPool> pool) : pool_(std::move(pool)) {}
+
+    void parallel_for(const int tasks, FN_parallel_for_body_cb_t body_callback, void* callback_data) override {
+        pool_->parallelFor(tasks, [&](const int begin, const int end) {
+            body_callback(begin, end, callback_data);
+        });
+    }
+
+    // The thread calling parallel_for helps as thread 0; workers are 1..size()
+    int getThreadNum() const override { return pool_->currentWorker() + 1; }
+    int getNumThreads() const override { return static_cast<int>(pool_->size()) + 1; }
+
+    // The pool size is fixed when it is created
+    int setNumThreads(int) override { return getNumThreads(); }
+
+    const char* getName() const override { return "lp-threadpool"; }
+
+private:
+    std::shared_ptr<ThreadPool> pool_;
+};
+#endif
+
+} // anonymous namespace
+
+// ============================================================================
+// ThreadPool Implementation
+// ============================================================================
+
+ThreadPool::ThreadPool(unsigned numThreads) {
+    if (numThreads == 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned i = 0; i < numThreads; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (unsigned i = 0; i < numThreads; ++i) {
+        threads_.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(Task task) {
+    const int self = currentWorker();
+    const unsigned target = self >= 0 ? static_cast<unsigned>(self)
+                                      : nextQueue_.fetch_add(1, std::memory_order_relaxed) % size();
+    {
+        // Count the task before it becomes visible, so a thief's decrement never precedes it
+        std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+        ++pending_;
+        queues_[target]->tasks.push_back(std::move(task));
+    }
+    {
+        // A worker testing pending_ under this mutex is either asleep by now or sees the task
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+    }
+    wake_.notify_one();
+}
+
+bool ThreadPool::runPendingTask() {
+    const int self = currentWorker();
+    Task task;
+    if (!takeTask(self >= 0 ? static_cast<unsigned>(self) : 0, task)) return false;
+    task();
+    return true;
+}
+
+bool ThreadPool::takeTask(const unsigned preferred, Task& task) {
+    const unsigned n = size();
+
+    // Own deque from the back (most recently pushed, likely still in cache)
+    {
+        WorkerQueue& own = *queues_[preferred];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            --pending_;
+            return true;
+        }
+    }
+
+    // Steal the oldest task of another worker
+    for (unsigned k = 1; k < n; ++k) {
+        WorkerQueue& victim = *queues_[(preferred + k) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            --pending_;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::workerLoop(const unsigned index) {
+    tlsPool = this;
+    tlsWorker = static_cast<int>(index);
+    trace::setThreadName("worker " + std::to_string(index));
+
+    while (true) {
+        Task task;
+        if (takeTask(index, task)) {
+            trace::Span span("pool task"); // gaps between these are idle time
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wake_.wait(lock, [this] { return stopping_ || pending_ > 0; });
+        if (stopping_ && pending_ == 0) return;
+    }
+}
+
+void ThreadPool::parallelFor(const int n, const std::function<void(int begin, int end)>& body) {
+    if (n <= 0) return;
+    if (n == 1 || threads_.empty()) {
+        body(0, n);
+        return;
+    }
+
+    std::atomic<int> remaining{n};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto runChunk = [&](const int i) {
+        try {
+            body(i, i + 1);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) error = std::current_exception();
+        }
+        remaining.fetch_sub(1, std::memory_order_release); // last access to this frame
+    };
+
+    for (int i = 1; i < n; ++i) {
+        submit([&runChunk, i] { runChunk(i); });
+    }
+    runChunk(0);
+
+    // Help instead of blocking: the chunks may be queued behind this thread's own work
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (!runPendingTask()) std::this_thread::yield();
+    }
+
+    if (error) std::rethrow_exception(error);
+}
+
+int ThreadPool::currentWorker() const {
+    return tlsPool == this ? tlsWorker : -1;
+}
+
+void setOpenCVParallelBackend(const std::shared_ptr<ThreadPool>& pool) {
+#ifdef LP_HAVE_OPENCV_PARALLEL_BACKEND
+    cv::parallel::setParallelForBackend(std::make_shared<ThreadPoolParallelBackend>(pool), false);
+#else
+    CV_UNUSED(pool);
+#endif
+}
+
+void resetOpenCVParallelBackend() {
+#ifdef LP_HAVE_OPENCV_PARALLEL_BACKEND
+    // A null backend makes parallel_for_ use the framework OpenCV was built with again
+    cv::parallel::setParallelForBackend(std::shared_ptr<cv::parallel::ParallelForAPI>(), true);
+#endif
+}
+
+bool pinCurrentThread(const unsigned core) {
+#ifdef __linux__
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core % cores, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    CV_UNUSED(core);
+    return false;
+#endif
+}
+
+// ============================================================================
+// TaskGraph Implementation
+// ============================================================================
+
+TaskGraph::TaskId TaskGraph::add(std::string name,
+                                 std::function<bool()> fn,
+                                 const std::vector<TaskId>& dependencies) {
+    const TaskId id = nodes_.size();
+    for (const TaskId dep : dependencies) {
+        CV_Assert(dep < id);
+        nodes_[dep].dependents.push_back(id);
+    }
+    const char* traceName = trace::enabled() ? trace::intern(name) : nullptr;
+    nodes_.push_back({std::move(name), traceName, std::move(fn), dependencies, {}});
+    return id;
+}
+
+std::vector<TaskSpan> TaskGraph::run(ThreadPool& pool) {
+    const size_t n = nodes_.size();
+    std::vector<TaskSpan> spans;
+    if (n == 0) return spans;
+
+    struct State {
+        std::atomic<size_t> waiting{0};
+        std::atomic<bool> skip{false};
+    };
+    const std::unique_ptr<State[]> state(new State[n]);
+    for (size_t i = 0; i < n; ++i) {
+        state[i].waiting = nodes_[i].dependencies.size();
+    }
+
+    std::atomic<size_t> finished{0};
+    std::mutex mutex; // guards spans and error
+    std::exception_ptr error;
+    const auto t0 = std::chrono::steady_clock::now();
+    auto elapsed = [t0] {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    };
+
+    std::function<void(TaskId)> execute;
+    std::function<void(TaskId, bool)> complete = [&](const TaskId id, const bool ok) {
+        for (const TaskId dep : nodes_[id].dependents) {
+            if (!ok) state[dep].skip = true;
+            if (state[dep].waiting.fetch_sub(1) != 1) continue;
+            if (state[dep].skip) {
+                complete(dep, false);
+            } else {
+                pool.submit([&execute, dep] { execute(dep); });
+            }
+        }
+        finished.fetch_add(1, std::memory_order_release); // last access to this frame
+    };
+
+    execute = [&](const TaskId id) {
+        TaskSpan span;
+        span.name = nodes_[id].name;
+        span.worker = pool.currentWorker();
+        span.start = elapsed();
+        trace::Span traceSpan(nodes_[id].traceName); // null when tracing is off: records nothing
+
+        bool ok = false;
+        try {
+            ok = nodes_[id].fn();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) error = std::current_exception();
+        }
+
+        traceSpan.end();
+        span.end = elapsed();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            spans.push_back(std::move(span));
+        }
+        complete(id, ok);
+    };
+
+    for (TaskId id = 0; id < n; ++id) {
+        if (nodes_[id].dependencies.empty()) {
+            pool.submit([&execute, id] { execute(id); });
+        }
+    }
+
+    while (finished.load(std::memory_order_acquire) < n) {
+        if (!pool.runPendingTask()) std::this_thread::yield();
+    }
+
+    if (error) std::rethrow_exception(error);
+    return spans;
+}
+
+std::vector<TaskSpan> TaskGraph::run() {
+    std::vector<TaskSpan> spans;
+    std::vector<bool> failed(nodes_.size(), false);
+    std::exception_ptr error;
+    const auto t0 = std::chrono::steady_clock::now();
+    auto elapsed = [t0] {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    };
+
+    for (TaskId id = 0; id < nodes_.size(); ++id) {
+        const Node& node = nodes_[id];
+        const bool skip = std::any_of(node.dependencies.begin(), node.dependencies.end(),
+                                      [&failed](const TaskId dep) { return failed[dep]; });
+        if (skip) {
+            failed[id] = true;
+            continue;
+        }
+
+        TaskSpan span;
+        span.name = node.name;
+        span.start = elapsed();
+        try {
+            failed[id] = !node.fn();
+        } catch (...) {
+            failed[id] = true;
+            if (!error) error = std::current_exception();
+        }
+        span.end = elapsed();
+        spans.push_back(std::move(span));
+    }
+
+    if (error) std::rethrow_exception(error);
+    return spans;
+}
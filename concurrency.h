@@ -0,0 +1,265 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * concurrency.h
+ * Threading utilities used by the pipelined benchmark modes:
+ *  - BoundedQueue: blocking producer/consumer queue with backpressure
+ *  - ThreadPool: work-stealing pool shared by the stitching task graph and OpenCV's parallel_for_
+ *  - TaskGraph: tasks with explicit dependencies, executed on the pool with per-task spans
+ *  - Deadline: time budget and cancellation token checked by the stages of a budgeted stitch
+ */
+
+#ifndef CONCURRENCY_H
+#define CONCURRENCY_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * BoundedQueue - Blocking FIFO with a fixed capacity connecting a producer thread to a consumer.
+ * push() blocks while the queue is full, giving backpressure to a producer that runs ahead.
+ * close() wakes all waiters: further pushes fail, and pops drain the remaining items and then fail.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(const size_t capacity) : capacity_(capacity > 0 ? capacity : 1) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /** @brief Append an item, waiting while the queue is full.
+     *  @return False if the queue was closed (the item is dropped).
+     */
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notFull_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+        if (closed_) return false;
+        items_.push_back(std::move(item));
+        lock.unlock();
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    /** @brief Remove the oldest item, waiting while the queue is empty.
+     *  @return The item, or std::nullopt once the queue is closed and drained.
+     */
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+        if (items_.empty()) return std::nullopt;
+        T item = std::move(items_.front());
+        items_.pop_front();
+        lock.unlock();
+        notFull_.notify_one();
+        return item;
+    }
+
+    /** @brief Stop accepting items and wake every blocked producer and consumer. */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        notFull_.notify_all();
+        notEmpty_.notify_all();
+    }
+
+    bool closed() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return closed_;
+    }
+
+private:
+    const size_t capacity_;
+    std::deque<T> items_;
+    bool closed_ = false;
+    mutable std::mutex mutex_;
+    std::condition_variable notFull_;
+    std::condition_variable notEmpty_;
+};
+
+/*
+ * ThreadPool - Work-stealing thread pool.
+ * Each worker owns a deque: it pushes and pops its own tasks at the back (LIFO, cache-warm) and
+ * steals from the front of the other workers' deques when it runs dry. Threads that wait on pool
+ * work (parallelFor, TaskGraph::run) execute pending tasks instead of blocking, so nested
+ * parallel regions cannot deadlock the pool.
+ */
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    /** @brief Start the workers.
+     *  @param numThreads Worker count; 0 uses std::thread::hardware_concurrency().
+     */
+    explicit ThreadPool(unsigned numThreads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /** @brief Queue a task. From a worker it goes to that worker's own deque, otherwise round-robin. */
+    void submit(Task task);
+
+    /** @brief Run one queued task on the calling thread.
+     *  @return False if no task was available.
+     */
+    bool runPendingTask();
+
+    /** @brief Run body over [0, n) split into n single-index chunks, helping until all have finished.
+     *  The first exception thrown by a chunk is rethrown after the others complete.
+     */
+    void parallelFor(int n, const std::function<void(int begin, int end)>& body);
+
+    /** @brief Number of worker threads. */
+    unsigned size() const { return static_cast<unsigned>(queues_.size()); }
+
+    /** @brief Index of the calling worker of this pool, or -1 for any other thread. */
+    int currentWorker() const;
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> pending_{0};
+    std::atomic<unsigned> nextQueue_{0};
+    std::atomic<bool> stopping_{false};
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+
+    bool takeTask(unsigned preferred, Task& task);
+    void workerLoop(unsigned index);
+};
+
+/** @brief Route OpenCV's parallel_for_ through the pool, so OpenCV kernels and pipeline tasks share
+ *  one set of threads instead of oversubscribing the cores. No-op on OpenCV builds without the
+ *  pluggable parallel backend API (< 4.5.3).
+ *  @param pool Pool to use; it must outlive all OpenCV calls made afterwards.
+ */
+void setOpenCVParallelBackend(const std::shared_ptr<ThreadPool>& pool);
+
+/** @brief Restore OpenCV's built-in parallel_for_ backend and release the pool set before. */
+void resetOpenCVParallelBackend();
+
+/** @brief Pin the calling thread to one CPU core (Linux only).
+ *  @param core Core index; taken modulo the number of hardware threads.
+ *  @return False if pinning is unsupported or failed.
+ */
+bool pinCurrentThread(unsigned core);
+
+// Execution span of one task, in seconds from the start of TaskGraph::run
+struct TaskSpan {
+    std::string name;
+    double start = 0.0;
+    double end = 0.0;
+    int worker = -1; // pool worker index, -1 for the thread that called run()
+
+    double duration() const { return end - start; }
+};
+
+/*
+ * TaskGraph - Tasks with explicit dependencies.
+ * A task returns false to fail: its dependents (transitively) are skipped. Exceptions count as failures
+ * and the first one is rethrown from run() once every task has finished or been skipped.
+ * Dependencies must refer to previously added tasks, so insertion order is a valid topological order.
+ */
+class TaskGraph {
+public:
+    using TaskId = size_t;
+
+    /** @brief Add a task.
+     *  @param name Span label.
+     *  @param fn Task body; return false to skip the dependents.
+     *  @param dependencies Tasks that must finish successfully first.
+     *  @return Id of the new task.
+     */
+    TaskId add(std::string name, std::function<bool()> fn, const std::vector<TaskId>& dependencies = {});
+
+    /** @brief Run every ready task concurrently on the pool; the calling thread helps until all are done.
+     *  @return Spans of the executed tasks, in completion order.
+     */
+    std::vector<TaskSpan> run(ThreadPool& pool);
+
+    /** @brief Run the tasks one after another on the calling thread, in insertion order.
+     *  @return Spans of the executed tasks.
+     */
+    std::vector<TaskSpan> run();
+
+private:
+    struct Node {
+        std::string name;
+        const char* traceName; // interned once here, so recording the span takes no lock
+        std::function<bool()> fn;
+        std::vector<TaskId> dependencies;
+        std::vector<TaskId> dependents;
+    };
+
+    std::vector<Node> nodes_;
+};
+
+/*
+ * Deadline - Time budget of one stitch, started at construction, doubling as a cancellation token.
+ * Stages poll it between units of work (scales, match batches) and degrade instead of overrunning.
+ * A default-constructed Deadline has no budget and never expires unless cancelled.
+ */
+class Deadline {
+public:
+    Deadline() = default;
+    explicit Deadline(const double budgetSeconds)
+        : budget_(budgetSeconds > 0.0 ? budgetSeconds : 0.0), start_(std::chrono::steady_clock::now()) {}
+
+    Deadline(const Deadline&) = delete;
+    Deadline& operator=(const Deadline&) = delete;
+
+    /** @brief Expire the deadline now; safe to call from any thread. */
+    void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+
+    /** @brief Leave seconds of work outside the budget (e.g. the color decode) out of the elapsed time.
+     *  Not synchronized: call it from the thread that owns the stitch while no stage polls.
+     */
+    void discount(const double seconds) {
+        start_ += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(seconds));
+    }
+
+    bool limited() const { return budget_ > 0.0; }
+    bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+    double budgetSeconds() const { return budget_; }
+
+    double elapsedSeconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+    /** @brief True once cancelled or, with a budget, once the budget is spent. */
+    bool expired() const { return pastShare(1.0); }
+
+    /** @brief True once cancelled or, with a budget, once more than share of it is spent.
+     *  Stages compare against the cumulative share the schedule gives them.
+     */
+    bool pastShare(const double share) const {
+        return cancelled() || (limited() && elapsedSeconds() >= share * budget_);
+    }
+
+private:
+    double budget_ = 0.0;
+    std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();
+    std::atomic<bool> cancelled_{false};
+};
+
+#endif //CONCURRENCY_H
@@ -0,0 +1,153 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * escalation.cpp
+ * Fallback ladder building blocks: homography sanity check, finer and dense LP detectors, keypoint
+ * deduplication and overlap prediction.
+ */
+
+#include "escalation.h"
+#include "lpsift.h"
+#include "lporb.h"
+#include "lpdog.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <tuple>
+
+using namespace cv;
+
+std::string escalationLevelName(const EscalationLevel level) {
+    switch (level) {
+        case EscalationLevel::None: return "none";
+        case EscalationLevel::FinerScales: return "finer scales";
+        case EscalationLevel::DenseStride: return "dense stride";
+        case EscalationLevel::Orientation: return "orientation";
+        case EscalationLevel::SiftOverlap: return "SIFT in overlap";
+    }
+    return "unknown";
+}
+
+bool isDegenerateHomography(const Mat& H, const Size& registeredSize, const int inliers) {
+    if (H.empty() || inliers < ESCALATION_MIN_INLIERS) return true;
+
+    Mat h;
+    H.convertTo(h, CV_64F);
+    if (std::abs(h.at<double>(2, 2)) < 1e-12) return true;
+    h /= h.at<double>(2, 2);
+
+    // Area change of the affine part; a negative determinant mirrors the image
+    const double det = h.at<double>(0, 0) * h.at<double>(1, 1) - h.at<double>(0, 1) * h.at<double>(1, 0);
+    if (!(det > 1.0 / ESCALATION_MAX_AREA_CHANGE && det < ESCALATION_MAX_AREA_CHANGE)) return true;
+
+    const std::vector<Point2f> corners = {
+        Point2f(0.0f, 0.0f),
+        Point2f(static_cast<float>(registeredSize.width), 0.0f),
+        Point2f(static_cast<float>(registeredSize.width), static_cast<float>(registeredSize.height)),
+        Point2f(0.0f, static_cast<float>(registeredSize.height))
+    };
+    for (const auto& c : corners) {
+        // A corner mapped through the horizon folds the warped image
+        if (h.at<double>(2, 0) * c.x + h.at<double>(2, 1) * c.y + h.at<double>(2, 2) <= 0.0) return true;
+    }
+    std::vector<Point2f> warped;
+    perspectiveTransform(corners, warped, h);
+    return !isContourConvex(warped);
+}
+
+std::vector<int> finerWindowSizes(const std::vector<int>& windowSizes) {
+    std::vector<int> finer;
+    if (windowSizes.empty()) return finer;
+
+    int windowSize = *std::min_element(windowSizes.begin(), windowSizes.end());
+    for (int i = 0; i < ESCALATION_FINER_OCTAVES; ++i) {
+        windowSize /= 2;
+        if (windowSize < ESCALATION_MIN_WINDOW_SIZE) break;
+        finer.insert(finer.begin(), windowSize);
+    }
+    return finer;
+}
+
+Ptr<Feature2D> makeLPDetector(const Ptr<Feature2D>& base, const std::vector<int>& windowSizes, const bool dense) {
+    if (const auto lpsift = base.dynamicCast<LPSIFT>()) {
+        auto detector = LPSIFT::create(windowSizes);
+        detector->setPruneParams(lpsift->getPruneParams());
+        detector->setBorderCheckParams(lpsift->getBorderCheckParams());
+        LPDenseParams denseParams = lpsift->getDenseParams();
+        denseParams.enabled = denseParams.enabled || dense;
+        detector->setDenseParams(denseParams);
+        return detector;
+    }
+    if (const auto lporb = base.dynamicCast<LPORB>()) {
+        auto detector = LPORB::create(windowSizes);
+        detector->setPruneParams(lporb->getPruneParams());
+        detector->setBorderCheckParams(lporb->getBorderCheckParams());
+        LPDenseParams denseParams = lporb->getDenseParams();
+        denseParams.enabled = denseParams.enabled || dense;
+        detector->setDenseParams(denseParams);
+        return detector;
+    }
+    if (const auto lpdog = base.dynamicCast<LPDOG>()) {
+        // DoG refinement has no dense mode
+        if (dense) return {};
+        return lpdog->withWindowSizes(windowSizes);
+    }
+    return {};
+}
+
+size_t removeKnownKeypoints(const std::vector<KeyPoint>& known, std::vector<KeyPoint>& candidates) {
+    std::set<std::tuple<int, int, int>> seen;
+    for (const auto& kp : known) {
+        seen.emplace(cvRound(kp.pt.x), cvRound(kp.pt.y), kp.class_id);
+    }
+
+    const size_t before = candidates.size();
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&seen](const KeyPoint& kp) {
+        return seen.count({cvRound(kp.pt.x), cvRound(kp.pt.y), kp.class_id}) > 0;
+    }), candidates.end());
+    return before - candidates.size();
+}
+
+bool predictOverlap(const Mat& reference, const Mat& registered, Rect& referenceRoi, Rect& registeredRoi) {
+    referenceRoi = Rect(0, 0, reference.cols, reference.rows);
+    registeredRoi = Rect(0, 0, registered.cols, registered.rows);
+    if (reference.empty() || registered.empty()) return false;
+
+    // Both images at the same scale, padded to a common size
+    const int longest = std::max({reference.cols, reference.rows, registered.cols, registered.rows});
+    const double f = std::min(1.0, static_cast<double>(OVERLAP_PREDICTION_SIZE) / longest);
+    Mat small1, small2;
+    resize(reference, small1, Size(), f, f, INTER_AREA);
+    resize(registered, small2, Size(), f, f, INTER_AREA);
+    const Size common(std::max(small1.cols, small2.cols), std::max(small1.rows, small2.rows));
+    copyMakeBorder(small1, small1, 0, common.height - small1.rows, 0, common.width - small1.cols, BORDER_CONSTANT);
+    copyMakeBorder(small2, small2, 0, common.height - small2.rows, 0, common.width - small2.cols, BORDER_CONSTANT);
+    small1.convertTo(small1, CV_32F);
+    small2.convertTo(small2, CV_32F);
+
+    Mat window;
+    createHanningWindow(window, common, CV_32F);
+    double response = 0.0;
+    const Point2d shift = phaseCorrelate(small1, small2, window, &response);
+    if (response < OVERLAP_MIN_RESPONSE) return false;
+
+    // Reference content at p appears at p + d in the registered image
+    const int dx = cvRound(shift.x / f);
+    const int dy = cvRound(shift.y / f);
+    Rect overlap1 = referenceRoi & Rect(-dx, -dy, registered.cols, registered.rows);
+    Rect overlap2 = registeredRoi & Rect(dx, dy, reference.cols, reference.rows);
+    if (overlap1.empty() || overlap2.empty()) return false;
+
+    const int margin = cvRound(OVERLAP_MARGIN * longest);
+    overlap1 = Rect(overlap1.x - margin, overlap1.y - margin, overlap1.width + 2 * margin,
+                    overlap1.height + 2 * margin) & referenceRoi;
+    overlap2 = Rect(overlap2.x - margin, overlap2.y - margin, overlap2.width + 2 * margin,
+                    overlap2.height + 2 * margin) & registeredRoi;
+    referenceRoi = overlap1;
+    registeredRoi = overlap2;
+    return true;
+}
@@ -0,0 +1,84 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * escalation.h
+ * Building blocks of the fallback ladder for failed LP registrations (--escalate). Each level keeps the
+ * features of the levels before it and adds to them:
+ *  1. finer scales: LP windows below the smallest configured size
+ *  2. dense stride: overlapping windows at stride L/2, only the keypoints the grid did not find (not LP-DoG)
+ *  3. orientation: intensity-centroid angles for all keypoints, described again rotation invariant
+ *  4. SIFT in the overlap predicted by phase correlation (added to features already described as SIFT)
+ */
+
+#ifndef ESCALATION_H
+#define ESCALATION_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+
+#include <string>
+#include <vector>
+
+// Ladder levels, cheapest first; None is the plain run
+enum class EscalationLevel {
+    None = 0,
+    FinerScales,
+    DenseStride,
+    Orientation,
+    SiftOverlap
+};
+
+constexpr int ESCALATION_LEVEL_COUNT = 5;
+
+constexpr int ESCALATION_MIN_INLIERS = 10;        // fewer RANSAC inliers make a homography degenerate
+constexpr double ESCALATION_MAX_AREA_CHANGE = 16.0; // ... as does a larger area change of the registered image
+constexpr int ESCALATION_FINER_OCTAVES = 2;       // window sizes added below the smallest one (halving)
+constexpr int ESCALATION_MIN_WINDOW_SIZE = 4;
+constexpr int ESCALATION_ORIENTATION_RADIUS = 15; // largest intensity-centroid disc (ORB uses 15)
+
+// Overlap prediction: phase correlation at this longest side, trusted above the response,
+// and the predicted overlap grown by this share of the image size (rotation and scale are not modelled)
+constexpr int OVERLAP_PREDICTION_SIZE = 512;
+constexpr double OVERLAP_MIN_RESPONSE = 0.05;
+constexpr double OVERLAP_MARGIN = 0.15;
+
+/** @brief Short name of a ladder level, as in the CSV and summary table. */
+std::string escalationLevelName(EscalationLevel level);
+
+/** @brief True if H is empty, has too few inliers, changes the registered image's area by more than
+ *  ESCALATION_MAX_AREA_CHANGE, or maps its corners to a non-convex or folded quadrilateral.
+ */
+bool isDegenerateHomography(const cv::Mat& H, const cv::Size& registeredSize, int inliers);
+
+/** @brief Window sizes below the smallest of windowSizes (halved ESCALATION_FINER_OCTAVES times, at least
+ *  ESCALATION_MIN_WINDOW_SIZE), ascending; empty if there are none.
+ */
+std::vector<int> finerWindowSizes(const std::vector<int>& windowSizes);
+
+/** @brief LP-SIFT, LP-ORB or LP-DoG detector like base (pruning, border check, DoG parameters) with other
+ *  window sizes.
+ *  @param dense Overlapping windows at stride L/2 instead of the grid.
+ *  @return Empty if base is none of the three, or for LP-DoG with dense (it has no dense mode).
+ */
+cv::Ptr<cv::Feature2D> makeLPDetector(const cv::Ptr<cv::Feature2D>& base,
+                                      const std::vector<int>& windowSizes,
+                                      bool dense);
+
+/** @brief Drop the candidates already in known (same pixel and window size), keeping their order.
+ *  @return Number of candidates dropped.
+ */
+size_t removeKnownKeypoints(const std::vector<cv::KeyPoint>& known, std::vector<cv::KeyPoint>& candidates);
+
+/** @brief Predict the overlap of the two images from the translation phase correlation finds between
+ *  downscaled copies.
+ *  @param referenceRoi Overlap in reference image coordinates.
+ *  @param registeredRoi Overlap in registered image coordinates.
+ *  @return False if the correlation peak is too weak to trust (the ROIs are then the whole images).
+ */
+bool predictOverlap(const cv::Mat& reference,
+                    const cv::Mat& registered,
+                    cv::Rect& referenceRoi,
+                    cv::Rect& registeredRoi);
+
+#endif //ESCALATION_H
@@ -0,0 +1,349 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * featurestore.cpp
+ * Memory-mapped binary feature store.
+ */
+
+#include "featurestore.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char FILE_MAGIC[8] = {'L', 'P', 'F', 'E', 'A', 'T', 'S', '\0'};
+constexpr uint32_t FORMAT_VERSION = 1;
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;     // reads back differently on the other endianness
+constexpr uint32_t RECORD_MAGIC = 0x4352504C;        // "LPRC" in little-endian byte order
+constexpr size_t ALIGNMENT = 64;                     // cache line / AVX-512 vector
+constexpr size_t NUM_KEYPOINT_FIELDS = 7;            // x, y, size, angle, response, octave, window size
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t headerBytes;
+    uint8_t reserved[44];
+};
+static_assert(sizeof(FileHeader) == ALIGNMENT, "file header must fill one aligned block");
+
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t nameBytes;
+    uint64_t recordBytes;      // header to end of padding; the next record starts here
+    uint64_t numKeypoints;
+    int32_t descriptorType;    // CV_32F or CV_8U, single channel
+    int32_t descriptorKind;    // DescriptorKind
+    uint32_t descriptorCols;
+    uint32_t reserved;
+    uint64_t descriptorStride; // bytes per descriptor row
+    uint64_t keypointOffset;   // from the record start
+    uint64_t descriptorOffset; // from the record start
+};
+static_assert(sizeof(RecordHeader) == ALIGNMENT, "record header must fill one aligned block");
+
+size_t alignUp(const size_t n) {
+    return (n + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+// Block offsets of a record, relative to its start
+struct RecordLayout {
+    size_t keypointOffset;
+    size_t descriptorOffset;
+    size_t recordBytes;
+};
+
+RecordLayout layoutRecord(const size_t nameBytes, const size_t numKeypoints, const size_t descriptorBytes) {
+    RecordLayout layout;
+    layout.keypointOffset = alignUp(sizeof(RecordHeader) + nameBytes);
+    layout.descriptorOffset = alignUp(layout.keypointOffset + NUM_KEYPOINT_FIELDS * numKeypoints * 4);
+    layout.recordBytes = alignUp(layout.descriptorOffset + descriptorBytes);
+    return layout;
+}
+
+bool validFileHeader(const FileHeader& header) {
+    return std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0 &&
+           header.byteOrder == BYTE_ORDER_MARK &&
+           header.version == FORMAT_VERSION &&
+           header.headerBytes == sizeof(FileHeader);
+}
+
+// A record header is usable if it describes a complete record within the remaining bytes
+bool validRecord(const RecordHeader& header, const size_t available) {
+    if (header.magic != RECORD_MAGIC || header.recordBytes > available) return false;
+    if (header.descriptorType != CV_32F && header.descriptorType != CV_8U) return false;
+
+    const size_t descriptorBytes = header.numKeypoints * header.descriptorStride;
+    const RecordLayout layout = layoutRecord(header.nameBytes, header.numKeypoints, descriptorBytes);
+    return layout.keypointOffset == header.keypointOffset &&
+           layout.descriptorOffset == header.descriptorOffset &&
+           layout.recordBytes == header.recordBytes;
+}
+
+// Read-only mapping of a whole file
+class FileMapping {
+public:
+    explicit FileMapping(const std::string& path) {
+#ifdef _WIN32
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot open feature file " + path);
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file_, &fileSize) || fileSize.QuadPart == 0) {
+            CloseHandle(file_);
+            throw std::runtime_error("Empty feature file " + path);
+        }
+        size_ = static_cast<size_t>(fileSize.QuadPart);
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_ != nullptr) {
+            data_ = static_cast<const unsigned char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        }
+        if (data_ == nullptr) {
+            if (mapping_ != nullptr) CloseHandle(mapping_);
+            CloseHandle(file_);
+            throw std::runtime_error("Cannot map feature file " + path);
+        }
+#else
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot open feature file " + path);
+        struct stat st {};
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            throw std::runtime_error("Empty feature file " + path);
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // the mapping keeps its own reference to the file
+        if (data == MAP_FAILED) throw std::runtime_error("Cannot map feature file " + path);
+        data_ = static_cast<const unsigned char*>(data);
+#endif
+    }
+
+    ~FileMapping() {
+#ifdef _WIN32
+        UnmapViewOfFile(data_);
+        CloseHandle(mapping_);
+        CloseHandle(file_);
+#else
+        munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+    }
+
+    FileMapping(const FileMapping&) = delete;
+    FileMapping& operator=(const FileMapping&) = delete;
+
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#endif
+};
+
+// Bytes of complete records in a feature file; 0 if it has no valid header
+size_t completeFileBytes(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    FileHeader fileHeader{};
+    if (!in.read(reinterpret_cast<char*>(&fileHeader), sizeof(fileHeader)) || !validFileHeader(fileHeader)) return 0;
+
+    std::error_code ec;
+    const size_t fileSize = static_cast<size_t>(fs::file_size(path, ec));
+    size_t offset = sizeof(FileHeader);
+    RecordHeader header{};
+    while (in.seekg(static_cast<std::streamoff>(offset)) &&
+           in.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+           validRecord(header, fileSize - offset)) {
+        offset += header.recordBytes;
+    }
+    return offset;
+}
+
+void writePadding(std::ofstream& out, const size_t from, const size_t to) {
+    static const char zeros[ALIGNMENT] = {};
+    out.write(zeros, static_cast<std::streamsize>(to - from));
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// FeatureRecord / FeatureStore Implementation
+// ============================================================================
+
+std::vector<cv::KeyPoint> FeatureRecord::keypoints() const {
+    std::vector<cv::KeyPoint> out;
+    out.reserve(numKeypoints);
+    for (size_t i = 0; i < numKeypoints; ++i) {
+        out.emplace_back(cv::Point2f(x[i], y[i]), size[i], angle[i], response[i], octave[i], windowSize[i]);
+    }
+    return out;
+}
+
+FeatureStore::FeatureStore(const std::string& path) {
+    const auto mapping = std::make_shared<FileMapping>(path);
+    mapping_ = mapping;
+    const unsigned char* base = mapping->data();
+    const size_t fileSize = mapping->size();
+
+    FileHeader fileHeader{};
+    if (fileSize < sizeof(FileHeader)) throw std::runtime_error("Not a feature file: " + path);
+    std::memcpy(&fileHeader, base, sizeof(fileHeader));
+    if (!validFileHeader(fileHeader)) {
+        throw std::runtime_error("Not a feature file or unsupported version: " + path);
+    }
+
+    // Records are 64-byte aligned in the file and the mapping is page aligned, so the arrays are too
+    size_t offset = sizeof(FileHeader);
+    while (offset + sizeof(RecordHeader) <= fileSize) {
+        RecordHeader header{};
+        std::memcpy(&header, base + offset, sizeof(header));
+        if (!validRecord(header, fileSize - offset)) break; // trailing partial record
+
+        const unsigned char* start = base + offset;
+        const size_t n = header.numKeypoints;
+
+        FeatureRecord record;
+        record.name.assign(reinterpret_cast<const char*>(start + sizeof(RecordHeader)), header.nameBytes);
+        record.numKeypoints = n;
+        record.kind = static_cast<DescriptorKind>(header.descriptorKind);
+
+        const auto* floats = reinterpret_cast<const float*>(start + header.keypointOffset);
+        record.x = floats;
+        record.y = floats + n;
+        record.size = floats + 2 * n;
+        record.angle = floats + 3 * n;
+        record.response = floats + 4 * n;
+        const auto* ints = reinterpret_cast<const int32_t*>(floats + 5 * n);
+        record.octave = ints;
+        record.windowSize = ints + n;
+
+        if (n > 0 && header.descriptorCols > 0) {
+            // The mapping is read-only; the Mat header is only ever read
+            record.descriptors = cv::Mat(static_cast<int>(n), static_cast<int>(header.descriptorCols),
+                                         header.descriptorType,
+                                         const_cast<unsigned char*>(start + header.descriptorOffset),
+                                         header.descriptorStride);
+        }
+        record.mapping_ = mapping_;
+
+        records_.push_back(std::move(record));
+        offset += header.recordBytes;
+    }
+}
+
+const FeatureRecord* FeatureStore::find(const std::string& name) const {
+    const auto it = std::find_if(records_.begin(), records_.end(),
+                                 [&name](const FeatureRecord& r) { return r.name == name; });
+    return it == records_.end() ? nullptr : &*it;
+}
+
+// ============================================================================
+// FeatureStoreWriter Implementation
+// ============================================================================
+
+FeatureStoreWriter::FeatureStoreWriter(const std::string& path) : path_(path) {
+    std::error_code ec;
+    const bool existing = fs::exists(path, ec) && fs::file_size(path, ec) > 0;
+
+    if (existing) {
+        const size_t complete = completeFileBytes(path);
+        if (complete == 0) throw std::runtime_error("Not a compatible feature file: " + path);
+
+        // Drop a record left incomplete by an interrupted writer
+        if (complete != fs::file_size(path, ec)) fs::resize_file(path, complete, ec);
+        if (ec) throw std::runtime_error("Cannot truncate feature file " + path);
+    }
+
+    out_.open(path, std::ios::binary | std::ios::app);
+    if (!out_) throw std::runtime_error("Cannot open feature file " + path);
+
+    if (!existing) {
+        FileHeader header{};
+        std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.version = FORMAT_VERSION;
+        header.byteOrder = BYTE_ORDER_MARK;
+        header.headerBytes = sizeof(FileHeader);
+        out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out_.flush();
+    }
+}
+
+void FeatureStoreWriter::append(const std::string& name,
+                                const std::vector<cv::KeyPoint>& keypoints,
+                                const cv::Mat& descriptors,
+                                const DescriptorKind kind) {
+    const size_t n = keypoints.size();
+    CV_Assert(descriptors.empty() || (descriptors.channels() == 1 &&
+              (descriptors.depth() == CV_32F || descriptors.depth() == CV_8U)));
+    CV_Assert(descriptors.empty() || static_cast<size_t>(descriptors.rows) == n);
+
+    const size_t cols = descriptors.empty() ? 0 : static_cast<size_t>(descriptors.cols);
+    const size_t stride = cols * (descriptors.empty() ? 1 : descriptors.elemSize());
+    const RecordLayout layout = layoutRecord(name.size(), n, n * stride);
+
+    RecordHeader header{};
+    header.magic = RECORD_MAGIC;
+    header.nameBytes = static_cast<uint32_t>(name.size());
+    header.recordBytes = layout.recordBytes;
+    header.numKeypoints = n;
+    header.descriptorType = descriptors.empty() ? CV_32F : descriptors.depth();
+    header.descriptorKind = static_cast<int32_t>(header.descriptorType == CV_32F ? DescriptorKind::Float32 : kind);
+    header.descriptorCols = static_cast<uint32_t>(cols);
+    header.descriptorStride = stride;
+    header.keypointOffset = layout.keypointOffset;
+    header.descriptorOffset = layout.descriptorOffset;
+
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out_.write(name.data(), static_cast<std::streamsize>(name.size()));
+    writePadding(out_, sizeof(header) + name.size(), layout.keypointOffset);
+
+    // SoA: one contiguous array per field
+    std::vector<float> floats(n);
+    std::vector<int32_t> ints(n);
+    auto writeFloats = [&](auto field) {
+        std::transform(keypoints.begin(), keypoints.end(), floats.begin(), field);
+        out_.write(reinterpret_cast<const char*>(floats.data()), static_cast<std::streamsize>(n * sizeof(float)));
+    };
+    auto writeInts = [&](auto field) {
+        std::transform(keypoints.begin(), keypoints.end(), ints.begin(), field);
+        out_.write(reinterpret_cast<const char*>(ints.data()), static_cast<std::streamsize>(n * sizeof(int32_t)));
+    };
+    writeFloats([](const cv::KeyPoint& kp) { return kp.pt.x; });
+    writeFloats([](const cv::KeyPoint& kp) { return kp.pt.y; });
+    writeFloats([](const cv::KeyPoint& kp) { return kp.size; });
+    writeFloats([](const cv::KeyPoint& kp) { return kp.angle; });
+    writeFloats([](const cv::KeyPoint& kp) { return kp.response; });
+    writeInts([](const cv::KeyPoint& kp) { return static_cast<int32_t>(kp.octave); });
+    writeInts([](const cv::KeyPoint& kp) { return static_cast<int32_t>(kp.class_id); });
+    writePadding(out_, layout.keypointOffset + NUM_KEYPOINT_FIELDS * n * 4, layout.descriptorOffset);
+
+    // Row by row, so non-continuous descriptor matrices are packed
+    for (int r = 0; r < descriptors.rows && stride > 0; ++r) {
+        out_.write(reinterpret_cast<const char*>(descriptors.ptr(r)), static_cast<std::streamsize>(stride));
+    }
+    writePadding(out_, layout.descriptorOffset + n * stride, layout.recordBytes);
+
+    out_.flush();
+    if (!out_) throw std::runtime_error("Failed writing feature file " + path_);
+}
@@ -0,0 +1,117 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * featurestore.h
+ * Versioned binary feature file: keypoints and descriptors of many images, appended one image at a time
+ * and read back through a memory mapping without copying the descriptors.
+ *
+ * Layout (host byte order, checked on open; every block starts on a 64-byte boundary):
+ *   file header   64 bytes: magic "LPFEATS\0", version, byte-order mark
+ *   record*       one per image, each:
+ *     record header  64 bytes: magic, record size, keypoint count, descriptor type/cols/row stride, offsets
+ *     name           UTF-8 bytes, padded
+ *     keypoints      SoA, n values each: x, y, size, angle, response (float32), octave, window size (int32)
+ *     descriptors    n rows of rowStride bytes (float32, uint8 or packed binary)
+ * A record is only visible to readers once it is complete, so a file cut short by a crash still opens.
+ */
+
+#ifndef FEATURESTORE_H
+#define FEATURESTORE_H
+
+#include <opencv2/core.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// How descriptor bytes are interpreted (uint8 and binary descriptors are both CV_8U)
+enum class DescriptorKind : int32_t {
+    Float32 = 0, // e.g. SIFT, matched with L2
+    UInt8 = 1,   // quantized vectors, matched with L2
+    Binary = 2   // bit strings (ORB, BRISK), matched with Hamming
+};
+
+/*
+ * FeatureRecord - Features of one image inside a mapped FeatureStore.
+ * The SoA arrays and descriptors point into the mapping, which the record keeps alive.
+ * descriptors is read-only by contract (the file is mapped read-only).
+ */
+struct FeatureRecord {
+    std::string name;
+    size_t numKeypoints = 0;
+    DescriptorKind kind = DescriptorKind::Float32;
+
+    const float* x = nullptr;
+    const float* y = nullptr;
+    const float* size = nullptr;
+    const float* angle = nullptr;
+    const float* response = nullptr;
+    const int32_t* octave = nullptr;
+    const int32_t* windowSize = nullptr; // KeyPoint::class_id
+
+    cv::Mat descriptors; // numKeypoints rows, wrapping the mapped block
+
+    /** @brief Materialize cv::KeyPoint objects from the SoA arrays. */
+    std::vector<cv::KeyPoint> keypoints() const;
+
+private:
+    friend class FeatureStore;
+    std::shared_ptr<const void> mapping_;
+};
+
+/*
+ * FeatureStore - Read-only memory-mapped view of a feature file (POSIX mmap or Windows file mapping).
+ * Opening only walks the record headers; pages are faulted in when a record's arrays are touched.
+ */
+class FeatureStore {
+public:
+    /** @brief Map a feature file.
+     *  @param path File written by FeatureStoreWriter.
+     *  @throws std::runtime_error if the file cannot be mapped or has a bad header or version.
+     */
+    explicit FeatureStore(const std::string& path);
+
+    size_t size() const { return records_.size(); }
+    const FeatureRecord& operator[](size_t i) const { return records_[i]; }
+
+    /** @brief Record with the given name, or null. */
+    const FeatureRecord* find(const std::string& name) const;
+
+private:
+    std::shared_ptr<const void> mapping_;
+    std::vector<FeatureRecord> records_;
+};
+
+/*
+ * FeatureStoreWriter - Appends records to a feature file, creating it if needed.
+ * Each append() writes one complete record and flushes, so large collections can be built an image at a time.
+ */
+class FeatureStoreWriter {
+public:
+    /** @brief Open for appending.
+     *  @param path Feature file; a new file gets a header, an existing one must have a matching header.
+     *  @throws std::runtime_error if the file cannot be opened or is not a compatible feature file.
+     */
+    explicit FeatureStoreWriter(const std::string& path);
+
+    /** @brief Append the features of one image.
+     *  @param name Record name (e.g. "dataset/detector/reference").
+     *  @param keypoints Keypoints; their count must match the descriptor rows.
+     *  @param descriptors CV_32F or CV_8U descriptors, one row per keypoint (may be empty with no keypoints).
+     *  @param kind Interpretation of CV_8U descriptors; CV_32F is always Float32.
+     */
+    void append(const std::string& name,
+                const std::vector<cv::KeyPoint>& keypoints,
+                const cv::Mat& descriptors,
+                DescriptorKind kind = DescriptorKind::Binary);
+
+private:
+    std::string path_;
+    std::ofstream out_;
+};
+
+#endif //FEATURESTORE_H
@@ -0,0 +1,145 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * knnmatches.cpp
+ * Flat 2-NN match results.
+ */
+
+#include "knnmatches.h"
+
+#include <algorithm>
+#include <cmath>
+
+void KnnMatches::search(cv::flann::Index& index, const cv::Mat& query, const cv::flann::SearchParams& params) {
+    clear();
+    if (query.empty()) return;
+
+    index.knnSearch(query, trainIdx_, distance_, 2, params);
+    squaredL2_ = distance_.type() == CV_32F; // the L2 index returns squared distances
+
+    queryIdx_.resize(static_cast<size_t>(query.rows));
+    for (int i = 0; i < query.rows; ++i) {
+        queryIdx_[i] = i;
+    }
+    count_ = queryIdx_.size();
+}
+
+size_t KnnMatches::searchBatched(cv::flann::Index& index, const cv::Mat& query,
+                                 const cv::flann::SearchParams& params, const int batchRows,
+                                 const std::function<bool()>& proceed) {
+    clear();
+    if (query.empty()) return 0;
+
+    const int step = batchRows > 0 ? batchRows : query.rows;
+    cv::Mat batchIdx, batchDistance;
+    int searched = 0;
+    while (searched < query.rows) {
+        if (searched > 0 && !proceed()) break;
+        const int end = std::min(query.rows, searched + step);
+        index.knnSearch(query.rowRange(searched, end), batchIdx, batchDistance, 2, params);
+        if (searched == 0) {
+            trainIdx_.create(query.rows, 2, CV_32S);
+            distance_.create(query.rows, 2, batchDistance.type());
+        }
+        batchIdx.copyTo(trainIdx_.rowRange(searched, end));
+        batchDistance.copyTo(distance_.rowRange(searched, end));
+        searched = end;
+    }
+    squaredL2_ = distance_.type() == CV_32F; // the L2 index returns squared distances
+
+    queryIdx_.resize(static_cast<size_t>(searched));
+    for (int i = 0; i < searched; ++i) {
+        queryIdx_[i] = i;
+    }
+    count_ = queryIdx_.size();
+    return count_;
+}
+
+void KnnMatches::assign(const std::vector<cv::DMatch>& matches) {
+    clear();
+    const int n = static_cast<int>(matches.size());
+    trainIdx_.create(n, 2, CV_32S);
+    distance_.create(n, 2, CV_32F);
+    queryIdx_.resize(matches.size());
+    squaredL2_ = false;
+
+    for (int i = 0; i < n; ++i) {
+        queryIdx_[i] = matches[i].queryIdx;
+        int* train = trainIdx_.ptr<int>(i);
+        float* dist = distance_.ptr<float>(i);
+        train[0] = matches[i].trainIdx;
+        train[1] = -1;
+        dist[0] = matches[i].distance;
+        dist[1] = 0.0f;
+    }
+    count_ = matches.size();
+}
+
+void KnnMatches::ratioTest(const float ratio) {
+    const bool integer = distance_.type() == CV_32S;
+    const float threshold = squaredL2_ ? ratio * ratio : ratio;
+
+    // Survivors move to row `kept`; rows are only ever moved towards the front
+    size_t kept = 0;
+    for (size_t i = 0; i < count_; ++i) {
+        const int row = static_cast<int>(i);
+        const int* train = trainIdx_.ptr<int>(row);
+        if (train[0] < 0 || train[1] < 0) continue;
+
+        float best, second;
+        if (integer) {
+            best = static_cast<float>(distance_.ptr<int>(row)[0]);
+            second = static_cast<float>(distance_.ptr<int>(row)[1]);
+        } else {
+            best = distance_.ptr<float>(row)[0];
+            second = distance_.ptr<float>(row)[1];
+        }
+        if (!(best < threshold * second)) continue;
+
+        if (kept != i) {
+            const int to = static_cast<int>(kept);
+            queryIdx_[kept] = queryIdx_[i];
+            trainIdx_.ptr<int>(to)[0] = train[0];
+            if (integer) {
+                distance_.ptr<int>(to)[0] = distance_.ptr<int>(row)[0];
+            } else {
+                distance_.ptr<float>(to)[0] = best;
+            }
+        }
+        ++kept;
+    }
+    count_ = kept;
+}
+
+void KnnMatches::clear() {
+    queryIdx_.clear();
+    count_ = 0;
+}
+
+float KnnMatches::distance(const size_t i) const {
+    const int row = static_cast<int>(i);
+    if (distance_.type() == CV_32S) return static_cast<float>(distance_.at<int>(row, 0));
+    const float d = distance_.at<float>(row, 0);
+    return squaredL2_ ? std::sqrt(d) : d;
+}
+
+void KnnMatches::appendPoints(const std::vector<cv::KeyPoint>& queryKeypoints,
+                              const std::vector<cv::KeyPoint>& trainKeypoints,
+                              std::vector<cv::Point2f>& queryPoints,
+                              std::vector<cv::Point2f>& trainPoints) const {
+    queryPoints.reserve(queryPoints.size() + count_);
+    trainPoints.reserve(trainPoints.size() + count_);
+    for (size_t i = 0; i < count_; ++i) {
+        queryPoints.push_back(queryKeypoints[queryIdx_[i]].pt);
+        trainPoints.push_back(trainKeypoints[trainIdx_.ptr<int>(static_cast<int>(i))[0]].pt);
+    }
+}
+
+void KnnMatches::toDMatches(std::vector<cv::DMatch>& matches) const {
+    matches.clear();
+    matches.reserve(count_);
+    for (size_t i = 0; i < count_; ++i) {
+        matches.emplace_back(queryIdx(i), trainIdx(i), distance(i));
+    }
+}
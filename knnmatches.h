@@ -0,0 +1,89 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * knnmatches.h
+ * Flat 2-NN match results: the ratio test and matched point extraction work directly on the
+ * arrays written by the FLANN search, without a std::vector<cv::DMatch> per query keypoint.
+ */
+
+#ifndef KNNMATCHES_H
+#define KNNMATCHES_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/flann.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/*
+ * KnnMatches - Two nearest neighbours per query descriptor, as parallel arrays.
+ * search() fills n x 2 train index and distance matrices (two allocations for any n, reused when the
+ * object is reused). ratioTest() then compacts the surviving queries to the front in place, so
+ * match i is (queryIdx(i), trainIdx(i), distance(i)) for i < size().
+ * Distances are kept as the index returns them: squared L2 for float descriptors, Hamming for binary.
+ */
+class KnnMatches {
+public:
+    /** @brief Find the two nearest train descriptors of every query descriptor.
+     *  @param index FLANN index built on the train descriptors.
+     *  @param query Query descriptors, one per row.
+     *  @param params Search parameters (checks).
+     */
+    void search(cv::flann::Index& index, const cv::Mat& query, const cv::flann::SearchParams& params);
+
+    /** @brief search() over consecutive batches of query rows, asking proceed() before every batch but
+     *  the first, so a deadline can cut matching short.
+     *  @param batchRows Query rows per batch.
+     *  @param proceed Returns false to stop; the rows searched so far are kept.
+     *  @return Number of query rows searched (a prefix of query).
+     */
+    size_t searchBatched(cv::flann::Index& index, const cv::Mat& query, const cv::flann::SearchParams& params,
+                         int batchRows, const std::function<bool()>& proceed);
+
+    /** @brief Take one-to-one matches (e.g. from BFMatcher::match) as already filtered results. */
+    void assign(const std::vector<cv::DMatch>& matches);
+
+    /** @brief Lowe's ratio test: keep a query if its best distance is below ratio times the second best.
+     *  Squared L2 distances are compared against ratio^2, so no square roots are taken.
+     */
+    void ratioTest(float ratio);
+
+    void clear();
+
+    size_t size() const { return count_; }
+
+    /** @brief Bytes held by the result arrays (all searched rows, not only the surviving matches). */
+    size_t bytes() const {
+        return trainIdx_.total() * trainIdx_.elemSize() + distance_.total() * distance_.elemSize() +
+               queryIdx_.capacity() * sizeof(int);
+    }
+
+    int queryIdx(size_t i) const { return queryIdx_[i]; }
+    int trainIdx(size_t i) const { return trainIdx_.at<int>(static_cast<int>(i), 0); }
+
+    /** @brief Descriptor distance of match i, as cv::DMatch reports it (L2, not squared). */
+    float distance(size_t i) const;
+
+    /** @brief Append the keypoint locations of every match (reserves once).
+     *  @param queryKeypoints Keypoints of the query descriptors.
+     *  @param trainKeypoints Keypoints of the train descriptors.
+     */
+    void appendPoints(const std::vector<cv::KeyPoint>& queryKeypoints,
+                      const std::vector<cv::KeyPoint>& trainKeypoints,
+                      std::vector<cv::Point2f>& queryPoints,
+                      std::vector<cv::Point2f>& trainPoints) const;
+
+    /** @brief Convert to cv::DMatch, for callers that need the OpenCV representation. */
+    void toDMatches(std::vector<cv::DMatch>& matches) const;
+
+private:
+    cv::Mat trainIdx_;            // n x 2 CV_32S; -1 where the search found no neighbour
+    cv::Mat distance_;            // n x 2 CV_32F (squared L2, or L2 after assign()) or CV_32S (Hamming)
+    std::vector<int> queryIdx_;   // query of each row
+    size_t count_ = 0;            // rows holding matches
+    bool squaredL2_ = false;
+};
+
+#endif //KNNMATCHES_H
@@ -0,0 +1,456 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * lpdog.cpp
+ * Hybrid LP + DoG detector based on:
+ * Hao Li et al., "Local-peak scale-invariant feature transform for fast and random image stitching"
+ * (arXiv:2405.08578v2) and D. Lowe's SIFT scale-space extrema (reference/sift.dispatch.cpp).
+ *
+ * The detector combines both:
+ *  - Section 2.1 Image Preprocessing
+ *      Add a tiny linear background (alpha) to avoid flat regions with identical intensities.
+ *  - Section 2.2 Feature Point Detection
+ *      Local maxima/minima of each interrogation window are collected as seeds (no descriptors yet).
+ *  - DoG refinement
+ *      Each window size L maps to one octave. Only the blocks of that octave that contain seeds get a
+ *      Gaussian/DoG stack, so no full DoG pyramid is built. Around each seed the strongest 3x3x3 DoG
+ *      extremum is interpolated to sub-pixel/sub-scale accuracy and filtered by contrast and edge
+ *      response exactly as SIFT's adjustLocalExtrema does.
+ *  - Section 2.3 - Feature Point Description
+ *      Use SIFT descriptors around the refined points (SIFT octave/layer encoding is kept).
+ */
+
+#include "lpdog.h"
+#include "lppeaks.h"
+#include "trace.h"
+
+#include <opencv2/features2d.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <numeric>
+#include <set>
+#include <tuple>
+
+using namespace cv;
+
+namespace {
+
+// Constants shared with OpenCV's SIFT implementation (sift.simd.hpp)
+constexpr int SIFT_IMG_BORDER = 5;        // width of border in which to ignore keypoints
+constexpr int SIFT_MAX_INTERP_STEPS = 5;  // maximum steps of keypoint interpolation before failure
+constexpr float SIFT_INIT_SIGMA = 0.5f;   // assumed blur of the (area-downsampled) octave base
+
+constexpr int SEED_BASE_WINDOW = 16;      // LP window size that seeds octave 0
+constexpr int BLOCK_SIZE = 64;            // octave pixels per DoG block (before margin)
+
+// True if val is a maximum (val > 0) or minimum (val < 0) of its 3x3x3 scale-space neighbourhood
+bool isScaleSpaceExtremum(const Mat& prev, const Mat& cur, const Mat& next,
+                          const int r, const int c, const float val) {
+    const bool isMax = val > 0;
+    for (const Mat* layer : { &prev, &cur, &next }) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            const float* row = layer->ptr<float>(r + dy);
+            for (int dx = -1; dx <= 1; ++dx) {
+                if (layer == &cur && dx == 0 && dy == 0) continue;
+                const float n = row[c + dx];
+                if (isMax ? n > val : n < val) return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+Ptr<LPDOG> LPDOG::create(const std::vector<int>& windowSizes,
+                         const float linearNoiseAlpha,
+                         const int nOctaveLayers,
+                         const double contrastThreshold,
+                         const double edgeThreshold,
+                         const double sigma,
+                         const int searchRadius) {
+    return makePtr<LPDOG>(windowSizes, linearNoiseAlpha, nOctaveLayers,
+                          contrastThreshold, edgeThreshold, sigma, searchRadius);
+}
+
+Ptr<LPDOG> LPDOG::withWindowSizes(const std::vector<int>& windowSizes) const {
+    return create(windowSizes, linearNoiseAlpha_, nOctaveLayers_, contrastThreshold_, edgeThreshold_, sigma_,
+                  searchRadius_);
+}
+
+LPDOG::LPDOG(const std::vector<int>& windowSizes,
+             const float linearNoiseAlpha,
+             const int nOctaveLayers,
+             const double contrastThreshold,
+             const double edgeThreshold,
+             const double sigma,
+             const int searchRadius)
+    : descriptor_(SIFT::create(0, nOctaveLayers, contrastThreshold, edgeThreshold, sigma)),
+      windowSizes_(windowSizes),
+      linearNoiseAlpha_(linearNoiseAlpha),
+      nOctaveLayers_(nOctaveLayers),
+      contrastThreshold_(contrastThreshold),
+      edgeThreshold_(edgeThreshold),
+      sigma_(sigma),
+      searchRadius_(searchRadius) {}
+
+String LPDOG::getDefaultName() const {
+    return "Feature2D.LPDOG";
+}
+
+// Section 2.1: Image Preprocessing
+// Adds alpha * (y * cols + x) to each pixel to break flat plateaus deterministically.
+// The ramp is linear, so it cancels out in the DoG layers.
+void LPDOG::addLinearRamp(Mat& image) const {
+    lp::addLinearRamp(image, linearNoiseAlpha_);
+}
+
+int LPDOG::octaveForWindow(const int windowSize, const int nOctaves) {
+    const int octave = cvRound(std::log2(static_cast<double>(windowSize) / SEED_BASE_WINDOW));
+    return std::clamp(octave, 0, nOctaves - 1);
+}
+
+bool LPDOG::adjustLocalExtremum(const std::vector<Mat>& dog,
+                                const Point origin,
+                                const Size octaveSize,
+                                const int octave,
+                                int& layer,
+                                int& r,
+                                int& c,
+                                KeyPoint& kpt) const {
+    const float imgScale = 1.f / 255.f;
+    const float derivScale = imgScale * 0.5f;
+    const float secondDerivScale = imgScale;
+    const float crossDerivScale = imgScale * 0.25f;
+
+    float xi = 0, xr = 0, xc = 0, contr = 0;
+    int i = 0;
+
+    for (; i < SIFT_MAX_INTERP_STEPS; i++) {
+        const Mat& img = dog[layer];
+        const Mat& prev = dog[layer - 1];
+        const Mat& next = dog[layer + 1];
+
+        Vec3f dD((img.at<float>(r, c + 1) - img.at<float>(r, c - 1)) * derivScale,
+                 (img.at<float>(r + 1, c) - img.at<float>(r - 1, c)) * derivScale,
+                 (next.at<float>(r, c) - prev.at<float>(r, c)) * derivScale);
+
+        const float v2 = img.at<float>(r, c) * 2;
+        const float dxx = (img.at<float>(r, c + 1) + img.at<float>(r, c - 1) - v2) * secondDerivScale;
+        const float dyy = (img.at<float>(r + 1, c) + img.at<float>(r - 1, c) - v2) * secondDerivScale;
+        const float dss = (next.at<float>(r, c) + prev.at<float>(r, c) - v2) * secondDerivScale;
+        const float dxy = (img.at<float>(r + 1, c + 1) - img.at<float>(r + 1, c - 1) -
+                           img.at<float>(r - 1, c + 1) + img.at<float>(r - 1, c - 1)) * crossDerivScale;
+        const float dxs = (next.at<float>(r, c + 1) - next.at<float>(r, c - 1) -
+                           prev.at<float>(r, c + 1) + prev.at<float>(r, c - 1)) * crossDerivScale;
+        const float dys = (next.at<float>(r + 1, c) - next.at<float>(r - 1, c) -
+                           prev.at<float>(r + 1, c) + prev.at<float>(r - 1, c)) * crossDerivScale;
+
+        Matx33f H(dxx, dxy, dxs,
+                  dxy, dyy, dys,
+                  dxs, dys, dss);
+
+        Vec3f X = H.solve(dD, DECOMP_LU);
+
+        xi = -X[2];
+        xr = -X[1];
+        xc = -X[0];
+
+        if (std::abs(xi) < 0.5f && std::abs(xr) < 0.5f && std::abs(xc) < 0.5f)
+            break;
+
+        if (std::abs(xi) > static_cast<float>(INT_MAX / 3) ||
+            std::abs(xr) > static_cast<float>(INT_MAX / 3) ||
+            std::abs(xc) > static_cast<float>(INT_MAX / 3))
+            return false;
+
+        c += cvRound(xc);
+        r += cvRound(xr);
+        layer += cvRound(xi);
+
+        // Stay inside the block stack and away from the octave border
+        if (layer < 1 || layer > nOctaveLayers_ ||
+            c < 1 || c >= img.cols - 1 || r < 1 || r >= img.rows - 1 ||
+            origin.x + c < SIFT_IMG_BORDER || origin.x + c >= octaveSize.width - SIFT_IMG_BORDER ||
+            origin.y + r < SIFT_IMG_BORDER || origin.y + r >= octaveSize.height - SIFT_IMG_BORDER)
+            return false;
+    }
+
+    // ensure convergence of interpolation
+    if (i >= SIFT_MAX_INTERP_STEPS)
+        return false;
+
+    {
+        const Mat& img = dog[layer];
+        const Mat& prev = dog[layer - 1];
+        const Mat& next = dog[layer + 1];
+
+        Matx31f dD((img.at<float>(r, c + 1) - img.at<float>(r, c - 1)) * derivScale,
+                   (img.at<float>(r + 1, c) - img.at<float>(r - 1, c)) * derivScale,
+                   (next.at<float>(r, c) - prev.at<float>(r, c)) * derivScale);
+        const float t = dD.dot(Matx31f(xc, xr, xi));
+
+        contr = img.at<float>(r, c) * imgScale + t * 0.5f;
+        if (std::abs(contr) * nOctaveLayers_ < contrastThreshold_)
+            return false;
+
+        // principal curvatures are computed using the trace and det of Hessian
+        const float v2 = img.at<float>(r, c) * 2.f;
+        const float dxx = (img.at<float>(r, c + 1) + img.at<float>(r, c - 1) - v2) * secondDerivScale;
+        const float dyy = (img.at<float>(r + 1, c) + img.at<float>(r - 1, c) - v2) * secondDerivScale;
+        const float dxy = (img.at<float>(r + 1, c + 1) - img.at<float>(r + 1, c - 1) -
+                           img.at<float>(r - 1, c + 1) + img.at<float>(r - 1, c - 1)) * crossDerivScale;
+        const float tr = dxx + dyy;
+        const float det = dxx * dyy - dxy * dxy;
+
+        if (det <= 0 || tr * tr * edgeThreshold_ >= (edgeThreshold_ + 1) * (edgeThreshold_ + 1) * det)
+            return false;
+    }
+
+    // Same mapping to the original image as SIFT, so SIFT's descriptor samples the patch it expects
+    const float scale = static_cast<float>(1 << octave);
+    kpt.pt.x = (static_cast<float>(origin.x + c) + xc) * scale;
+    kpt.pt.y = (static_cast<float>(origin.y + r) + xr) * scale;
+    kpt.octave = octave + (layer << 8) + (cvRound((xi + 0.5) * 255) << 16);
+    kpt.size = static_cast<float>(sigma_ * std::pow(2.0, (layer + xi) / nOctaveLayers_) * scale * 2);
+    kpt.response = std::abs(contr);
+
+    return true;
+}
+
+void LPDOG::refineOctave(const Mat& base,
+                         const int octave,
+                         const std::vector<Seed>& seeds,
+                         std::vector<KeyPoint>& out) const {
+    const int layers = nOctaveLayers_ + 3;
+
+    // Incremental Gaussian sigmas, as in SIFT_Impl::buildGaussianPyramid
+    std::vector<double> sig(layers);
+    sig[0] = std::sqrt(std::max(sigma_ * sigma_ - SIFT_INIT_SIGMA * SIFT_INIT_SIGMA, 0.01));
+    const double k = std::pow(2.0, 1.0 / nOctaveLayers_);
+    for (int i = 1; i < layers; i++) {
+        const double sigPrev = std::pow(k, static_cast<double>(i - 1)) * sigma_;
+        const double sigTotal = sigPrev * k;
+        sig[i] = std::sqrt(sigTotal * sigTotal - sigPrev * sigPrev);
+    }
+
+    // Margin wide enough that the top layer's blur does not see the block border
+    const int margin = cvCeil(3.0 * sigma_ * std::pow(k, static_cast<double>(layers - 1)));
+    const float threshold = static_cast<float>(0.5 * contrastThreshold_ / nOctaveLayers_ * 255);
+
+    // Bucket seeds by block so each DoG block is built once
+    const int blocksX = (base.cols + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const int blocksY = (base.rows + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    std::vector<std::vector<int>> blockSeeds(static_cast<size_t>(blocksX) * blocksY);
+    for (size_t i = 0; i < seeds.size(); ++i) {
+        const int bx = std::clamp(cvFloor(seeds[i].pt.x) / BLOCK_SIZE, 0, blocksX - 1);
+        const int by = std::clamp(cvFloor(seeds[i].pt.y) / BLOCK_SIZE, 0, blocksY - 1);
+        blockSeeds[by * blocksX + bx].push_back(static_cast<int>(i));
+    }
+
+    std::vector<int> activeBlocks;
+    for (size_t b = 0; b < blockSeeds.size(); ++b) {
+        if (!blockSeeds[b].empty()) activeBlocks.push_back(static_cast<int>(b));
+    }
+
+    // Refined keypoints of each block, with the octave position of the extremum they started from
+    using ExtremumKey = std::tuple<int, int, int>; // layer, row, column
+    std::vector<std::vector<KeyPoint>> blockKeypoints(activeBlocks.size());
+    std::vector<std::vector<ExtremumKey>> blockExtrema(activeBlocks.size());
+
+    parallel_for_(Range(0, static_cast<int>(activeBlocks.size())), [&](const Range& range) {
+        std::vector<Mat> gauss(layers);
+        std::vector<Mat> dog(layers - 1);
+
+        for (int a = range.start; a < range.end; ++a) {
+            const int b = activeBlocks[a];
+            const Rect block((b % blocksX) * BLOCK_SIZE, (b / blocksX) * BLOCK_SIZE, BLOCK_SIZE, BLOCK_SIZE);
+            const Rect roi = Rect(block.x - margin, block.y - margin,
+                                  block.width + 2 * margin, block.height + 2 * margin) &
+                             Rect(0, 0, base.cols, base.rows);
+            if (roi.width < 3 || roi.height < 3) continue;
+
+            // Gaussian and DoG stack for this block only
+            GaussianBlur(base(roi), gauss[0], Size(), sig[0], sig[0]);
+            for (int i = 1; i < layers; i++) {
+                GaussianBlur(gauss[i - 1], gauss[i], Size(), sig[i], sig[i]);
+            }
+            for (int i = 0; i < layers - 1; i++) {
+                subtract(gauss[i + 1], gauss[i], dog[i], noArray(), CV_32F);
+            }
+
+            // Search bounds keep the 3x3 neighbourhood inside the block and away from the octave border
+            const int rMin = std::max(1, SIFT_IMG_BORDER - roi.y);
+            const int rMax = std::min(roi.height - 2, base.rows - SIFT_IMG_BORDER - 1 - roi.y);
+            const int cMin = std::max(1, SIFT_IMG_BORDER - roi.x);
+            const int cMax = std::min(roi.width - 2, base.cols - SIFT_IMG_BORDER - 1 - roi.x);
+
+            std::set<ExtremumKey> found; // several seeds may converge to the same extremum
+
+            for (const int s : blockSeeds[b]) {
+                const Seed& seed = seeds[s];
+                const int sr = cvRound(seed.pt.y) - roi.y;
+                const int sc = cvRound(seed.pt.x) - roi.x;
+
+                // Strongest scale-space extremum in the search window around the seed
+                int bestLayer = -1, bestR = 0, bestC = 0;
+                float bestVal = threshold;
+                for (int layer = 1; layer <= nOctaveLayers_; ++layer) {
+                    for (int r = std::max(rMin, sr - searchRadius_); r <= std::min(rMax, sr + searchRadius_); ++r) {
+                        const float* row = dog[layer].ptr<float>(r);
+                        for (int c = std::max(cMin, sc - searchRadius_); c <= std::min(cMax, sc + searchRadius_); ++c) {
+                            const float val = row[c];
+                            if (std::abs(val) <= bestVal) continue;
+                            if (isScaleSpaceExtremum(dog[layer - 1], dog[layer], dog[layer + 1], r, c, val)) {
+                                bestVal = std::abs(val);
+                                bestLayer = layer;
+                                bestR = r;
+                                bestC = c;
+                            }
+                        }
+                    }
+                }
+                if (bestLayer < 0) continue;
+
+                KeyPoint kpt;
+                if (!adjustLocalExtremum(dog, roi.tl(), base.size(), octave, bestLayer, bestR, bestC, kpt)) continue;
+                const ExtremumKey key{ bestLayer, roi.y + bestR, roi.x + bestC };
+                if (!found.insert(key).second) continue;
+
+                kpt.angle = -1.0f; // let SIFT assign orientation during compute()
+                kpt.class_id = seed.windowSize; // store the seeding interrogation window size
+                blockKeypoints[a].push_back(kpt);
+                blockExtrema[a].push_back(key);
+            }
+        }
+    });
+
+    // Search windows reach into the margins, so neighbouring blocks can refine the same extremum
+    std::set<ExtremumKey> emitted;
+    for (size_t a = 0; a < blockKeypoints.size(); ++a) {
+        for (size_t i = 0; i < blockKeypoints[a].size(); ++i) {
+            if (emitted.insert(blockExtrema[a][i]).second) out.push_back(blockKeypoints[a][i]);
+        }
+    }
+}
+
+/// Section 2.2 Feature Point Detection (seeds) + DoG refinement
+void LPDOG::detect(InputArray image,
+                   std::vector<KeyPoint>& keypoints,
+                   InputArray mask) {
+    CV_UNUSED(mask); // Mask input is kept for API compatibility. Not implemented.
+    keypoints.clear();
+
+    // Early exit if image is empty
+    if (image.empty()) return;
+
+    const Mat src = image.getMat();
+
+    Mat gray;
+    if (src.channels() > 1) {
+        cvtColor(src, gray, COLOR_BGR2GRAY);
+        gray.convertTo(gray, CV_32F);
+    } else {
+        src.convertTo(gray, CV_32F); // e.g. a Y-plane view: converted straight from the caller's buffer
+    }
+    addLinearRamp(gray);
+
+    const int rows = gray.rows;
+    const int cols = gray.cols;
+
+    // Same octave count SIFT would use without upscaling
+    const int nOctaves = std::max(1, cvRound(std::log(static_cast<double>(std::min(rows, cols))) / std::log(2.0) - 2));
+    std::vector<std::vector<Seed>> octaveSeeds(nOctaves);
+
+    // Local Peaks seeds, grouped by the octave their window size maps to
+    for (const int L : windowSizes_) {
+        const int octave = octaveForWindow(L, nOctaves);
+        const float scale = 1.f / static_cast<float>(1 << octave);
+        std::vector<Seed>& seeds = octaveSeeds[octave];
+        trace::Span span("LP-DoG seeds");
+        span.arg("window_size", L).arg("octave", octave);
+
+        for (int y = 0; y + L <= rows; y += L) {
+            for (int x = 0; x + L <= cols; x += L) {
+                Mat tile = gray(Rect(x, y, L, L));
+                double minVal = 0.0, maxVal = 0.0;
+                Point minLoc, maxLoc;
+
+                minMaxLoc(tile, &minVal, &maxVal, &minLoc, &maxLoc);
+
+                seeds.push_back({ Point2f(static_cast<float>(x + maxLoc.x) * scale,
+                                          static_cast<float>(y + maxLoc.y) * scale), L });
+                seeds.push_back({ Point2f(static_cast<float>(x + minLoc.x) * scale,
+                                          static_cast<float>(y + minLoc.y) * scale), L });
+            }
+        }
+    }
+
+    // DoG refinement only around the seeds of each octave
+    for (int o = 0; o < nOctaves; ++o) {
+        if (octaveSeeds[o].empty()) continue;
+
+        Mat base;
+        if (o == 0) {
+            base = gray;
+        } else {
+            resize(gray, base, Size(cols >> o, rows >> o), 0, 0, INTER_AREA);
+        }
+
+        trace::Span span("LP-DoG refine");
+        const size_t before = keypoints.size();
+        refineOctave(base, o, octaveSeeds[o], keypoints);
+        span.arg("octave", o).arg("seeds", static_cast<int64_t>(octaveSeeds[o].size()))
+            .arg("keypoints", static_cast<int64_t>(keypoints.size() - before));
+    }
+}
+
+/// Section 2.3 Feature Point Description
+void LPDOG::compute(InputArray image,
+                    std::vector<KeyPoint>& keypoints,
+                    OutputArray descriptors) {
+    if (keypoints.empty()) {
+        descriptors.release();
+        return;
+    }
+
+    const Mat src = image.getMat();
+    if (src.empty() || descriptor_.empty()) {
+        descriptors.release();
+        return;
+    }
+
+    Mat gray;
+    if (src.channels() > 1) {
+        cvtColor(src, gray, COLOR_BGR2GRAY);
+    } else {
+        gray = src;
+    }
+
+    if (gray.type() != CV_8U) {
+        gray.convertTo(gray, CV_8U);
+    }
+
+    descriptor_->compute(gray, keypoints, descriptors); // SIFT picks the Gaussian layer from kp.octave
+}
+
+void LPDOG::detectAndCompute(InputArray image,
+                             InputArray mask,
+                             std::vector<KeyPoint>& keypoints,
+                             OutputArray descriptors,
+                             const bool useProvidedKeypoints) {
+    if (!useProvidedKeypoints) {
+        detect(image, keypoints, mask);
+    }
+
+    if (keypoints.empty()) {
+        descriptors.release();
+        return;
+    }
+
+    compute(image, keypoints, descriptors);
+}
@@ -0,0 +1,165 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * lpdog.h
+ * Hybrid LP + DoG detector based on:
+ * Hao Li et al., "Local-peak scale-invariant feature transform for fast and random image stitching"
+ * (arXiv:2405.08578v2) and D. Lowe's SIFT scale-space extrema (reference/sift.dispatch.cpp).
+ *
+ * Local peaks are used as cheap seeds; DoG extremum localization runs only in small blocks around them.
+ */
+
+#ifndef LPDOG_H
+#define LPDOG_H
+
+#include <opencv2/features2d.hpp>
+#include <vector>
+
+
+class LPDOG final : public cv::Feature2D {
+public:
+    // Different window sizes to cover good range of potential feature sizes in images
+    static inline const std::vector<int> DEFAULT_WINDOW_SIZES = { 16, 32, 64, 128, 256 };
+    static constexpr float DEFAULT_LINEAR_NOISE_ALPHA = 1e-6f; // Sufficiently small noise constant
+    static constexpr int DEFAULT_OCTAVE_LAYERS = 3;            // Same defaults as cv::SIFT
+    static constexpr double DEFAULT_CONTRAST_THRESHOLD = 0.04;
+    static constexpr double DEFAULT_EDGE_THRESHOLD = 10.0;
+    static constexpr double DEFAULT_SIGMA = 1.6;
+    static constexpr int DEFAULT_SEARCH_RADIUS = 4;            // Octave pixels searched around each seed
+
+    /** @brief Factory for an LPDOG detector/descriptor.
+     *  @param windowSizes Interrogation window sizes used for seeding (non-empty, values > 1).
+     *  @param linearNoiseAlpha Small ramp magnitude added during preprocessing.
+     *  @param nOctaveLayers DoG layers per octave (as in SIFT).
+     *  @param contrastThreshold DoG contrast threshold (as in SIFT).
+     *  @param edgeThreshold Principal curvature ratio threshold (as in SIFT).
+     *  @param sigma Gaussian sigma of the first layer of each octave (as in SIFT).
+     *  @param searchRadius Radius in octave pixels searched for a DoG extremum around each seed.
+     *  @return Pointer created via cv::makePtr.
+     */
+    static cv::Ptr<LPDOG> create(
+        const std::vector<int>& windowSizes = DEFAULT_WINDOW_SIZES,
+        float linearNoiseAlpha = DEFAULT_LINEAR_NOISE_ALPHA,
+        int nOctaveLayers = DEFAULT_OCTAVE_LAYERS,
+        double contrastThreshold = DEFAULT_CONTRAST_THRESHOLD,
+        double edgeThreshold = DEFAULT_EDGE_THRESHOLD,
+        double sigma = DEFAULT_SIGMA,
+        int searchRadius = DEFAULT_SEARCH_RADIUS);
+
+    /** @brief Construct an LPDOG detector/descriptor.
+     *  Public to allow cv::makePtr; defaults are defined only on create().
+     */
+    LPDOG(const std::vector<int>& windowSizes,
+          float linearNoiseAlpha,
+          int nOctaveLayers,
+          double contrastThreshold,
+          double edgeThreshold,
+          double sigma,
+          int searchRadius);
+
+    /** @brief Detector with the same parameters and other window sizes. */
+    [[nodiscard]] cv::Ptr<LPDOG> withWindowSizes(const std::vector<int>& windowSizes) const;
+
+    /** @brief OpenCV registry name for this implementation. */
+    cv::String getDefaultName() const override; // NOLINT(modernize-use-nodiscard) matching OpenCV base signature
+    /** @brief Dimension of the descriptor (delegates to SIFT). */
+    [[nodiscard]] int descriptorSize() const override { return descriptor_->descriptorSize(); }
+    /** @brief OpenCV type of the descriptor matrix (delegates to SIFT). */
+    [[nodiscard]] int descriptorType() const override { return descriptor_->descriptorType(); }
+
+    /** @brief Detect keypoints by refining Local Peaks seeds to sub-pixel/sub-scale DoG extrema.
+     *  @param image Input image.
+     *  @param keypoints Output vector of detected keypoints (SIFT octave/layer encoding).
+     *  @param mask Mask input (ignored; kept for API compatibility).
+     */
+    void detect(cv::InputArray image,
+                std::vector<cv::KeyPoint>& keypoints,
+                cv::InputArray mask) override;
+
+    /** @brief Compute SIFT descriptors for provided keypoints.
+     *  @param image Input image.
+     *  @param keypoints Keypoints to describe (must be non-empty).
+     *  @param descriptors Output descriptor matrix.
+     */
+    void compute(cv::InputArray image,
+                 std::vector<cv::KeyPoint>& keypoints,
+                 cv::OutputArray descriptors) override;
+
+    /** @brief Combined detect and compute pipeline. Calls LPDOG detect then SIFT compute.
+     *  @param image Input image.
+     *  @param mask Optional mask (ignored).
+     *  @param keypoints Output keypoints (or input when useProvidedKeypoints is true).
+     *  @param descriptors Output descriptor matrix.
+     *  @param useProvidedKeypoints If false, runs detect() first; otherwise only computes descriptors.
+     */
+    void detectAndCompute(cv::InputArray image,
+                          cv::InputArray mask,
+                          std::vector<cv::KeyPoint>& keypoints,
+                          cv::OutputArray descriptors,
+                          bool useProvidedKeypoints) override;
+
+private:
+    // A Local Peaks seed expressed in the coordinates of the octave it refines in
+    struct Seed {
+        cv::Point2f pt;
+        int windowSize;
+    };
+
+    cv::Ptr<cv::Feature2D> descriptor_; // Pointer to SIFT instance for descriptor implementation
+    std::vector<int> windowSizes_;
+    float linearNoiseAlpha_;
+    int nOctaveLayers_;
+    double contrastThreshold_;
+    double edgeThreshold_;
+    double sigma_;
+    int searchRadius_;
+
+    /** @brief Adds a linear ramp to the image
+     *
+     * Note: Uses formular alpha * (y * cols + x) ramp to make pixel values strictly increasing.
+     * @param image Input Image
+     */
+    void addLinearRamp(cv::Mat& image) const;
+
+    /** @brief Map an interrogation window size to the DoG octave whose scale it seeds.
+     *  @param windowSize Interrogation window size (pixels).
+     *  @param nOctaves Number of octaves available for the image.
+     *  @return Octave index in [0, nOctaves).
+     */
+    static int octaveForWindow(int windowSize, int nOctaves);
+
+    /** @brief Build DoG layers only for seeded blocks of one octave and localize extrema there.
+     *  @param base Octave base image (area-downsampled, CV_32F, 0..255 range).
+     *  @param octave Octave index (pixel scale is 2^octave).
+     *  @param seeds Seeds in octave coordinates.
+     *  @param out Destination vector to receive refined keypoints.
+     */
+    void refineOctave(const cv::Mat& base,
+                      int octave,
+                      const std::vector<Seed>& seeds,
+                      std::vector<cv::KeyPoint>& out) const;
+
+    /** @brief Sub-pixel/sub-scale extremum interpolation with contrast and edge rejection.
+     *  Port of adjustLocalExtrema from OpenCV's SIFT (sift.simd.hpp) for the block-local DoG stack.
+     *  @param dog Block DoG layers (nOctaveLayers + 2 images).
+     *  @param origin Block origin in octave coordinates.
+     *  @param octaveSize Size of the whole octave image (for border checks).
+     *  @param octave Octave index.
+     *  @param layer In/out DoG layer index.
+     *  @param r In/out block-local row.
+     *  @param c In/out block-local column.
+     *  @param kpt Output keypoint on success.
+     *  @return True if the extremum survived interpolation, contrast and edge tests.
+     */
+    bool adjustLocalExtremum(const std::vector<cv::Mat>& dog,
+                             cv::Point origin,
+                             cv::Size octaveSize,
+                             int octave,
+                             int& layer,
+                             int& r,
+                             int& c,
+                             cv::KeyPoint& kpt) const;
+};
+
+#endif //LPDOG_H
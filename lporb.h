@@ -16,6 +16,8 @@
 #include <opencv2/features2d.hpp>
 #include <vector>
 
+#include "lppeaks.h"
+
 
 class LPORB final : public cv::Feature2D {
 public:
@@ -56,6 +58,41 @@ public:
                 std::vector<cv::KeyPoint>& keypoints,
                 cv::InputArray mask) override;
 
+    /** @brief Detect keypoints and report candidate/pruning statistics for this call.
+     *  Thread-safe for concurrent calls on the same instance (no per-call state is stored).
+     *  @param image Input image.
+     *  @param keypoints Output vector of detected keypoints.
+     *  @param stats Output statistics for this call.
+     */
+    void detectWithStats(cv::InputArray image,
+                         std::vector<cv::KeyPoint>& keypoints,
+                         LPDetectionStats& stats) const;
+
+    /** @brief Generator-style detection: emits one keypoint batch per window size, coarsest first.
+     *  Lets description and matching start on coarse scales while finer scales are still detected.
+     *  @param image Input image.
+     *  @param onBatch Called once per scale; returning false stops before the next (finer) scale.
+     *  @param stats Output statistics accumulated over the emitted scales.
+     */
+    void detectScales(cv::InputArray image,
+                      const LPScaleCallback& onBatch,
+                      LPDetectionStats& stats) const;
+
+    /** @brief Configure contrast/edge pruning of candidates before description. */
+    void setPruneParams(const LPPruneParams& params) { scan_.prune = params; }
+    /** @brief Current contrast/edge pruning configuration. */
+    [[nodiscard]] const LPPruneParams& getPruneParams() const { return scan_.prune; }
+
+    /** @brief Configure rejection of tile-border pseudo-peaks during the window scan. */
+    void setBorderCheckParams(const LPBorderCheckParams& params) { scan_.borderCheck = params; }
+    /** @brief Current tile-border pseudo-peak rejection configuration. */
+    [[nodiscard]] const LPBorderCheckParams& getBorderCheckParams() const { return scan_.borderCheck; }
+
+    /** @brief Configure overlapping (strided) interrogation windows instead of the fixed grid. */
+    void setDenseParams(const LPDenseParams& params) { scan_.dense = params; }
+    /** @brief Current dense detection configuration. */
+    [[nodiscard]] const LPDenseParams& getDenseParams() const { return scan_.dense; }
+
     /** @brief Compute ORB descriptors for provided keypoints.
      *  @param image Input image.
      *  @param keypoints Keypoints to describe (must be non-empty).
@@ -80,34 +117,7 @@ public:
 
 private:
     cv::Ptr<cv::Feature2D> descriptor_; // Descriptor implementation (ORB-backed)
-    std::vector<int> windowSizes_;
-    float linearNoiseAlpha_;
-
-    /** @brief Adds a linear ramp to the image
-     *
-     * Note: Uses formular alpha * (y * cols + x) ramp to make pixel values strictly increasing.
-     * @param image Input Image
-     */
-    void addLinearRamp(cv::Mat& image) const;
-    /** @brief Validate bounds and append a keypoint candidate.
-     *  @param x Pixel x coordinate.
-     *  @param y Pixel y coordinate.
-     *  @param windowSize Interrogation window size (pixels).
-     *  @param octaveIndex Index of the current scale/octave.
-     *  @param response Response/contrast value to store.
-     *  @param cols Image width (used for bounds check).
-     *  @param rows Image height (used for bounds check).
-     *  @param out Destination vector to receive the keypoint.
-     *  @return True if the keypoint was within bounds and added; false otherwise.
-     */
-    static bool addKeypointCandidate(int x,
-                                     int y,
-                                     int windowSize,
-                                     int octaveIndex,
-                                     float response,
-                                     int cols,
-                                     int rows,
-                                     std::vector<cv::KeyPoint>& out);
+    LPScanSettings scan_; // window sizes, ramp and candidate filtering of the window scan
 };
 
 #endif //LPORB_H
@@ -0,0 +1,466 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * lppeaks.cpp
+ * Shared Local Peaks detection and candidate post-processing used by the LP detectors (LPSIFT, LPORB).
+ */
+
+#include "lppeaks.h"
+#include "trace.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <unordered_set>
+
+using namespace cv;
+
+namespace {
+
+// Column band width for the parallel running-filter passes
+constexpr int BAND_COLS = 256;
+
+/*
+ * One vertical van Herk/Gil-Werman pass.
+ * For windows of L rows starting at rows 0, S, 2S, ... returns the extremum of every column (outVal)
+ * and the source row it came from (outArg). Rows are split into blocks of L; g holds prefix extrema
+ * and h suffix extrema within each block, so any L-row window is max(h[start], g[start + L - 1]).
+ * Inner loops run over contiguous columns so the compiler can vectorize the compare/select.
+ */
+template <bool IsMax>
+void runningExtremumRows(const Mat& src, const int L, const int S, Mat& outVal, Mat& outArg) {
+    const int rows = src.rows;
+    const int cols = src.cols;
+    const int nOut = (rows - L) / S + 1;
+
+    Mat gVal(rows, cols, CV_32F), hVal(rows, cols, CV_32F);
+    Mat gArg(rows, cols, CV_32S), hArg(rows, cols, CV_32S);
+    outVal.create(nOut, cols, CV_32F);
+    outArg.create(nOut, cols, CV_32S);
+
+    const int bands = (cols + BAND_COLS - 1) / BAND_COLS;
+    parallel_for_(Range(0, bands), [&](const Range& range) {
+        const int c0 = range.start * BAND_COLS;
+        const int c1 = std::min(cols, range.end * BAND_COLS);
+
+        // Prefix extrema, restarting at each block start
+        for (int r = 0; r < rows; ++r) {
+            const float* s = src.ptr<float>(r);
+            float* gv = gVal.ptr<float>(r);
+            int* ga = gArg.ptr<int>(r);
+            if (r % L == 0) {
+                for (int c = c0; c < c1; ++c) { gv[c] = s[c]; ga[c] = r; }
+                continue;
+            }
+            const float* pv = gVal.ptr<float>(r - 1);
+            const int* pa = gArg.ptr<int>(r - 1);
+            for (int c = c0; c < c1; ++c) {
+                const bool take = IsMax ? s[c] > pv[c] : s[c] < pv[c];
+                gv[c] = take ? s[c] : pv[c];
+                ga[c] = take ? r : pa[c];
+            }
+        }
+
+        // Suffix extrema, restarting at each block end
+        for (int r = rows - 1; r >= 0; --r) {
+            const float* s = src.ptr<float>(r);
+            float* hv = hVal.ptr<float>(r);
+            int* ha = hArg.ptr<int>(r);
+            if (r == rows - 1 || (r + 1) % L == 0) {
+                for (int c = c0; c < c1; ++c) { hv[c] = s[c]; ha[c] = r; }
+                continue;
+            }
+            const float* nv = hVal.ptr<float>(r + 1);
+            const int* na = hArg.ptr<int>(r + 1);
+            for (int c = c0; c < c1; ++c) {
+                const bool take = IsMax ? s[c] > nv[c] : s[c] < nv[c];
+                hv[c] = take ? s[c] : nv[c];
+                ha[c] = take ? r : na[c];
+            }
+        }
+
+        // Combine suffix of the window start with prefix of the window end
+        for (int j = 0; j < nOut; ++j) {
+            const int r0 = j * S;
+            const int r1 = r0 + L - 1;
+            const float* hv = hVal.ptr<float>(r0);
+            const int* ha = hArg.ptr<int>(r0);
+            const float* gv = gVal.ptr<float>(r1);
+            const int* ga = gArg.ptr<int>(r1);
+            float* ov = outVal.ptr<float>(j);
+            int* oa = outArg.ptr<int>(j);
+            for (int c = c0; c < c1; ++c) {
+                const bool takeH = IsMax ? hv[c] >= gv[c] : hv[c] <= gv[c];
+                ov[c] = takeH ? hv[c] : gv[c];
+                oa[c] = takeH ? ha[c] : ga[c];
+            }
+        }
+    });
+}
+
+/*
+ * 2D running extremum of L x L windows at stride S.
+ * outVal(j, k) is the extremum of the window at (k*S, j*S); outX/outY hold its location.
+ */
+template <bool IsMax>
+void runningExtremum2D(const Mat& transposed, const int L, const int S, Mat& outVal, Mat& outX, Mat& outY) {
+    // Horizontal pass on the transposed image: rows of colVal are window x-origins, columns are y
+    Mat colVal, colArgX;
+    runningExtremumRows<IsMax>(transposed, L, S, colVal, colArgX);
+
+    // Back to image orientation: rows are y, columns are window x-origins
+    Mat rowVal, rowArgX;
+    transpose(colVal, rowVal);
+    transpose(colArgX, rowArgX);
+
+    // Vertical pass
+    runningExtremumRows<IsMax>(rowVal, L, S, outVal, outY);
+
+    // Carry x from the winning row of the horizontal pass
+    outX.create(outVal.rows, outVal.cols, CV_32S);
+    for (int j = 0; j < outVal.rows; ++j) {
+        const int* ys = outY.ptr<int>(j);
+        int* xs = outX.ptr<int>(j);
+        for (int k = 0; k < outVal.cols; ++k) {
+            xs[k] = rowArgX.at<int>(ys[k], k);
+        }
+    }
+}
+
+} // anonymous namespace
+
+namespace lp {
+
+void addLinearRamp(Mat& image, const float alpha) {
+    // Input checks
+    if (alpha <= 0.0f || image.empty()) return;
+
+    // Pre-compute ramp and add to image
+    Mat ramp(image.rows, image.cols, CV_32F);
+    auto* data = ramp.ptr<float>();
+    std::iota(data, data + ramp.total(), 0.0f); // 0,1,2,... in raster order
+    ramp *= alpha;
+    image += ramp;
+}
+
+void gridWindowExtrema(const Mat& image,
+                       const int windowSize,
+                       std::vector<LPWindowPeak>& peaks) {
+    peaks.clear();
+    const int L = windowSize;
+
+    // Parse image in y and x direction
+    for (int y = 0; y + L <= image.rows; y += L) {
+        for (int x = 0; x + L <= image.cols; x += L) {
+            const Rect roi(x, y, L, L);
+
+            double minVal = 0.0, maxVal = 0.0;
+            Point minLoc, maxLoc;
+            minMaxLoc(image(roi), &minVal, &maxVal, &minLoc, &maxLoc);
+
+            LPWindowPeak peak;
+            peak.window = roi;
+            peak.maxLoc = Point(x + maxLoc.x, y + maxLoc.y);
+            peak.minLoc = Point(x + minLoc.x, y + minLoc.y);
+            peak.maxVal = static_cast<float>(maxVal);
+            peak.minVal = static_cast<float>(minVal);
+            peaks.push_back(peak);
+        }
+    }
+}
+
+void slidingWindowExtrema(const Mat& image,
+                          const int windowSize,
+                          const int stride,
+                          std::vector<LPWindowPeak>& peaks) {
+    peaks.clear();
+    const int L = windowSize;
+    const int S = std::max(1, stride);
+    if (image.empty() || L > image.rows || L > image.cols) return;
+
+    CV_Assert(image.type() == CV_32F);
+
+    Mat transposed;
+    transpose(image, transposed);
+
+    Mat maxVal, maxX, maxY, minVal, minX, minY;
+    runningExtremum2D<true>(transposed, L, S, maxVal, maxX, maxY);
+    runningExtremum2D<false>(transposed, L, S, minVal, minX, minY);
+
+    peaks.reserve(static_cast<size_t>(maxVal.rows) * maxVal.cols);
+    for (int j = 0; j < maxVal.rows; ++j) {
+        for (int k = 0; k < maxVal.cols; ++k) {
+            LPWindowPeak peak;
+            peak.window = Rect(k * S, j * S, L, L);
+            peak.maxLoc = Point(maxX.at<int>(j, k), maxY.at<int>(j, k));
+            peak.minLoc = Point(minX.at<int>(j, k), minY.at<int>(j, k));
+            peak.maxVal = maxVal.at<float>(j, k);
+            peak.minVal = minVal.at<float>(j, k);
+            peaks.push_back(peak);
+        }
+    }
+}
+
+size_t pruneCandidates(const Mat& image,
+                       std::vector<KeyPoint>& keypoints,
+                       const LPPruneParams& params) {
+    const size_t n = keypoints.size();
+    if (!params.enabled || n == 0 || image.empty()) return 0;
+
+    CV_Assert(image.type() == CV_32F);
+
+    // Contrast threshold relative to the response distribution of each window size
+    std::map<int, std::vector<float>> responsesByWindow;
+    for (const auto& kp : keypoints) {
+        responsesByWindow[kp.class_id].push_back(kp.response);
+    }
+
+    std::map<int, float> minResponse;
+    for (auto& [windowSize, responses] : responsesByWindow) {
+        auto mid = responses.begin() + static_cast<std::ptrdiff_t>(responses.size() / 2);
+        std::nth_element(responses.begin(), mid, responses.end());
+        minResponse[windowSize] = params.contrastRatio * *mid;
+    }
+
+    // Gather the 3x3 neighbourhood of every candidate: row k holds neighbour k for all candidates
+    // Neighbour order (dx, dy): 0(-1,-1) 1(0,-1) 2(1,-1) 3(-1,0) 4(0,0) 5(1,0) 6(-1,1) 7(0,1) 8(1,1)
+    Mat nbhd(9, static_cast<int>(n), CV_32F);
+    const int maxX = image.cols - 1;
+    const int maxY = image.rows - 1;
+    for (size_t i = 0; i < n; ++i) {
+        const int x = cvRound(keypoints[i].pt.x);
+        const int y = cvRound(keypoints[i].pt.y);
+        int k = 0;
+        for (int dy = -1; dy <= 1; ++dy) {
+            const float* row = image.ptr<float>(std::clamp(y + dy, 0, maxY));
+            for (int dx = -1; dx <= 1; ++dx) {
+                nbhd.at<float>(k++, static_cast<int>(i)) = row[std::clamp(x + dx, 0, maxX)];
+            }
+        }
+    }
+
+    // Hessian eigenvalue-ratio test over all candidates at once
+    const Mat center2 = nbhd.row(4) * 2.0;
+    const Mat dxx = nbhd.row(3) + nbhd.row(5) - center2;
+    const Mat dyy = nbhd.row(1) + nbhd.row(7) - center2;
+    const Mat dxy = (nbhd.row(8) - nbhd.row(6) - nbhd.row(2) + nbhd.row(0)) * 0.25;
+
+    const Mat tr = dxx + dyy;
+    const Mat det = dxx.mul(dyy) - dxy.mul(dxy);
+    const double r = params.edgeThreshold;
+    const Mat lhs = tr.mul(tr) * r;
+    const Mat rhs = det * ((r + 1) * (r + 1));
+
+    Mat isPeak, notEdge, keep;
+    compare(det, 0.0, isPeak, CMP_GT);
+    compare(lhs, rhs, notEdge, CMP_LT);
+    bitwise_and(isPeak, notEdge, keep);
+
+    // Compact in place, preserving order
+    const uchar* keepPtr = keep.ptr<uchar>();
+    size_t kept = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const KeyPoint& kp = keypoints[i];
+        if (keepPtr[i] && kp.response >= minResponse[kp.class_id]) {
+            keypoints[kept++] = kp;
+        }
+    }
+    keypoints.resize(kept);
+
+    return n - kept;
+}
+
+bool isNeighbourhoodExtremum(const Mat& image,
+                             const Point p,
+                             const Rect& tile,
+                             const int radius,
+                             const bool isMax) {
+    const Rect nbhd = Rect(p.x - radius, p.y - radius, 2 * radius + 1, 2 * radius + 1) &
+                      Rect(0, 0, image.cols, image.rows);
+
+    // Neighbourhood fully inside the tile: the window scan already proved it
+    if ((nbhd & tile) == nbhd) return true;
+
+    double minVal = 0.0, maxVal = 0.0;
+    minMaxLoc(image(nbhd), &minVal, &maxVal);
+
+    const double value = image.at<float>(p.y, p.x);
+    return isMax ? maxVal <= value : minVal >= value;
+}
+
+void assignOrientations(const Mat& image,
+                        std::vector<KeyPoint>& keypoints,
+                        const int maxRadius) {
+    CV_Assert(image.type() == CV_8UC1);
+
+    parallel_for_(Range(0, static_cast<int>(keypoints.size())), [&](const Range& range) {
+        for (int i = range.start; i < range.end; ++i) {
+            KeyPoint& kp = keypoints[i];
+            const int radius = std::max(1, std::min(maxRadius, cvRound(kp.size / 2.0f)));
+            const int cx = cvRound(kp.pt.x);
+            const int cy = cvRound(kp.pt.y);
+
+            // First-order moments of the disc about the keypoint
+            double m01 = 0.0, m10 = 0.0;
+            for (int dy = -radius; dy <= radius; ++dy) {
+                const int y = cy + dy;
+                if (y < 0 || y >= image.rows) continue;
+                const int half = cvFloor(std::sqrt(static_cast<double>(radius * radius - dy * dy)));
+                const int x0 = std::max(0, cx - half);
+                const int x1 = std::min(image.cols - 1, cx + half);
+                const uchar* row = image.ptr<uchar>(y);
+                for (int x = x0; x <= x1; ++x) {
+                    m10 += (x - cx) * row[x];
+                    m01 += dy * row[x];
+                }
+            }
+            kp.angle = fastAtan2(static_cast<float>(m01), static_cast<float>(m10));
+        }
+    });
+}
+
+Mat preprocess(InputArray image, const float alpha) {
+    const Mat src = image.getMat();
+
+    Mat gray;
+    if (src.channels() > 1) {
+        cvtColor(src, gray, COLOR_BGR2GRAY);
+        gray.convertTo(gray, CV_32F);
+    } else {
+        src.convertTo(gray, CV_32F); // e.g. a Y-plane view: converted straight from the caller's buffer
+    }
+    addLinearRamp(gray, alpha);
+
+    return gray;
+}
+
+void detectScale(const Mat& gray,
+                 const LPScanSettings& settings,
+                 const size_t idx,
+                 const char* spanName,
+                 std::vector<KeyPoint>& keypoints,
+                 LPDetectionStats& stats) {
+    const int rows = gray.rows;
+    const int cols = gray.cols;
+
+    std::vector<LPWindowPeak> peaks;
+    std::unordered_set<long long> seen;
+    std::vector<KeyPoint> scaleKeypoints;
+
+    const int L = settings.windowSizes[idx];
+    if (L <= 0) return;
+    const auto scaleStart = std::chrono::steady_clock::now();
+    trace::Span span(spanName);
+    span.arg("window_size", L);
+    const bool dense = settings.dense.enabled;
+    const bool checkBorders = settings.borderCheck.enabled;
+    const int borderRadius = borderCheckRadius(settings.borderCheck, L);
+
+    // Window extrema: the paper's fixed grid, or overlapping windows at stride L / strideDivisor
+    if (dense) {
+        slidingWindowExtrema(gray, L, denseStride(settings.dense, L), peaks);
+    } else {
+        gridWindowExtrema(gray, L, peaks);
+    }
+
+    // Overlapping windows report the same extremum more than once; keep the first
+    auto firstVisit = [&](const Point& p, const bool isMax) {
+        if (!dense) return true; // grid windows are disjoint
+        const long long key = (static_cast<long long>(p.y) * cols + p.x) * 2 + (isMax ? 1 : 0);
+        return seen.insert(key).second;
+    };
+
+    for (const auto& peak : peaks) {
+        const float response = peak.maxVal - peak.minVal; // difference in intensity between min and max
+
+        for (const bool isMax : { true, false }) {
+            const Point& loc = isMax ? peak.maxLoc : peak.minLoc;
+            if (!firstVisit(loc, isMax)) continue;
+            ++stats.candidates;
+
+            // Drop extrema that only win because the tile border clipped an intensity slope
+            if (checkBorders && !isNeighbourhoodExtremum(gray, loc, peak.window, borderRadius, isMax)) {
+                ++stats.borderRejected;
+                continue;
+            }
+            if (loc.x < 0 || loc.y < 0 || loc.x >= cols || loc.y >= rows) continue;
+
+            KeyPoint kp(Point2f(static_cast<float>(loc.x), static_cast<float>(loc.y)), static_cast<float>(L));
+            kp.response = response;
+            kp.angle = -1.0f; // let the descriptor assign orientation during compute()
+            kp.octave = static_cast<int>(idx);
+            kp.class_id = L; // store interrogation window size
+            scaleKeypoints.push_back(kp);
+        }
+    }
+
+    // Drop low-contrast and edge-like peaks before they reach description and matching
+    if (settings.prune.enabled) {
+        const auto pruneStart = std::chrono::steady_clock::now();
+        stats.pruned += pruneCandidates(gray, scaleKeypoints, settings.prune);
+        stats.pruneSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - pruneStart).count();
+    }
+
+    keypoints.insert(keypoints.end(), scaleKeypoints.begin(), scaleKeypoints.end());
+    span.arg("keypoints", static_cast<int64_t>(scaleKeypoints.size()));
+    stats.windowSeconds[L] += std::chrono::duration<double>(std::chrono::steady_clock::now() - scaleStart).count();
+}
+
+void detectPeaks(InputArray image,
+                 const LPScanSettings& settings,
+                 const char* spanName,
+                 std::vector<KeyPoint>& keypoints,
+                 LPDetectionStats& stats) {
+    keypoints.clear();
+    stats = LPDetectionStats{};
+
+    // Early exit if image is empty
+    if (image.empty()) return;
+
+    const Mat gray = preprocess(image, settings.linearNoiseAlpha);
+
+    // Loop through window sizes
+    for (size_t idx = 0; idx < settings.windowSizes.size(); ++idx) {
+        detectScale(gray, settings, idx, spanName, keypoints, stats);
+    }
+}
+
+void detectPeakScales(InputArray image,
+                      const LPScanSettings& settings,
+                      const char* spanName,
+                      const LPScaleCallback& onBatch,
+                      LPDetectionStats& stats) {
+    stats = LPDetectionStats{};
+
+    // Early exit if image is empty
+    if (image.empty()) return;
+
+    const Mat gray = preprocess(image, settings.linearNoiseAlpha);
+    const std::vector<int>& sizes = settings.windowSizes;
+
+    // Coarsest window first: fewest, most distinctive peaks reach matching earliest
+    std::vector<size_t> order(sizes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&sizes](const size_t a, const size_t b) {
+        return sizes[a] > sizes[b];
+    });
+
+    for (const size_t idx : order) {
+        LPScaleBatch batch;
+        batch.windowSize = sizes[idx];
+        batch.scaleIndex = static_cast<int>(idx);
+
+        const auto start = std::chrono::steady_clock::now();
+        detectScale(gray, settings, idx, spanName, batch.keypoints, stats);
+        batch.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (!onBatch(batch)) break;
+    }
+}
+
+} // namespace lp
@@ -0,0 +1,217 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * lppeaks.h
+ * Shared Local Peaks detection and candidate post-processing used by the LP detectors (LPSIFT, LPORB).
+ * Based on Hao Li et al., "Local-peak scale-invariant feature transform for fast and random image stitching"
+ * (arXiv:2405.08578v2).
+ */
+
+#ifndef LPPEAKS_H
+#define LPPEAKS_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <vector>
+
+// Contrast and edge-response pruning of LP candidates (disabled by default to match the paper)
+struct LPPruneParams {
+    bool enabled = false;
+    float contrastRatio = 0.1f;  // drop candidates below ratio * median response of their window size
+    float edgeThreshold = 10.0f; // max principal curvature ratio r (same meaning as SIFT's edgeThreshold)
+};
+
+// Rejection of window extrema that are not extrema of their neighbourhood across tile borders
+// (disabled by default to match the paper)
+struct LPBorderCheckParams {
+    bool enabled = false;
+    int radiusDivisor = 4; // neighbourhood radius is max(1, L / radiusDivisor)
+};
+
+// Overlapping (strided) interrogation windows instead of the paper's fixed grid
+struct LPDenseParams {
+    bool enabled = false;
+    int strideDivisor = 2; // window stride is max(1, L / strideDivisor)
+};
+
+// Maximum and minimum of one interrogation window (image coordinates)
+struct LPWindowPeak {
+    cv::Rect window;
+    cv::Point maxLoc;
+    cv::Point minLoc;
+    float maxVal = 0.0f;
+    float minVal = 0.0f;
+};
+
+// Keypoints of one window size, emitted by the streaming (coarse-to-fine) detection API
+struct LPScaleBatch {
+    int windowSize = 0;
+    int scaleIndex = 0;                  // index into the detector's window sizes (stored in kp.octave)
+    std::vector<cv::KeyPoint> keypoints;
+    double seconds = 0.0;                // detection time of this scale
+};
+
+// Receives each scale batch in coarse-to-fine order; return false to skip the remaining finer scales
+using LPScaleCallback = std::function<bool(LPScaleBatch& batch)>;
+
+// Everything the Local Peaks window scan of LPSIFT and LPORB depends on
+struct LPScanSettings {
+    std::vector<int> windowSizes;
+    float linearNoiseAlpha = 0.0f;
+    LPPruneParams prune;
+    LPBorderCheckParams borderCheck;
+    LPDenseParams dense;
+};
+
+// Per-call detection statistics reported by the LP detectors
+struct LPDetectionStats {
+    size_t candidates = 0;     // extrema produced by the window scan
+    size_t borderRejected = 0; // candidates dropped as tile-border pseudo-peaks
+    size_t pruned = 0;         // candidates removed by contrast/edge pruning
+    double pruneSeconds = 0.0; // time spent pruning
+    std::map<int, double> windowSeconds; // detection time per window size (kp.class_id), pruning included
+};
+
+namespace lp {
+
+/** @brief Add the linear ramp alpha * (y * cols + x) that makes every window extremum unique (Section 2.1).
+ *  @param image Single-channel CV_32F image, modified in place (no-op if empty or alpha <= 0).
+ *  @param alpha Ramp magnitude.
+ */
+void addLinearRamp(cv::Mat& image, float alpha);
+
+/** @brief Extrema of the non-overlapping L x L grid of interrogation windows (paper Section 2.2).
+ *  @param image Preprocessed single-channel CV_32F image.
+ *  @param windowSize Interrogation window size L.
+ *  @param peaks Output window extrema in raster order of the windows.
+ */
+void gridWindowExtrema(const cv::Mat& image,
+                       int windowSize,
+                       std::vector<LPWindowPeak>& peaks);
+
+/** @brief Extrema of every L x L window placed at the given stride.
+ *
+ *  Uses van Herk/Gil-Werman running max/min filters with argument tracking, so the cost per pixel
+ *  is constant and independent of L. The separable passes run as contiguous row operations over
+ *  column bands in parallel; the horizontal pass runs on the transposed image.
+ *  @param image Preprocessed single-channel CV_32F image.
+ *  @param windowSize Interrogation window size L.
+ *  @param stride Distance between window origins (stride == L reproduces the grid).
+ *  @param peaks Output window extrema in raster order of the windows.
+ */
+void slidingWindowExtrema(const cv::Mat& image,
+                          int windowSize,
+                          int stride,
+                          std::vector<LPWindowPeak>& peaks);
+
+/** @brief Window stride used in dense mode for window size L. */
+inline int denseStride(const LPDenseParams& params, const int windowSize) {
+    return std::max(1, windowSize / std::max(1, params.strideDivisor));
+}
+
+/** @brief Remove low-contrast and edge-like Local Peaks candidates in place.
+ *
+ *  Contrast: a candidate is kept if its window response (max - min) is at least
+ *  contrastRatio times the median response of candidates with the same window size (kp.class_id).
+ *  Edge: the 3x3 Hessian at the peak must satisfy det > 0 and tr^2 / det < (r + 1)^2 / r.
+ *  Neighbourhoods are gathered once and the Hessian test runs as whole-array operations.
+ *  @param image Preprocessed single-channel CV_32F image the candidates were detected on.
+ *  @param keypoints Candidates (modified in place, order preserved).
+ *  @param params Pruning parameters.
+ *  @return Number of candidates removed.
+ */
+size_t pruneCandidates(const cv::Mat& image,
+                       std::vector<cv::KeyPoint>& keypoints,
+                       const LPPruneParams& params);
+
+/** @brief Check that a window extremum is also an extremum of its neighbourhood across tile borders.
+ *
+ *  A window sitting on an intensity slope reports its extremum on the tile border; such a point
+ *  is beaten by pixels just outside the tile. Only candidates closer than radius to the tile border
+ *  need the test; others pass immediately since the window scan already covered their neighbourhood.
+ *  @param image Preprocessed single-channel CV_32F image.
+ *  @param p Candidate location (image coordinates).
+ *  @param tile Window the candidate was found in.
+ *  @param radius Neighbourhood radius (pixels).
+ *  @param isMax True for a window maximum, false for a minimum.
+ *  @return True if no pixel in the (image-clipped) neighbourhood beats the candidate.
+ */
+bool isNeighbourhoodExtremum(const cv::Mat& image,
+                             cv::Point p,
+                             const cv::Rect& tile,
+                             int radius,
+                             bool isMax);
+
+/** @brief Neighbourhood radius used by the border check for window size L. */
+inline int borderCheckRadius(const LPBorderCheckParams& params, const int windowSize) {
+    return std::max(1, windowSize / std::max(1, params.radiusDivisor));
+}
+
+/** @brief Convert to single-channel CV_32F and add the linear ramp (Section 2.1).
+ *  @param image Input image (non-empty, BGR or single-channel).
+ *  @param alpha Ramp magnitude.
+ *  @return Preprocessed image shared by all scales.
+ */
+cv::Mat preprocess(cv::InputArray image, float alpha);
+
+/** @brief Detect, border-check and prune the candidates of one window size.
+ *  @param gray Preprocessed image.
+ *  @param settings Scan settings of the detector.
+ *  @param idx Index into settings.windowSizes (stored in kp.octave; the window size goes to kp.class_id).
+ *  @param spanName Trace span name of one scale (e.g. "LP-SIFT scale").
+ *  @param keypoints Destination vector; this scale's keypoints are appended.
+ *  @param stats Statistics accumulated across scales.
+ */
+void detectScale(const cv::Mat& gray,
+                 const LPScanSettings& settings,
+                 size_t idx,
+                 const char* spanName,
+                 std::vector<cv::KeyPoint>& keypoints,
+                 LPDetectionStats& stats);
+
+/** @brief Detect the keypoints of every window size, in the order of settings.windowSizes.
+ *  @param image Input image.
+ *  @param settings Scan settings of the detector.
+ *  @param spanName Trace span name of one scale.
+ *  @param keypoints Output keypoints (cleared first).
+ *  @param stats Output statistics for this call.
+ */
+void detectPeaks(cv::InputArray image,
+                 const LPScanSettings& settings,
+                 const char* spanName,
+                 std::vector<cv::KeyPoint>& keypoints,
+                 LPDetectionStats& stats);
+
+/** @brief Emit one keypoint batch per window size, coarsest first.
+ *  @param image Input image.
+ *  @param settings Scan settings of the detector.
+ *  @param spanName Trace span name of one scale.
+ *  @param onBatch Called once per scale; returning false stops before the next (finer) scale.
+ *  @param stats Output statistics accumulated over the emitted scales.
+ */
+void detectPeakScales(cv::InputArray image,
+                      const LPScanSettings& settings,
+                      const char* spanName,
+                      const LPScaleCallback& onBatch,
+                      LPDetectionStats& stats);
+
+/** @brief Dominant orientation of each keypoint from its intensity centroid (as ORB does), in place.
+ *
+ *  The LP detectors leave kp.angle at -1, which SIFT and ORB describe as an upright patch; this makes
+ *  the descriptors computed afterwards rotation invariant. The centroid is taken over a disc of radius
+ *  min(kp.size / 2, maxRadius), clipped to the image.
+ *  @param image Single-channel CV_8U image the keypoints were detected on.
+ *  @param keypoints Keypoints whose angle (degrees, [0, 360)) is set.
+ *  @param maxRadius Largest disc radius (pixels).
+ */
+void assignOrientations(const cv::Mat& image,
+                        std::vector<cv::KeyPoint>& keypoints,
+                        int maxRadius);
+
+} // namespace lp
+
+#endif //LPPEAKS_H
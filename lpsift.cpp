@@ -24,7 +24,6 @@
 
 #include <algorithm>
 #include <cmath>
-#include <numeric>
 
 using namespace cv;
 
@@ -36,98 +35,31 @@ Ptr<LPSIFT> LPSIFT::create(const std::vector<int>& windowSizes,
 LPSIFT::LPSIFT(const std::vector<int>& windowSizes,
                const float linearNoiseAlpha)
     : descriptor_(SIFT::create()), // Note that SIFT is instantiated here for later use
-      windowSizes_(windowSizes),
-      linearNoiseAlpha_(linearNoiseAlpha) {}
+      scan_{windowSizes, linearNoiseAlpha} {}
 
 String LPSIFT::getDefaultName() const {
     return "Feature2D.LPSIFT";
 }
 
-// Section 2.1: Image Preprocessing
-// Adds alpha * (y * cols + x) to each pixel to break flat plateaus deterministically.
-// Minima and maxima are biased top to bottom if a window is perfectly flat.
-void LPSIFT::addLinearRamp(Mat& image) const {
-    // Input checks
-    if (linearNoiseAlpha_ <= 0.0f || image.empty()) return;
-
-    // Pre-compute ramp and add to image
-    Mat ramp(image.rows, image.cols, CV_32F);
-    auto* data = ramp.ptr<float>();
-    std::iota(data, data + ramp.total(), 0.0f); // 0,1,2,... in raster order
-    ramp *= linearNoiseAlpha_;
-    image += ramp;
-}
-
-bool LPSIFT::addKeypointCandidate(const int x,
-                                  const int y,
-                                  const int windowSize,
-                                  const int octaveIndex,
-                                  const float response,
-                                  const int cols,
-                                  const int rows,
-                                  std::vector<KeyPoint>& out) {
-    if (x < 0 || y < 0 || x >= cols || y >= rows || windowSize <= 0) return false;
-
-    const auto size = static_cast<float>(windowSize);
-    KeyPoint kp(Point2f(static_cast<float>(x), static_cast<float>(y)), size);
-    kp.response = response; // difference in intensity between min and max
-    kp.angle = -1.0f; // let SIFT assign orientation during compute()
-    kp.octave = octaveIndex;
-    kp.class_id = windowSize; // store interrogation window size
-    out.push_back(kp);
-    return true;
-}
-
 /// Section 2.2 Feature Point Detection
 void LPSIFT::detect(InputArray image,
                     std::vector<KeyPoint>& keypoints,
                     InputArray mask) {
     CV_UNUSED(mask); // Mask input is kept for API compatibility. Not implemented.
-    keypoints.clear();
-
-    // Early exit if image is empty
-    if (image.empty()) return;
-
-    const Mat src = image.getMat();
-
-    Mat gray;
-    if (src.channels() > 1) {
-        cvtColor(src, gray, COLOR_BGR2GRAY);
-    } else {
-        gray = src.clone();
-    }
-
-    gray.convertTo(gray, CV_32F);
-    addLinearRamp(gray);
-
-    const int rows = gray.rows;
-    const int cols = gray.cols;
-
-    // Loop through window sizes
-    for (size_t idx = 0; idx < windowSizes_.size(); ++idx) {
-        const int L = windowSizes_[idx];
-        // Parse image in y and x direction
-        for (int y = 0; y + L <= rows; y += L) {
-            for (int x = 0; x + L <= cols; x += L) {
-                Rect roi(x, y, L, L);
-
-                Mat tile = gray(roi);
-                double minVal = 0.0, maxVal = 0.0;
-                Point minLoc, maxLoc;
-
-                minMaxLoc(tile, &minVal, &maxVal, &minLoc, &maxLoc);
+    LPDetectionStats stats;
+    detectWithStats(image, keypoints, stats);
+}
 
-                const int gxMax = x + maxLoc.x;
-                const int gyMax = y + maxLoc.y;
-                const int gxMin = x + minLoc.x;
-                const int gyMin = y + minLoc.y;
-                const auto response = static_cast<float>(maxVal - minVal);
+void LPSIFT::detectWithStats(InputArray image,
+                             std::vector<KeyPoint>& keypoints,
+                             LPDetectionStats& stats) const {
+    lp::detectPeaks(image, scan_, "LP-SIFT scale", keypoints, stats);
+}
 
-                addKeypointCandidate(gxMax, gyMax, L, static_cast<int>(idx), response, cols, rows, keypoints);
-                addKeypointCandidate(gxMin, gyMin, L, static_cast<int>(idx), response, cols, rows, keypoints);
-            }
-        }
-    }
+void LPSIFT::detectScales(InputArray image,
+                          const LPScaleCallback& onBatch,
+                          LPDetectionStats& stats) const {
+    lp::detectPeakScales(image, scan_, "LP-SIFT scale", onBatch, stats);
 }
 
 /// Section 2.3 Feature Point Description
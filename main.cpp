@@ -22,13 +22,68 @@
  *      - Example: ./css587project buildings street
  * 
  *	 ./css587project <set1>[det1,det2,...] ... - Run demo on specific image sets with detector filters (SIFT runs regardless for H matrix comparison)
- *      - Options: [SIFT,ORB,BRISK,SURF,LPSIFT,LPORB] (case sensitive, must be uppercase)
+ *      - Options: [SIFT,ORB,BRISK,SURF,LPSIFT,LPORB,LPDOG] (case sensitive, must be uppercase)
  *		- Example: ./css587project buildings[ORB,BRISK] street[LPSIFT]
  *   
  *   ./css587project [det1,det2,...]      - Run all buildings with specified detectors (SIFT runs regardless for H matrix comparison)
- *      - Options: [SIFT,ORB,BRISK,SURF,LPSIFT,LPORB] (case sensitive, must be uppercase)
+ *      - Options: [SIFT,ORB,BRISK,SURF,LPSIFT,LPORB,LPDOG] (case sensitive, must be uppercase)
  *      - Example: ./css587project [LPSIFT]
  *  
+ *   ./css587project --prune ...          - Prune low-contrast and edge-like LP candidates before description
+ *
+ *   ./css587project --border-check ...   - Reject LP tile-border pseudo-peaks that are not neighbourhood extrema
+ *
+ *   ./css587project --dense ...          - Detect LP peaks in overlapping windows at stride L/2 instead of the grid
+ *
+ *   ./css587project --stream ...         - Pipeline LP detection/description/matching per scale, coarse to fine,
+ *                                          and stop once the homography is confident
+ *
+ *   ./css587project --concurrent-stages ... - Run both images' stitching stages concurrently on a task graph
+ *
+ *   ./css587project --no-prefetch ...    - Decode each image set when it is benchmarked instead of in the background
+ *
+ *   ./css587project --throughput [--pin] ... - Run (dataset, detector) jobs concurrently, optionally pinned to cores
+ *                                          (--latency, the default, runs one job at a time)
+ *
+ *   ./css587project --ingest-scale <N> ... - Decode images straight to grayscale at 1/N resolution (N = 1, 2, 4, 8)
+ *
+ *   ./css587project --ingest nv12 ... - Ingest every image as an NV12 camera frame (YUVFrame) instead of a gray decode
+ *
+ *   ./css587project --save-features <file> ... - Append the features of registered pairs to a binary feature file
+ *
+ *   ./css587project --refresh-baseline ... - Rerun SIFT instead of loading the cached baseline (LP-only selections)
+ *   ./css587project --no-baseline-cache ...  - Neither load nor store SIFT baselines
+ *
+ *   ./css587project --mat-pool ...       - Serve each stitch's cv::Mat buffers from a pool reused across stitches
+ *
+ *   ./css587project --warmup <N> --repeat <M> ... - Run each stitch N times untimed, then M times measured
+ *                                        (medians, p90/p99, min and bootstrap CI per stage, also in results*.json)
+ *
+ *   ./css587project --perf-counters ...  - Hardware counters (IPC, cache miss rate, branch MPKI) and thread CPU time
+ *                                        per stage (Linux perf_event_open; "x" where unavailable)
+ *
+ *   ./css587project --mem-stats ...      - Count heap allocations and sample the RSS high-water mark per stage and
+ *                                        stitch (latency mode); Mat allocations and structure sizes are always recorded
+ *
+ *   ./css587project --budget <ms> ...    - Time budget per stitch: stages past their share of it degrade (fewer LP
+ *                                        scales, partial matching, capped RANSAC, lower-resolution warp)
+ *
+ *   ./css587project --escalate ...       - Retry failed or degenerate LP registrations with finer scales, dense
+ *                                        stride, orientation, then SIFT in the predicted overlap
+ *
+ *   ./css587project --trace <file> ...   - Write a Chrome trace (chrome://tracing, ui.perfetto.dev) of the
+ *                                        stages, LP scales and worker threads
+ *
+ *   ./css587project --scaling [--scaling-threads 1,2,4] [--scaling-scales 8,4,2,1] ...
+ *                                      - Rerun the selected stitches at each thread count and ingest scale and
+ *                                        report per-stage speedup, efficiency and time per megapixel
+ *
+ *   ./css587project --compare <results.csv> [--threshold <pct> | <stage>=<pct>] ...
+ *                                      - Compare the run with a previous results file and exit with 2 on a
+ *                                        significant stage slowdown, a failed stitch or an accuracy drop
+ *
+ *   ./css587project --images <dir> ...   - Image directory to benchmark (repeatable, default: images)
+ *
  *   ./css587project --help               - Show help message
  */
 
@@ -52,6 +107,9 @@
 
 #include "lpsift.h"
 #include "benchmark.h"
+#include "trace.h"
+#include "scaling.h"
+#include "regression.h"
 
 using namespace std;
 using namespace cv;
@@ -82,11 +140,63 @@ void printUsage(const char* programName) {
 		<< "  " << programName << " <set1> <set2> ...         Run demo on specific image sets\n"
 		<< "     Example: buildings street\n\n"
 		<< "  " << programName << " <set1>[det1,det2,...] ... Run demo on specific image sets with detector filters (SIFT runs regardless for H matrix comparison)\n"
-		<< "     Options: [SIFT,ORB,BRISK,SURF,LPSIFT,LPORB] (case sensitive, must be uppercase)\n"
+		<< "     Options: [SIFT,ORB,BRISK,SURF,LPSIFT,LPORB,LPDOG] (case sensitive, must be uppercase)\n"
 		<< "     Example: buildings[ORB,BRISK] street[LPSIFT]\n\n"
 		<< "  " << programName << " [det1,det2,...]           Run all image sets with specified detectors (SIFT runs regardless for H matrix comparison)\n"
-		<< "     Options: [SIFT,ORB,BRISK,SURF,LPSIFT,LPORB] (case sensitive, must be uppercase)\n"
+		<< "     Options: [SIFT,ORB,BRISK,SURF,LPSIFT,LPORB,LPDOG] (case sensitive, must be uppercase)\n"
 		<< "     Example: [LPSIFT]\n\n"
+		<< "Options:\n\n"
+		<< "  --prune                   Prune low-contrast and edge-like LP candidates before description\n"
+		<< "  --border-check            Reject LP tile-border pseudo-peaks that are not neighbourhood extrema\n"
+		<< "  --dense                   Detect LP peaks in overlapping windows at stride L/2 instead of the grid\n"
+		<< "  --stream                  Pipeline LP detection, description and matching per scale (coarse to fine)\n"
+		<< "                            and stop early once the homography is confident\n"
+		<< "  --concurrent-stages       Run both images' detect/describe stages concurrently on a work-stealing\n"
+		<< "                            task graph and report summed stage time vs wall-clock time\n"
+		<< "  --no-prefetch             Decode each image set when it is benchmarked instead of prefetching\n"
+		<< "                            the next sets on background threads\n"
+		<< "  --throughput              Run independent (dataset, detector) jobs concurrently on a work-stealing\n"
+		<< "                            pool, OpenCV single-threaded per job (--latency: one at a time, default)\n"
+		<< "  --pin                     With --throughput, pin each job's worker thread to its own core\n"
+		<< "  --ingest-scale <N>        Decode images at 1/N resolution, N = 1 (default), 2, 4 or 8 (JPEG\n"
+		<< "                            DCT-domain downscaling); images are always decoded straight to grayscale\n"
+		<< "  --ingest <jpeg|nv12>      nv12: repack each decoded image as an NV12 camera frame and detect on its\n"
+		<< "                            Y plane in place; the composite converts from the frame (default: jpeg)\n"
+		<< "  --save-features <file>    Append keypoints and descriptors of successfully registered pairs to a\n"
+		<< "                            memory-mappable feature file (created if missing)\n"
+		<< "  --refresh-baseline        Rerun SIFT even when only LP detectors are selected and a cached baseline\n"
+		<< "                            exists for the image pair, and overwrite the cache entry\n"
+		<< "  --no-baseline-cache       Always run SIFT and do not read or write baseline_cache/\n"
+		<< "  --mat-pool                Allocate each stitch's cv::Mat buffers from a pool of huge-page aligned\n"
+		<< "                            arenas, released in bulk when the stitch ends\n"
+		<< "  --warmup <N>              Untimed runs of each stitch before the measured ones (default: 0)\n"
+		<< "  --repeat <M>              Measured runs of each stitch (default: 1); the CSV reports stage medians,\n"
+		<< "                            p90, p99, min and a bootstrap CI, also written to results*.json\n"
+		<< "  --perf-counters           Read hardware counters (Linux perf_event_open) and thread CPU time around\n"
+		<< "                            each stage; the CSV gets IPC, cache miss rate and branch MPKI per stage\n"
+		<< "  --mem-stats               Count operator new calls, and reset and read the process RSS high-water\n"
+		<< "                            mark around each stage and stitch (latency mode); Mat counts are always in the CSV\n"
+		<< "  --budget <ms>             Time budget per stitch (SIFT baselines excepted). Past their share of it,\n"
+		<< "                            LP detection stops adding scales, FLANN matching stops between query\n"
+		<< "                            batches, RANSAC is capped and the warp runs at 1/2 or 1/4 resolution;\n"
+		<< "                            budget use per stage and the degradations go to the CSV (stage by stage)\n"
+		<< "  --escalate                When an LP registration fails or its homography is degenerate, retry up a\n"
+		<< "                            ladder reusing the earlier features: finer scales, dense stride, keypoint\n"
+		<< "                            orientation, then SIFT in the overlap predicted by phase correlation\n"
+		<< "  --trace <file>            Write a Chrome trace event JSON of the pipeline stages, LP scales and\n"
+		<< "                            worker threads (open in chrome://tracing or ui.perfetto.dev)\n"
+		<< "  --scaling                 Rerun the selected stitches at each thread count (cv::setNumThreads and the\n"
+		<< "                            pool) and ingest scale; print speedup, parallel efficiency and time per MP\n"
+		<< "                            per stage, flag stages that stop scaling, and write scaling*.csv\n"
+		<< "  --scaling-threads <list>  Comma-separated thread counts (default: 1, 2, 4, ... up to the hardware threads)\n"
+		<< "  --scaling-scales <list>   Comma-separated ingest scales, coarse to fine (default: 8,4,2,1)\n"
+		<< "  --compare <file>          Compare with a previous results*.csv, matched by (dataset, algorithm, window\n"
+		<< "                            sizes); exit code 2 on a slower stage, failed stitch or accuracy drop\n"
+		<< "  --threshold <pct>         Allowed slowdown of a stage median for --compare (default: 10); repeat as\n"
+		<< "                            <stage>=<pct> for one stage, e.g. matching=20 (keys as in results*.json)\n"
+		<< "  --accuracy-tolerance <pct> Allowed growth of the homography error for --compare (default: 25)\n"
+		<< "  --images <dir>            Image directory to benchmark; repeat for several (default: images)\n"
+		<< "     Example: --throughput --images images --images images_extra\n\n"
 		<< "  " << programName << " --help                    Show this help message\n\n\n"
 		<< endl;
 }
@@ -129,7 +239,7 @@ void parseImageSetIdArg(string imageSetIdArg, set<string>& filteredImageSetIds,
 		vector<string> detectorTokens = splitString(detectorsCommaDelimited, ',');
 
 		// init filter struct
-		BenchmarkRunner::DetectorFilter filter = { false, false, false, false, false, false };
+		BenchmarkRunner::DetectorFilter filter = { false, false, false, false, false, false, false };
 
 		// parse detector sub-tokens
 		for (const string& token : detectorTokens) {
@@ -139,6 +249,7 @@ void parseImageSetIdArg(string imageSetIdArg, set<string>& filteredImageSetIds,
 			else if (token == "SURF") filter.SURF = true;
 			else if (token == "LPSIFT") filter.LPSIFT = true;
 			else if (token == "LPORB") filter.LPORB = true;
+			else if (token == "LPDOG") filter.LPDOG = true;
 			else {
 				throw new invalid_argument("Unknown detector in filter: " + token);
 			}
@@ -158,19 +269,46 @@ void parseImageSetIdArg(string imageSetIdArg, set<string>& filteredImageSetIds,
 }
 
 // Run benchmark mode
-int runBenchmark(const set<string>& filteredImageSets, const map<string,BenchmarkRunner::DetectorFilter>& filteredDetectors) {
+int runBenchmark(const vector<string>& imageDirs, const set<string>& filteredImageSets,
+	const map<string,BenchmarkRunner::DetectorFilter>& filteredDetectors, const BenchmarkRunner::Options& options,
+	const string& comparePath, const CompareOptions& compareOptions) {
 	cout << "=================================================\n"
 		<< "CSS 587 LP-SIFT Benchmarking Framework\n"
 		<< "=================================================\n\n";
 
-	if (!fs::exists(IMAGE_DIR) || !fs::is_directory(IMAGE_DIR)) {
-		cerr << "Error: Image directory does not exist: " << IMAGE_DIR << endl;
-		return 1;
+	for (const string& imageDir : imageDirs) {
+		if (!fs::exists(imageDir) || !fs::is_directory(imageDir)) {
+			cerr << "Error: Image directory does not exist: " << imageDir << endl;
+			return 1;
+		}
+	}
+
+	// Load the baseline first, so a bad path fails before the benchmark runs
+	vector<ResultRow> baselineRows;
+	if (!comparePath.empty()) {
+		string error;
+		if (!loadResultsCsv(comparePath, baselineRows, error)) {
+			cerr << "Error: --compare: " << error << endl;
+			return 1;
+		}
+		cout << "Comparing with baseline: " << comparePath << " (" << baselineRows.size() << " results)" << endl;
 	}
 
-	BenchmarkRunner runner;
+	BenchmarkRunner runner(options);
 
-	cout << "Image directory: " << IMAGE_DIR << endl;
+	if (!options.tracePath.empty()) {
+		if (trace::compiledIn()) {
+			trace::enable();
+			trace::setThreadName("main");
+		} else {
+			cout << "Note: tracing is compiled out (configure with -DLP_TRACING=ON), --trace ignored" << endl;
+		}
+	}
+
+	for (const string& imageDir : imageDirs) {
+		cout << "Image directory: " << imageDir << endl;
+	}
+	cout << "Execution mode: " << runner.executionMode() << endl;
 	cout << "\nStarting benchmark...\n" << endl;
 
 	// Create output directory for stitched images if needed
@@ -178,10 +316,22 @@ int runBenchmark(const set<string>& filteredImageSets, const map<string,Benchmar
 	fs::create_directories(outputDir);
 
 	// Run benchmarks on all image sets
-	auto results = runner.runOnDirectory(IMAGE_DIR, filteredImageSets, filteredDetectors, outputDir);
+	vector<StitchingMetrics> results;
+	for (const string& imageDir : imageDirs) {
+		auto dirResults = runner.runOnDirectory(imageDir, filteredImageSets, filteredDetectors, outputDir);
+		results.insert(results.end(), dirResults.begin(), dirResults.end());
+	}
+
+	if (trace::enabled()) {
+		if (trace::writeChromeTrace(options.tracePath)) {
+			cout << "Trace saved to: " << options.tracePath << endl;
+		} else {
+			cerr << "Error: Could not write trace to " << options.tracePath << endl;
+		}
+	}
 
 	if (results.empty()) {
-		cerr << "No benchmark results collected. Check if images exist in " << IMAGE_DIR << endl;
+		cerr << "No benchmark results collected. Check if images exist in the image directories" << endl;
 		return 1;
 	}
 
@@ -191,8 +341,18 @@ int runBenchmark(const set<string>& filteredImageSets, const map<string,Benchmar
 	CSVExporter exporter(outputFile);
 	exporter.writeAllMetrics(results);
 
+	// Per-stage repetition statistics next to the CSV (results_N.csv -> results_N.json)
+	JSONExporter jsonExporter(fs::path(exporter.filename()).replace_extension(".json").string());
+	jsonExporter.writeAllMetrics(results);
+
 	// Print summary table
 	BenchmarkRunner::printSummaryTable(results);
+	BenchmarkRunner::printPruningSummary(results);
+	BenchmarkRunner::printWindowSizeSummary(results);
+	BenchmarkRunner::printBudgetSummary(results);
+	BenchmarkRunner::printEscalationSummary(results);
+	BenchmarkRunner::printGroundTruthSummary(results);
+	cout << "\nExecution mode: " << runner.executionMode() << endl;
 
 	// Print statistics summary
 	cout << "\nStatistics by Algorithm:" << endl;
@@ -231,6 +391,79 @@ int runBenchmark(const set<string>& filteredImageSets, const map<string,Benchmar
 			<< endl;
 	}
 
+	// Regression gate: compare the file just written, so both sides are read the same way
+	if (!comparePath.empty()) {
+		vector<ResultRow> currentRows;
+		string error;
+		if (!loadResultsCsv(exporter.filename(), currentRows, error)) {
+			cerr << "Error: --compare: " << error << endl;
+			return 1;
+		}
+		if (compareResults(baselineRows, currentRows, compareOptions) > 0) {
+			return REGRESSION_EXIT_CODE;
+		}
+	}
+
+	return 0;
+}
+
+// Run scaling mode: the benchmark once per (ingest scale, thread count)
+int runScaling(const vector<string>& imageDirs, const set<string>& filteredImageSets,
+	const map<string,BenchmarkRunner::DetectorFilter>& filteredDetectors, const BenchmarkRunner::Options& options,
+	const ScalingOptions& scaling) {
+	cout << "=================================================\n"
+		<< "CSS 587 LP-SIFT Scaling Benchmark\n"
+		<< "=================================================\n\n";
+
+	for (const string& imageDir : imageDirs) {
+		if (!fs::exists(imageDir) || !fs::is_directory(imageDir)) {
+			cerr << "Error: Image directory does not exist: " << imageDir << endl;
+			return 1;
+		}
+	}
+
+	const vector<unsigned> threads = scaling.threads.empty() ? defaultScalingThreads() : scaling.threads;
+	cout << "Thread counts:";
+	for (const unsigned t : threads) cout << " " << t;
+	cout << "\nIngest scales:";
+	for (const int r : scaling.reductions) cout << " 1/" << r;
+	cout << endl;
+	if (options.ingestReduction != 1) {
+		cout << "Note: --ingest-scale is replaced by the scaling sweep" << endl;
+	}
+
+	string outputDir = "benchmark_output";
+	fs::create_directories(outputDir);
+
+	if (!options.tracePath.empty() && trace::compiledIn()) {
+		trace::enable();
+		trace::setThreadName("main");
+	}
+
+	const vector<ScalingPoint> points = runScalingSweep(options, scaling, imageDirs, filteredImageSets,
+		filteredDetectors, outputDir);
+
+	if (trace::enabled()) {
+		if (trace::writeChromeTrace(options.tracePath)) {
+			cout << "Trace saved to: " << options.tracePath << endl;
+		} else {
+			cerr << "Error: Could not write trace to " << options.tracePath << endl;
+		}
+	}
+	if (points.empty()) {
+		cerr << "No successful stitches to report. Check if images exist in the image directories" << endl;
+		return 1;
+	}
+
+	printScalingReport(points, scaling);
+
+	string csvPath;
+	findAvailableFileName("scaling", ".csv", csvPath);
+	if (writeScalingCsv(csvPath, points)) {
+		cout << "\nScaling results saved to: " << csvPath << endl;
+	} else {
+		cerr << "Error: Could not open file " << csvPath << " for writing." << endl;
+	}
 	return 0;
 }
 
@@ -243,6 +476,12 @@ int main(int argc, char* argv[]) {
 
 	set<string> filteredImageIds;
 	map<string, BenchmarkRunner::DetectorFilter> filteredDetectors;
+	BenchmarkRunner::Options options;
+	vector<string> imageDirs;
+	bool scalingMode = false;
+	ScalingOptions scaling;
+	string comparePath;
+	CompareOptions compareOptions;
 
 	cout << "Arguments:\n";
 	for (int i = 1; i < argc; i++) {
@@ -254,6 +493,203 @@ int main(int argc, char* argv[]) {
 			printUsage(argv[0]);
 			return 0;
 		}
+		else if (arg == "--prune") {
+			options.pruneCandidates = true;
+		}
+		else if (arg == "--border-check") {
+			options.checkBorderPeaks = true;
+		}
+		else if (arg == "--dense") {
+			options.denseDetection = true;
+		}
+		else if (arg == "--stream") {
+			options.streamScales = true;
+		}
+		else if (arg == "--concurrent-stages") {
+			options.concurrentStages = true;
+		}
+		else if (arg == "--no-prefetch") {
+			options.prefetchImages = false;
+		}
+		else if (arg == "--throughput") {
+			options.throughputMode = true;
+		}
+		else if (arg == "--latency") {
+			options.throughputMode = false;
+		}
+		else if (arg == "--pin") {
+			options.pinThreads = true;
+		}
+		else if (arg == "--ingest-scale") {
+			const string value = i + 1 < argc ? argv[++i] : "";
+			if (value != "1" && value != "2" && value != "4" && value != "8") {
+				cout << endl;
+				cerr << "--ingest-scale expects 1, 2, 4 or 8" << endl;
+				printUsage(argv[0]);
+				return 1;
+			}
+			options.ingestReduction = stoi(value);
+		}
+		else if (arg == "--ingest") {
+			const string value = i + 1 < argc ? argv[++i] : "";
+			if (value != "jpeg" && value != "nv12") {
+				cout << endl;
+				cerr << "--ingest expects jpeg or nv12" << endl;
+				printUsage(argv[0]);
+				return 1;
+			}
+			options.cameraFrames = value == "nv12";
+		}
+		else if (arg == "--save-features") {
+			if (i + 1 >= argc) {
+				cout << endl;
+				cerr << "Missing file after --save-features" << endl;
+				printUsage(argv[0]);
+				return 1;
+			}
+			options.featureStorePath = argv[++i];
+		}
+		else if (arg == "--refresh-baseline") {
+			options.refreshBaseline = true;
+		}
+		else if (arg == "--no-baseline-cache") {
+			options.baselineCacheDir.clear();
+		}
+		else if (arg == "--mat-pool") {
+			options.poolMats = true;
+		}
+		else if (arg == "--perf-counters") {
+			options.perfCounters = true;
+		}
+		else if (arg == "--mem-stats") {
+			options.memStats = true;
+		}
+		else if (arg == "--escalate") {
+			options.escalate = true;
+		}
+		else if (arg == "--budget") {
+			const string value = i + 1 < argc ? argv[++i] : "";
+			double budgetMs = -1.0;
+			try {
+				budgetMs = stod(value);
+			}
+			catch (const exception&) {
+			}
+			if (budgetMs <= 0.0) {
+				cout << endl;
+				cerr << "--budget expects a positive number of milliseconds" << endl;
+				printUsage(argv[0]);
+				return 1;
+			}
+			options.budgetMs = budgetMs;
+		}
+		else if (arg == "--trace") {
+			if (i + 1 >= argc) {
+				cout << endl;
+				cerr << "Missing file after --trace" << endl;
+				printUsage(argv[0]);
+				return 1;
+			}
+			options.tracePath = argv[++i];
+		}
+		else if (arg == "--warmup" || arg == "--repeat") {
+			const string value = i + 1 < argc ? argv[++i] : "";
+			int count = -1;
+			try {
+				count = stoi(value);
+			}
+			catch (const exception&) {
+			}
+			if (count < (arg == "--repeat" ? 1 : 0)) {
+				cout << endl;
+				cerr << arg << (arg == "--repeat" ? " expects a count of at least 1" : " expects a count of at least 0") << endl;
+				printUsage(argv[0]);
+				return 1;
+			}
+			if (arg == "--repeat") {
+				options.repetitions = count;
+			} else {
+				options.warmupRuns = count;
+			}
+		}
+		else if (arg == "--scaling") {
+			scalingMode = true;
+		}
+		else if (arg == "--scaling-threads" || arg == "--scaling-scales") {
+			const string value = i + 1 < argc ? argv[++i] : "";
+			vector<int> counts;
+			try {
+				for (const string& token : splitString(value, ',')) {
+					counts.push_back(stoi(token));
+				}
+			}
+			catch (const exception&) {
+				counts.clear();
+			}
+			const bool scales = arg == "--scaling-scales";
+			const bool valid = !counts.empty() && all_of(counts.begin(), counts.end(), [scales](int n) {
+				return scales ? (n == 1 || n == 2 || n == 4 || n == 8) : n >= 1;
+			});
+			if (!valid) {
+				cout << endl;
+				cerr << arg << (scales ? " expects a list of 1, 2, 4 or 8" : " expects a list of counts of at least 1") << endl;
+				printUsage(argv[0]);
+				return 1;
+			}
+			if (scales) {
+				scaling.reductions = counts;
+			} else {
+				scaling.threads.assign(counts.begin(), counts.end());
+				sort(scaling.threads.begin(), scaling.threads.end());
+			}
+			scalingMode = true;
+		}
+		else if (arg == "--compare") {
+			if (i + 1 >= argc) {
+				cout << endl;
+				cerr << "Missing file after --compare" << endl;
+				printUsage(argv[0]);
+				return 1;
+			}
+			comparePath = argv[++i];
+		}
+		else if (arg == "--threshold" || arg == "--accuracy-tolerance") {
+			const string value = i + 1 < argc ? argv[++i] : "";
+			const size_t equals = value.find('=');
+			const string stage = equals == string::npos ? "" : value.substr(0, equals);
+			double percent = -1.0;
+			try {
+				percent = stod(equals == string::npos ? value : value.substr(equals + 1));
+			}
+			catch (const exception&) {
+			}
+			const bool knownStage = stage.empty() || any_of(timedStages().begin(), timedStages().end(),
+				[&stage](const TimedStage& s) { return stage == s.key; });
+			if (percent < 0.0 || !knownStage || (!stage.empty() && arg != "--threshold")) {
+				cout << endl;
+				cerr << arg << " expects a percentage of at least 0"
+					<< (arg == "--threshold" ? ", optionally as <stage>=<pct> with a stage key such as matching" : "") << endl;
+				printUsage(argv[0]);
+				return 1;
+			}
+			if (arg == "--accuracy-tolerance") {
+				compareOptions.accuracyTolerance = percent / 100.0;
+			} else if (stage.empty()) {
+				compareOptions.threshold = percent / 100.0;
+			} else {
+				compareOptions.stageThresholds[stage] = percent / 100.0;
+			}
+		}
+		else if (arg == "--images") {
+			if (i + 1 >= argc) {
+				cout << endl;
+				cerr << "Missing directory after --images" << endl;
+				printUsage(argv[0]);
+				return 1;
+			}
+			imageDirs.push_back(argv[++i]);
+			cout << "  " << imageDirs.back() << endl;
+		}
 		else if (arg[0] != '-') {
 			// Assume it's an image set filter
 			try {
@@ -276,8 +712,18 @@ int main(int argc, char* argv[]) {
 
 	cout << endl;
 
+	if (imageDirs.empty()) {
+		imageDirs.push_back(IMAGE_DIR);
+	}
+
 	try {
-		return runBenchmark(filteredImageIds, filteredDetectors);
+		if (scalingMode) {
+			if (!comparePath.empty()) {
+				cout << "Note: --compare is ignored in scaling mode" << endl;
+			}
+			return runScaling(imageDirs, filteredImageIds, filteredDetectors, options, scaling);
+		}
+		return runBenchmark(imageDirs, filteredImageIds, filteredDetectors, options, comparePath, compareOptions);
 	}
 	catch (const exception& e) {
 		cerr << "Error: " << e.what() << endl;
@@ -0,0 +1,365 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * matpool.cpp
+ * Pooled cv::Mat allocator and per-stitch allocation scopes.
+ */
+
+#include "matpool.h"
+
+#include <algorithm>
+#include <iterator>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <cstdlib>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// Scope the calling thread's Mat allocations are routed to
+thread_local MatPoolScope* tlsScope = nullptr;
+
+// Arena-aligned memory, backed by transparent huge pages where available
+unsigned char* allocateAligned(const size_t bytes) {
+#ifdef _WIN32
+    void* ptr = _aligned_malloc(bytes, MAT_POOL_ARENA_BYTES);
+    if (!ptr) throw std::bad_alloc();
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, MAT_POOL_ARENA_BYTES, bytes) != 0) throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+    madvise(ptr, bytes, MADV_HUGEPAGE);
+#endif
+#endif
+    return static_cast<unsigned char*>(ptr);
+}
+
+void freeAligned(unsigned char* ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+size_t roundUp(const size_t n, const size_t multiple) {
+    return (n + multiple - 1) / multiple * multiple;
+}
+
+size_t sizeClassFor(const size_t bytes) {
+    size_t cls = MAT_POOL_MIN_BLOCK;
+    while (cls < bytes) cls <<= 1;
+    return cls;
+}
+
+void readPageFaults(const bool currentThread, long& minor, long& major) {
+#ifndef _WIN32
+    rusage usage{};
+#ifdef RUSAGE_THREAD
+    const int who = currentThread ? RUSAGE_THREAD : RUSAGE_SELF;
+#else
+    const int who = RUSAGE_SELF;
+    (void)currentThread;
+#endif
+    if (getrusage(who, &usage) == 0) {
+        minor = usage.ru_minflt;
+        major = usage.ru_majflt;
+        return;
+    }
+#else
+    (void)currentThread;
+#endif
+    minor = major = -1;
+}
+
+// Default allocator while scopes are in use: routes to the covering scope's pool, or to OpenCV's allocator
+class DispatchingMatAllocator final : public cv::MatAllocator {
+public:
+    explicit DispatchingMatAllocator(cv::MatAllocator* fallback) : fallback_(fallback) {}
+
+    cv::UMatData* allocate(const int dims, const int* sizes, const int type, void* data, size_t* step,
+                           const cv::AccessFlag flags, const cv::UMatUsageFlags usageFlags) const override {
+        MatPoolScope* scope = tlsScope;
+        if (!scope || data) {
+            return fallback_->allocate(dims, sizes, type, data, step, flags, usageFlags);
+        }
+
+        bool pooled = false, reused = false;
+        cv::UMatData* u = scope->pool()
+            ? scope->pool()->allocate(dims, sizes, type, nullptr, step, pooled, reused)
+            : fallback_->allocate(dims, sizes, type, nullptr, step, flags, usageFlags);
+        scope->countAllocation(u ? u->size : 0, pooled, reused);
+        return u;
+    }
+
+    bool allocate(cv::UMatData* data, const cv::AccessFlag accessFlags,
+                  const cv::UMatUsageFlags usageFlags) const override {
+        return fallback_->allocate(data, accessFlags, usageFlags);
+    }
+
+    // Buffers are released by the allocator recorded in their UMatData, so this only sees the fallback's
+    void deallocate(cv::UMatData* data) const override {
+        fallback_->deallocate(data);
+    }
+
+private:
+    cv::MatAllocator* fallback_;
+};
+
+void installDispatcher() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        // Never destroyed: Mats may be created during static destruction
+        static auto* dispatcher = new DispatchingMatAllocator(cv::Mat::getDefaultAllocator());
+        cv::Mat::setDefaultAllocator(dispatcher);
+    });
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// PooledMatAllocator Implementation
+// ============================================================================
+
+PooledMatAllocator::~PooledMatAllocator() {
+    // A Mat that outlived its pool would be left dangling: keep the memory rather than free it under it
+    if (!live_.empty()) return;
+
+    for (const Arena& arena : arenas_) {
+        if (arena.base) freeAligned(arena.base);
+    }
+    for (const auto& entry : freeLarge_) {
+        freeAligned(entry.second);
+    }
+}
+
+cv::UMatData* PooledMatAllocator::allocate(const int dims, const int* sizes, const int type, void* data,
+                                           size_t* step, const cv::AccessFlag flags,
+                                           const cv::UMatUsageFlags usageFlags) const {
+    CV_UNUSED(flags);
+    CV_UNUSED(usageFlags);
+    bool pooled = false, reused = false;
+    return allocate(dims, sizes, type, data, step, pooled, reused);
+}
+
+cv::UMatData* PooledMatAllocator::allocate(const int dims, const int* sizes, const int type, void* data,
+                                           size_t* step, bool& pooled, bool& reused) const {
+    // Same layout rules as OpenCV's standard allocator
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; i--) {
+        if (step) {
+            if (data && step[i] != CV_AUTOSTEP) {
+                CV_Assert(total <= step[i]);
+                total = step[i];
+            } else {
+                step[i] = total;
+            }
+        }
+        total *= sizes[i];
+    }
+
+    pooled = !data && PooledMatAllocator::pooled(total);
+    reused = false;
+    if (!data && !pooled) {
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, nullptr, step,
+                                                    cv::ACCESS_RW, cv::USAGE_DEFAULT);
+    }
+
+    auto* u = new cv::UMatData(this);
+    u->data = u->origdata = data ? static_cast<uchar*>(data) : acquire(total, reused);
+    u->size = total;
+    if (data) u->flags |= cv::UMatData::USER_ALLOCATED;
+    return u;
+}
+
+bool PooledMatAllocator::allocate(cv::UMatData* data, const cv::AccessFlag accessFlags,
+                                  const cv::UMatUsageFlags usageFlags) const {
+    CV_UNUSED(accessFlags);
+    CV_UNUSED(usageFlags);
+    return data != nullptr; // host memory only, nothing to map
+}
+
+void PooledMatAllocator::deallocate(cv::UMatData* u) const {
+    if (!u) return;
+
+    CV_Assert(u->urefcount == 0);
+    CV_Assert(u->refcount == 0);
+    if (!(u->flags & cv::UMatData::USER_ALLOCATED)) {
+        release(u->origdata);
+        u->origdata = nullptr;
+    }
+    delete u;
+}
+
+unsigned char* PooledMatAllocator::acquire(const size_t bytes, bool& reused) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (bytes > MAT_POOL_ARENA_BYTES / 2) {
+        // Large block: best fit among free ones, as long as it wastes at most half
+        const size_t rounded = roundUp(bytes, MAT_POOL_ARENA_BYTES);
+        auto it = freeLarge_.lower_bound(rounded);
+        if (it != freeLarge_.end() && it->first <= 2 * rounded) {
+            unsigned char* ptr = it->second;
+            live_[ptr] = {it->first, LARGE_BLOCK};
+            freeLarge_.erase(it);
+            reused = true;
+            return ptr;
+        }
+
+        unsigned char* ptr = allocateAligned(rounded);
+        largeBytes_ += rounded;
+        live_[ptr] = {rounded, LARGE_BLOCK};
+        return ptr;
+    }
+
+    const size_t cls = sizeClassFor(bytes);
+    auto& freeList = freeLists_[cls];
+    if (!freeList.empty()) {
+        const FreeBlock block = freeList.back();
+        freeList.pop_back();
+        ++arenas_[block.arena].live;
+        live_[block.ptr] = {cls, block.arena};
+        reused = true;
+        return block.ptr;
+    }
+
+    // Bump-allocate from the newest arena with room, or start a new one (reusing a released slot)
+    size_t index = arenas_.size();
+    for (size_t i = arenas_.size(); i-- > 0;) {
+        if (arenas_[i].base && arenas_[i].used + cls <= arenas_[i].size) {
+            index = i;
+            break;
+        }
+    }
+    if (index == arenas_.size()) {
+        const auto slot = std::find_if(arenas_.begin(), arenas_.end(), [](const Arena& a) { return !a.base; });
+        index = static_cast<size_t>(slot - arenas_.begin());
+        if (slot == arenas_.end()) arenas_.emplace_back();
+        arenas_[index] = {allocateAligned(MAT_POOL_ARENA_BYTES), MAT_POOL_ARENA_BYTES, 0, 0};
+    }
+
+    Arena& arena = arenas_[index];
+    unsigned char* ptr = arena.base + arena.used;
+    arena.used += cls;
+    ++arena.live;
+    live_[ptr] = {cls, index};
+    return ptr;
+}
+
+void PooledMatAllocator::release(unsigned char* ptr) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const auto it = live_.find(ptr);
+    CV_Assert(it != live_.end());
+    const Block block = it->second;
+    live_.erase(it);
+
+    if (block.arena == LARGE_BLOCK) {
+        freeLarge_.emplace(block.sizeClass, ptr);
+    } else {
+        --arenas_[block.arena].live;
+        freeLists_[block.sizeClass].push_back({ptr, block.arena});
+    }
+}
+
+void PooledMatAllocator::recycle() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Idle arenas start over from their base; their buffers leave the free lists
+    for (Arena& arena : arenas_) {
+        if (arena.base && arena.live == 0) arena.used = 0;
+    }
+    for (auto& entry : freeLists_) {
+        auto& list = entry.second;
+        list.erase(std::remove_if(list.begin(), list.end(),
+                                  [this](const FreeBlock& b) { return arenas_[b.arena].live == 0; }),
+                   list.end());
+    }
+
+    // Trim to the retain limit: largest free blocks first, then idle arenas
+    size_t reserved = largeBytes_;
+    for (const Arena& arena : arenas_) reserved += arena.size;
+
+    while (reserved > MAT_POOL_RETAIN_BYTES && !freeLarge_.empty()) {
+        const auto largest = std::prev(freeLarge_.end());
+        freeAligned(largest->second);
+        reserved -= largest->first;
+        largeBytes_ -= largest->first;
+        freeLarge_.erase(largest);
+    }
+    for (Arena& arena : arenas_) {
+        if (reserved <= MAT_POOL_RETAIN_BYTES) break;
+        if (arena.base && arena.live == 0) {
+            freeAligned(arena.base);
+            reserved -= arena.size;
+            arena = Arena{};
+        }
+    }
+}
+
+size_t PooledMatAllocator::reservedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t reserved = largeBytes_;
+    for (const Arena& arena : arenas_) reserved += arena.size;
+    return reserved;
+}
+
+// ============================================================================
+// MatPoolScope Implementation
+// ============================================================================
+
+MatPoolScope::MatPoolScope(PooledMatAllocator* pool, const FaultScope faults)
+    : pool_(pool),
+      faults_(faults) {
+    installDispatcher();
+    readPageFaults(faults_ == FaultScope::Thread, startMinorFaults_, startMajorFaults_);
+
+    previous_ = tlsScope;
+    tlsScope = this;
+}
+
+MatPoolScope::~MatPoolScope() {
+    tlsScope = previous_;
+    if (pool_) pool_->recycle();
+}
+
+MatPoolScope* MatPoolScope::current() {
+    return tlsScope;
+}
+
+MatPoolScope::Attach::Attach(MatPoolScope* scope) : previous_(tlsScope) {
+    tlsScope = scope;
+}
+
+MatPoolScope::Attach::~Attach() {
+    tlsScope = previous_;
+}
+
+void MatPoolScope::countAllocation(const size_t bytes, const bool pooled, const bool reused) {
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes_.fetch_add(bytes, std::memory_order_relaxed);
+    if (pooled) pooledAllocations_.fetch_add(1, std::memory_order_relaxed);
+    if (reused) reusedAllocations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+MatPoolStats MatPoolScope::stats() const {
+    MatPoolStats stats;
+    stats.allocations = allocations_.load(std::memory_order_relaxed);
+    stats.allocatedBytes = allocatedBytes_.load(std::memory_order_relaxed);
+    stats.pooledAllocations = pooledAllocations_.load(std::memory_order_relaxed);
+    stats.reusedAllocations = reusedAllocations_.load(std::memory_order_relaxed);
+    stats.reservedBytes = pool_ ? pool_->reservedBytes() : 0;
+
+    long minor = -1, major = -1;
+    readPageFaults(faults_ == FaultScope::Thread, minor, major);
+    const bool available = minor >= 0 && startMinorFaults_ >= 0;
+    stats.minorPageFaults = available ? minor - startMinorFaults_ : -1;
+    stats.majorPageFaults = available ? major - startMajorFaults_ : -1;
+    return stats;
+}
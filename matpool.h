@@ -0,0 +1,172 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * matpool.h
+ * Pooled cv::Mat buffers for per-stitch temporaries:
+ *  - PooledMatAllocator: size-class free lists carved from 2 MiB (huge-page aligned) arenas
+ *  - MatPoolScope: routes the Mat allocations of one stitch to a pool, recycles it in bulk at the end,
+ *    and counts allocations and page faults
+ */
+
+#ifndef MATPOOL_H
+#define MATPOOL_H
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Mat buffers below this size go to OpenCV's standard allocator (not worth pooling)
+constexpr size_t MAT_POOL_MIN_BLOCK = size_t(4) << 10;      // 4 KiB
+// Arena size and alignment: one transparent huge page on x86-64 Linux
+constexpr size_t MAT_POOL_ARENA_BYTES = size_t(2) << 20;    // 2 MiB
+// Memory kept between stitches; the rest is returned to the system when a stitch ends
+constexpr size_t MAT_POOL_RETAIN_BYTES = size_t(512) << 20; // 512 MiB
+
+/*
+ * PooledMatAllocator - cv::MatAllocator backed by a buffer pool.
+ * Buffers up to half an arena are rounded up to a power-of-two size class and carved from shared arenas;
+ * larger ones get their own huge-page aligned block. Freed buffers go to free lists, not back to the
+ * system, so the next stitch reuses memory that is already mapped (no page faults, no heap fragmentation).
+ * recycle() resets every arena with no live buffer in one step and trims the pool to the retain limit.
+ * Thread-safe: Mats may be released on any thread. The pool must outlive every Mat allocated from it.
+ */
+class PooledMatAllocator : public cv::MatAllocator {
+public:
+    PooledMatAllocator() = default;
+    ~PooledMatAllocator() override;
+
+    PooledMatAllocator(const PooledMatAllocator&) = delete;
+    PooledMatAllocator& operator=(const PooledMatAllocator&) = delete;
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override;
+    bool allocate(cv::UMatData* data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override;
+    void deallocate(cv::UMatData* data) const override;
+
+    /** @brief Bulk release at the end of a stitch: reset idle arenas and trim to MAT_POOL_RETAIN_BYTES. */
+    void recycle();
+
+    /** @brief Bytes of arenas and large blocks currently reserved from the system. */
+    size_t reservedBytes() const;
+
+    /** @brief True if a buffer request of this size is served from the pool (otherwise: standard allocator). */
+    static bool pooled(size_t bytes) { return bytes >= MAT_POOL_MIN_BLOCK; }
+
+    /** @brief allocate() that also reports how the buffer was served (for MatPoolScope statistics).
+     *  @param pooled Set if the buffer came from the pool rather than the standard allocator.
+     *  @param reused Set if it came from a free list, i.e. no fresh memory was touched.
+     */
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           bool& pooled, bool& reused) const;
+
+private:
+    struct Arena {
+        unsigned char* base = nullptr;
+        size_t size = 0;
+        size_t used = 0;  // bump offset
+        size_t live = 0;  // buffers handed out and not yet freed
+    };
+
+    struct Block {
+        size_t sizeClass; // power-of-two size, or the rounded size of a large block
+        size_t arena;     // arena index; LARGE_BLOCK for large blocks
+    };
+
+    static constexpr size_t LARGE_BLOCK = SIZE_MAX;
+
+    mutable std::mutex mutex_;
+    mutable std::vector<Arena> arenas_;
+    struct FreeBlock {
+        unsigned char* ptr;
+        size_t arena;
+    };
+
+    mutable std::map<size_t, std::vector<FreeBlock>> freeLists_;      // size class -> free buffers
+    mutable std::multimap<size_t, unsigned char*> freeLarge_;           // rounded size -> free large blocks
+    mutable std::unordered_map<const void*, Block> live_;               // handed-out buffers
+    mutable size_t largeBytes_ = 0;                                     // all large blocks, live or free
+
+    unsigned char* acquire(size_t bytes, bool& reused) const;
+    void release(unsigned char* ptr) const;
+};
+
+// Mat allocations and page faults during one MatPoolScope
+struct MatPoolStats {
+    size_t allocations = 0;       // Mat buffers allocated (pooled or not)
+    size_t allocatedBytes = 0;    // their sizes
+    size_t pooledAllocations = 0; // served by the pool
+    size_t reusedAllocations = 0; // pooled and served from a free list (memory already faulted in)
+    long minorPageFaults = 0;
+    long majorPageFaults = 0;     // -1 where page-fault counters are unavailable
+    size_t reservedBytes = 0;     // pool size at the end of the scope
+};
+
+/*
+ * MatPoolScope - Opt-in for one stitch.
+ * While alive, every cv::Mat allocated on the creating thread is counted and, with a pool, served by it
+ * (the first scope installs a dispatching default allocator; outside scopes it forwards to OpenCV's own).
+ * Helper threads working on the same stitch join it with an Attach guard. Threads not attached, such as
+ * OpenCV's internal parallel_for_ workers, keep using the standard allocator.
+ * On destruction the pool is recycled in bulk.
+ */
+class MatPoolScope {
+public:
+    // Page faults counted: the creating thread only (Linux), or the whole process
+    enum class FaultScope { Thread, Process };
+
+    /** @param pool Pool to allocate from; null only counts allocations.
+     *  @param faults Use Thread when other stitches run concurrently, Process to include helper threads.
+     */
+    MatPoolScope(PooledMatAllocator* pool, FaultScope faults);
+    ~MatPoolScope();
+
+    /** @brief Scope of the calling thread, or null. */
+    static MatPoolScope* current();
+
+    // Routes the calling thread's Mat allocations to a scope for the guard's lifetime (null: no scope)
+    class Attach {
+    public:
+        explicit Attach(MatPoolScope* scope);
+        ~Attach();
+
+        Attach(const Attach&) = delete;
+        Attach& operator=(const Attach&) = delete;
+
+    private:
+        MatPoolScope* previous_;
+    };
+
+    MatPoolScope(const MatPoolScope&) = delete;
+    MatPoolScope& operator=(const MatPoolScope&) = delete;
+
+    /** @brief Counters since the scope was opened (page faults up to this call). */
+    MatPoolStats stats() const;
+
+    /** @brief Mat buffers allocated so far and their bytes (cheap, for per-stage deltas). */
+    size_t allocations() const { return allocations_.load(std::memory_order_relaxed); }
+    size_t allocatedBytes() const { return allocatedBytes_.load(std::memory_order_relaxed); }
+
+    // Used by the dispatching default allocator
+    PooledMatAllocator* pool() const { return pool_; }
+    void countAllocation(size_t bytes, bool pooled, bool reused);
+
+private:
+    PooledMatAllocator* pool_;
+    FaultScope faults_;
+    MatPoolScope* previous_ = nullptr;
+    std::atomic<size_t> allocations_{0};
+    std::atomic<size_t> allocatedBytes_{0};
+    std::atomic<size_t> pooledAllocations_{0};
+    std::atomic<size_t> reusedAllocations_{0};
+    long startMinorFaults_ = 0;
+    long startMajorFaults_ = 0;
+};
+
+#endif //MATPOOL_H
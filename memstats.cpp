@@ -0,0 +1,157 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * memstats.cpp
+ * Counting global operator new and resident set size readers.
+ */
+
+#include "memstats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <string>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// Constant or trivially initialized, so operator new may use them on any thread at any time
+std::atomic<bool> heapCountingEnabled{false};
+thread_local uint64_t tlsHeapAllocations = 0;
+thread_local uint64_t tlsHeapBytes = 0;
+
+#ifdef LP_HEAP_COUNTERS
+void* countedAlloc(std::size_t size) {
+    if (heapCountingEnabled.load(std::memory_order_relaxed)) {
+        ++tlsHeapAllocations;
+        tlsHeapBytes += size;
+    }
+    if (size == 0) size = 1;
+
+    for (;;) {
+        if (void* p = std::malloc(size)) return p;
+        const std::new_handler handler = std::get_new_handler();
+        if (!handler) return nullptr;
+        handler();
+    }
+}
+#endif // LP_HEAP_COUNTERS
+
+// Value in KiB of a "Name:   1234 kB" line of /proc/self/status, or -1
+int64_t readStatusKiB(const char* name) {
+    std::ifstream status("/proc/self/status");
+    const size_t length = std::strlen(name);
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, length, name) == 0 && line.size() > length && line[length] == ':') {
+            return std::strtoll(line.c_str() + length + 1, nullptr, 10);
+        }
+    }
+    return -1;
+}
+
+} // anonymous namespace
+
+#ifdef LP_HEAP_COUNTERS
+
+// ============================================================================
+// Global operator new / delete
+// ============================================================================
+
+void* operator new(std::size_t size) {
+    if (void* p = countedAlloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    if (void* p = countedAlloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+
+#endif // LP_HEAP_COUNTERS
+
+// ============================================================================
+// Memory accounting Implementation
+// ============================================================================
+
+void setHeapCounting(const bool enabled) {
+#ifdef LP_HEAP_COUNTERS
+    heapCountingEnabled.store(enabled, std::memory_order_relaxed);
+#else
+    (void)enabled;
+#endif
+}
+
+bool heapCounting() {
+    return heapCountingEnabled.load(std::memory_order_relaxed);
+}
+
+HeapCounters threadHeapCounters() {
+    HeapCounters counters;
+    counters.allocations = tlsHeapAllocations;
+    counters.bytes = tlsHeapBytes;
+    return counters;
+}
+
+int64_t readRssKiB() {
+    return readStatusKiB("VmRSS");
+}
+
+int64_t readPeakRssKiB() {
+    const int64_t hwm = readStatusKiB("VmHWM");
+    if (hwm >= 0) return hwm;
+
+#ifndef _WIN32
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+        return usage.ru_maxrss;        // KiB
+#endif
+    }
+#endif
+    return -1;
+}
+
+bool resetPeakRss() {
+#ifdef __linux__
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+    clearRefs.flush();
+    return clearRefs.good();
+#else
+    return false;
+#endif
+}
+
+StageMemory& StageMemory::operator+=(const StageMemory& other) {
+    peakRssKiB = std::max(peakRssKiB, other.peakRssKiB);
+    heapAllocations += other.heapAllocations;
+    heapBytes += other.heapBytes;
+    matAllocations += other.matAllocations;
+    matBytes += other.matBytes;
+    return *this;
+}
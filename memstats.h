@@ -0,0 +1,58 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * memstats.h
+ * Memory accounting for the benchmark:
+ *  - per-thread counts of operator new calls and bytes (this module replaces the global operator new when built
+ *    with LP_HEAP_COUNTERS, and counts only after setHeapCounting(true), i.e. with --mem-stats)
+ *  - resident set size and its high-water mark from /proc/self/status, with getrusage as fallback
+ */
+
+#ifndef MEMSTATS_H
+#define MEMSTATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// operator new calls and bytes requested by one thread since it started
+struct HeapCounters {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+/** @brief Start or stop counting operator new on every thread (off by default).
+ *  No effect in builds without LP_HEAP_COUNTERS (CMake option), where operator new is not replaced.
+ */
+void setHeapCounting(bool enabled);
+
+/** @brief True while operator new is counted. */
+bool heapCounting();
+
+/** @brief Counters of the calling thread (over-aligned new is not counted; zero while counting is off). */
+HeapCounters threadHeapCounters();
+
+/** @brief Current resident set size (VmRSS) in KiB, or -1. */
+int64_t readRssKiB();
+
+/** @brief Resident set high-water mark in KiB: VmHWM, else getrusage's ru_maxrss, or -1.
+ *  Process-wide; since process start or the last successful resetPeakRss().
+ */
+int64_t readPeakRssKiB();
+
+/** @brief Reset VmHWM to the current RSS (Linux /proc/self/clear_refs); false where unsupported. */
+bool resetPeakRss();
+
+// Memory used by one pipeline stage of a stitch
+struct StageMemory {
+    int64_t peakRssKiB = -1;     // --mem-stats: process RSS high-water mark during the stage, -1 if not sampled
+    uint64_t heapAllocations = 0; // operator new on the stitching thread
+    uint64_t heapBytes = 0;
+    uint64_t matAllocations = 0;  // cv::Mat buffers (MatAllocator hook, see MatPoolScope)
+    uint64_t matBytes = 0;
+
+    // Accumulate another stage: counts add up, the high-water mark is the larger one
+    StageMemory& operator+=(const StageMemory& other);
+};
+
+#endif //MEMSTATS_H
@@ -0,0 +1,540 @@
+/*
+ * David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * microbench.cpp
+ * Per-kernel micro-benchmarks (css587microbench target).
+ * Each case times one pipeline kernel in isolation, on the same code paths the benchmark uses,
+ * so a regression in the end-to-end numbers can be attributed to a single stage:
+ *  - lp_scan/grid, lp_scan/dense   LP window extrema per window size
+ *  - linear_ramp                   LP preprocessing ramp
+ *  - sift_compute, orb_compute     LP-SIFT / LP-ORB descriptors on LP keypoints
+ *  - flann_kdtree_match, flann_lsh_match, bf_match
+ *  - find_homography               RANSAC on synthetic correspondences with outliers
+ *  - warp_and_blend                composite of the stitched pair
+ * Cases are parameterized by resolution and keypoint count. Inputs are the first image set found in the
+ * image directory, resized to each resolution, or a synthetic textured pair if there is none.
+ *
+ * Usage:
+ *   ./css587microbench [--filter <substring>] [--resolutions 640x480,1920x1080] [--keypoints 1000,10000]
+ *                      [--samples N] [--min-time <seconds>] [--images <dir>] [--csv <file>] [--list]
+ */
+
+#include "benchmark.h"
+#include "benchstats.h"
+#include "knnmatches.h"
+#include "lporb.h"
+#include "lppeaks.h"
+#include "lpsift.h"
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int DEFAULT_SAMPLES = 10;
+constexpr double DEFAULT_MIN_TIME = 0.5;     // seconds of measured iterations per case
+constexpr int64_t MAX_ITERATIONS = 1 << 20;  // per sample, for kernels far below the timer resolution
+constexpr double OUTLIER_FRACTION = 0.3;     // find_homography: share of random correspondences
+constexpr double INLIER_NOISE_PX = 1.0;      // find_homography: inlier jitter
+
+const std::vector<cv::Size> DEFAULT_RESOLUTIONS = {{640, 480}, {1920, 1080}, {4096, 3072}};
+const std::vector<int> DEFAULT_KEYPOINTS = {1000, 10000, 50000};
+
+// Homography of the synthetic pair: slight rotation, scale and perspective
+cv::Mat syntheticHomography(const cv::Size& size) {
+    const double angle = 3.0 * CV_PI / 180.0;
+    return (cv::Mat_<double>(3, 3) <<
+        0.98 * std::cos(angle), -0.98 * std::sin(angle), 0.08 * size.width,
+        0.98 * std::sin(angle), 0.98 * std::cos(angle), 0.03 * size.height,
+        1e-6, 2e-6, 1.0);
+}
+
+std::string sizeLabel(const cv::Size& size) {
+    return std::to_string(size.width) + "x" + std::to_string(size.height);
+}
+
+// Strongest n keypoints (all of them if there are fewer)
+std::vector<cv::KeyPoint> strongest(std::vector<cv::KeyPoint> keypoints, const size_t n) {
+    if (keypoints.size() > n) {
+        std::nth_element(keypoints.begin(), keypoints.begin() + static_cast<long>(n), keypoints.end(),
+                         [](const cv::KeyPoint& a, const cv::KeyPoint& b) { return a.response > b.response; });
+        keypoints.resize(n);
+    }
+    return keypoints;
+}
+
+/*
+ * Fixtures - Inputs shared between cases, created on first use so filtered-out cases cost nothing.
+ */
+class Fixtures {
+public:
+    explicit Fixtures(const std::string& imageDir) {
+        // First image set (sorted by name) with both images
+        std::vector<std::string> sets;
+        if (fs::is_directory(imageDir)) {
+            for (const auto& entry : fs::directory_iterator(imageDir)) {
+                if (entry.is_directory()) sets.push_back(entry.path().string());
+            }
+        }
+        std::sort(sets.begin(), sets.end());
+        for (const auto& set : sets) {
+            sourceReference_ = cv::imread(set + "/reference.jpg", cv::IMREAD_COLOR);
+            sourceRegistered_ = cv::imread(set + "/registered.jpg", cv::IMREAD_COLOR);
+            if (!sourceReference_.empty() && !sourceRegistered_.empty()) {
+                source_ = fs::path(set).filename().string();
+                break;
+            }
+        }
+    }
+
+    // Where the inputs come from, for the report header
+    std::string source() const { return source_.empty() ? "synthetic texture" : "image set '" + source_ + "'"; }
+
+    const cv::Mat& color(const cv::Size& size, const bool registered) {
+        auto& cached = colors_[key(size, registered)];
+        if (!cached.empty()) return cached;
+
+        if (!source_.empty()) {
+            cv::resize(registered ? sourceRegistered_ : sourceReference_, cached, size, 0, 0, cv::INTER_AREA);
+        } else if (!registered) {
+            // Band-limited noise: texture at every scale the LP windows look at
+            cv::Mat noise(size, CV_8UC3);
+            cv::randu(noise, cv::Scalar::all(0), cv::Scalar::all(255));
+            cv::GaussianBlur(noise, cached, cv::Size(0, 0), 2.0);
+        } else {
+            cv::warpPerspective(color(size, false), cached, syntheticHomography(size).inv(), size);
+        }
+        return cached;
+    }
+
+    const cv::Mat& gray(const cv::Size& size, const bool registered) {
+        auto& cached = grays_[key(size, registered)];
+        if (cached.empty()) cv::cvtColor(color(size, registered), cached, cv::COLOR_BGR2GRAY);
+        return cached;
+    }
+
+    // CV_32F image the LP window scan runs on (conversion plus ramp, as the detectors preprocess)
+    const cv::Mat& preprocessed(const cv::Size& size) {
+        auto& cached = preprocessed_[key(size, false)];
+        if (cached.empty()) {
+            gray(size, false).convertTo(cached, CV_32F);
+            lp::addLinearRamp(cached, LPSIFT::DEFAULT_LINEAR_NOISE_ALPHA);
+        }
+        return cached;
+    }
+
+    // LP keypoints of the default window sizes
+    const std::vector<cv::KeyPoint>& lpKeypoints(const bool orb, const cv::Size& size, const bool registered) {
+        auto& cached = (orb ? orbKeypoints_ : siftKeypoints_)[key(size, registered)];
+        if (cached.empty()) {
+            LPDetectionStats stats;
+            if (orb) {
+                lporb_->detectWithStats(gray(size, registered), cached, stats);
+            } else {
+                lpsift_->detectWithStats(gray(size, registered), cached, stats);
+            }
+        }
+        return cached;
+    }
+
+    // Descriptors of the strongest n LP keypoints
+    const cv::Mat& descriptors(const bool orb, const cv::Size& size, const bool registered, const size_t n) {
+        auto& cached = descriptors_[key(size, registered) + (orb ? "/orb/" : "/sift/") + std::to_string(n)];
+        if (cached.empty()) {
+            std::vector<cv::KeyPoint> keypoints = strongest(lpKeypoints(orb, size, registered), n);
+            if (!keypoints.empty()) {
+                describer(orb)->compute(gray(size, registered), keypoints, cached);
+            }
+        }
+        return cached;
+    }
+
+    // LP-ORB or LP-SIFT, as used by the benchmark for description
+    cv::Ptr<cv::Feature2D> describer(const bool orb) const {
+        return orb ? cv::Ptr<cv::Feature2D>(lporb_) : cv::Ptr<cv::Feature2D>(lpsift_);
+    }
+
+private:
+    std::string source_;
+    cv::Mat sourceReference_, sourceRegistered_;
+    cv::Ptr<LPSIFT> lpsift_ = LPSIFT::create();
+    cv::Ptr<LPORB> lporb_ = LPORB::create();
+
+    std::map<std::string, cv::Mat> colors_, grays_, preprocessed_, descriptors_;
+    std::map<std::string, std::vector<cv::KeyPoint>> siftKeypoints_, orbKeypoints_;
+
+    static std::string key(const cv::Size& size, const bool registered) {
+        return sizeLabel(size) + (registered ? "/registered" : "/reference");
+    }
+};
+
+// One parameterized case: prepare() runs untimed, sets the items one iteration processes and returns the kernel
+struct MicroCase {
+    std::string name;
+    std::string unit; // what the items are: "px", "kp" or "matches"
+    std::function<std::function<void()>(double& items)> prepare;
+};
+
+struct MicroResult {
+    std::string name;
+    std::string unit;
+    double items = 0.0;
+    int64_t iterations = 0; // per sample
+    TimingStats stats;      // per iteration
+};
+
+std::vector<MicroCase> makeCases(Fixtures& fixtures,
+                                 const std::vector<cv::Size>& resolutions,
+                                 const std::vector<int>& keypointCounts) {
+    std::vector<MicroCase> cases;
+    const cv::Size largest = *std::max_element(resolutions.begin(), resolutions.end(),
+        [](const cv::Size& a, const cv::Size& b) { return a.area() < b.area(); });
+
+    for (const cv::Size& size : resolutions) {
+        const std::string res = sizeLabel(size);
+
+        for (const int L : LPSIFT::DEFAULT_WINDOW_SIZES) {
+            cases.push_back({"lp_scan/grid/L=" + std::to_string(L) + "/" + res, "px", [&fixtures, size, L](double& items) {
+                const cv::Mat& image = fixtures.preprocessed(size);
+                items = static_cast<double>(image.total());
+                auto peaks = std::make_shared<std::vector<LPWindowPeak>>();
+                return std::function<void()>([&image, peaks, L] { lp::gridWindowExtrema(image, L, *peaks); });
+            }});
+            cases.push_back({"lp_scan/dense/L=" + std::to_string(L) + "/" + res, "px", [&fixtures, size, L](double& items) {
+                const cv::Mat& image = fixtures.preprocessed(size);
+                items = static_cast<double>(image.total());
+                const int stride = lp::denseStride(LPDenseParams{}, L);
+                auto peaks = std::make_shared<std::vector<LPWindowPeak>>();
+                return std::function<void()>([&image, peaks, L, stride] {
+                    lp::slidingWindowExtrema(image, L, stride, *peaks);
+                });
+            }});
+        }
+
+        cases.push_back({"linear_ramp/" + res, "px", [&fixtures, size](double& items) {
+            auto image = std::make_shared<cv::Mat>();
+            fixtures.gray(size, false).convertTo(*image, CV_32F);
+            items = static_cast<double>(image->total());
+            // Adding the ramp again only shifts values by alpha per pixel; the work is identical
+            return std::function<void()>([image] { lp::addLinearRamp(*image, LPSIFT::DEFAULT_LINEAR_NOISE_ALPHA); });
+        }});
+
+        for (const int n : keypointCounts) {
+            for (const bool orb : {false, true}) {
+                const std::string name = std::string(orb ? "orb_compute/" : "sift_compute/") + res +
+                                         "/kp=" + std::to_string(n);
+                cases.push_back({name, "kp", [&fixtures, size, n, orb](double& items) {
+                    auto keypoints = std::make_shared<std::vector<cv::KeyPoint>>(
+                        strongest(fixtures.lpKeypoints(orb, size, false), static_cast<size_t>(n)));
+                    const cv::Mat& image = fixtures.gray(size, false);
+                    const cv::Ptr<cv::Feature2D> detector = fixtures.describer(orb);
+                    auto descriptors = std::make_shared<cv::Mat>();
+
+                    // ORB drops keypoints near the border on the first call; later calls see a stable set
+                    if (!keypoints->empty()) detector->compute(image, *keypoints, *descriptors);
+                    items = static_cast<double>(keypoints->size());
+                    return std::function<void()>([detector, &image, keypoints, descriptors] {
+                        detector->compute(image, *keypoints, *descriptors);
+                    });
+                }});
+            }
+        }
+
+        cases.push_back({"warp_and_blend/" + res, "px", [&fixtures, size](double& items) {
+            const cv::Mat& reference = fixtures.color(size, false);
+            const cv::Mat& registered = fixtures.color(size, true);
+            items = static_cast<double>(registered.total());
+            const cv::Mat H = syntheticHomography(size);
+            auto stitched = std::make_shared<cv::Mat>();
+            return std::function<void()>([&reference, &registered, H, stitched] {
+                *stitched = BenchmarkRunner::warpAndBlend(registered, reference, H);
+            });
+        }});
+    }
+
+    // Matching: descriptors of the largest resolution, which has the most LP keypoints
+    for (const int n : keypointCounts) {
+        const std::string kp = "/kp=" + std::to_string(n);
+        const struct {
+            const char* name;
+            bool orb;
+            cv::NormTypes norm;
+            MatcherType matcher;
+        } matchCases[] = {
+            {"flann_kdtree_match", false, cv::NORM_L2, MatcherType::FLANN},
+            {"flann_lsh_match", true, cv::NORM_HAMMING, MatcherType::FLANN},
+            {"bf_match/sift", false, cv::NORM_L2, MatcherType::BRUTE_FORCE},
+            {"bf_match/orb", true, cv::NORM_HAMMING, MatcherType::BRUTE_FORCE},
+        };
+
+        for (const auto& m : matchCases) {
+            if (m.matcher == MatcherType::BRUTE_FORCE && n > MAX_KEYPOINTS_BF) continue; // BFMatcher limit
+            const bool orb = m.orb;
+            BenchmarkRunner::DetectorConfig config;
+            config.name = orb ? "LP-ORB" : "LP-SIFT";
+            config.matcherNorm = m.norm;
+            config.matcherType = m.matcher;
+
+            cases.push_back({std::string(m.name) + kp, "kp", [&fixtures, largest, n, orb, config](double& items) {
+                const cv::Mat& query = fixtures.descriptors(orb, largest, false, static_cast<size_t>(n));
+                const cv::Mat& train = fixtures.descriptors(orb, largest, true, static_cast<size_t>(n));
+                items = static_cast<double>(query.rows);
+                auto matches = std::make_shared<KnnMatches>();
+                return std::function<void()>([config, &query, &train, matches] {
+                    BenchmarkRunner::matchDescriptors(config, query, train, *matches);
+                });
+            }});
+        }
+
+        // RANSAC on n correspondences of a known homography, OUTLIER_FRACTION of them random
+        cases.push_back({"find_homography/matches=" + std::to_string(n), "matches", [largest, n](double& items) {
+            cv::RNG rng(RNG_SEED);
+            const cv::Mat H = syntheticHomography(largest);
+            auto pts1 = std::make_shared<std::vector<cv::Point2f>>();
+            auto pts2 = std::make_shared<std::vector<cv::Point2f>>();
+            std::vector<cv::Point2f> projected;
+            for (int i = 0; i < n; ++i) {
+                pts2->emplace_back(rng.uniform(0.f, static_cast<float>(largest.width)),
+                                   rng.uniform(0.f, static_cast<float>(largest.height)));
+            }
+            cv::perspectiveTransform(*pts2, projected, H);
+            for (auto& p : projected) {
+                if (rng.uniform(0.0, 1.0) < OUTLIER_FRACTION) {
+                    p = cv::Point2f(rng.uniform(0.f, static_cast<float>(largest.width)),
+                                    rng.uniform(0.f, static_cast<float>(largest.height)));
+                } else {
+                    p += cv::Point2f(static_cast<float>(rng.gaussian(INLIER_NOISE_PX)),
+                                     static_cast<float>(rng.gaussian(INLIER_NOISE_PX)));
+                }
+            }
+            *pts1 = projected;
+            items = n;
+            auto mask = std::make_shared<std::vector<uchar>>();
+            return std::function<void()>([pts1, pts2, mask] {
+                cv::setRNGSeed(RNG_SEED);
+                cv::findHomography(*pts2, *pts1, cv::RANSAC, RANSAC_THRESHOLD, *mask);
+            });
+        }});
+    }
+
+    return cases;
+}
+
+// Times the kernel: one warm-up call, then `samples` samples of enough iterations to fill minTime overall
+MicroResult measure(const std::function<void()>& kernel, const int samples, const double minTime) {
+    kernel();
+
+    // Calibrate iterations per sample
+    const double targetSample = minTime / std::max(1, samples);
+    int64_t iterations = 1;
+    Timer timer;
+    while (iterations < MAX_ITERATIONS) {
+        timer.start();
+        for (int64_t i = 0; i < iterations; ++i) kernel();
+        timer.stop();
+        const double seconds = timer.elapsedSeconds();
+        if (seconds >= targetSample) break;
+        // Aim directly at the target, growing at least 2x and at most 100x per round
+        const double scale = seconds > 0.0 ? targetSample / seconds * 1.2 : 100.0;
+        iterations = std::min(MAX_ITERATIONS,
+                              static_cast<int64_t>(iterations * std::clamp(scale, 2.0, 100.0)));
+    }
+
+    std::vector<int64_t> perIteration;
+    for (int s = 0; s < samples; ++s) {
+        timer.start();
+        for (int64_t i = 0; i < iterations; ++i) kernel();
+        timer.stop();
+        perIteration.push_back(timer.elapsedNanoseconds() / iterations);
+    }
+
+    MicroResult result;
+    result.iterations = iterations;
+    result.stats = computeTimingStats(perIteration);
+    return result;
+}
+
+std::string formatDuration(const int64_t ns) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(2);
+    if (ns < 10000) oss << static_cast<double>(ns) << " ns";
+    else if (ns < 10000000) oss << ns / 1e3 << " us";
+    else oss << ns / 1e6 << " ms";
+    return oss.str();
+}
+
+std::string formatThroughput(const double items, const std::string& unit, const int64_t ns) {
+    if (ns <= 0 || items <= 0.0) return "x";
+    const double perSecond = items / (ns / 1e9);
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(2);
+    if (perSecond >= 1e6) oss << perSecond / 1e6 << " M" << unit << "/s";
+    else oss << perSecond / 1e3 << " k" << unit << "/s";
+    return oss.str();
+}
+
+void printResult(const MicroResult& r) {
+    std::cout << std::left << std::setw(40) << r.name << std::right
+              << std::setw(10) << static_cast<long long>(r.items)
+              << std::setw(10) << r.iterations
+              << std::setw(13) << formatDuration(r.stats.medianNs)
+              << std::setw(13) << formatDuration(r.stats.minNs)
+              << std::setw(13) << formatDuration(r.stats.p90Ns)
+              << "  [" << formatDuration(r.stats.ciLowNs) << ", " << formatDuration(r.stats.ciHighNs) << "]"
+              << "  " << formatThroughput(r.items, r.unit, r.stats.medianNs) << std::endl;
+}
+
+void writeCsv(const std::string& path, const std::vector<MicroResult>& results) {
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << path << " for writing." << std::endl;
+        return;
+    }
+    file << "Case,Items,Unit,Iterations per Sample,Samples,Median (ns),Min (ns),P90 (ns),P99 (ns),"
+            "CI Low (ns),CI High (ns)\n";
+    for (const auto& r : results) {
+        file << r.name << "," << static_cast<long long>(r.items) << "," << r.unit << "," << r.iterations << ","
+             << r.stats.samples << "," << r.stats.medianNs << "," << r.stats.minNs << "," << r.stats.p90Ns << ","
+             << r.stats.p99Ns << "," << r.stats.ciLowNs << "," << r.stats.ciHighNs << "\n";
+    }
+    std::cout << "\nResults saved to: " << path << std::endl;
+}
+
+void printUsage(const std::string& programName) {
+    std::cout << "Usage: " << programName << " [options]\n\n"
+              << "  --filter <text>           Only run cases whose name contains text (e.g. lp_scan, kp=1000)\n"
+              << "  --resolutions <list>      Comma-separated WxH list (default: 640x480,1920x1080,4096x3072)\n"
+              << "  --keypoints <list>        Comma-separated keypoint counts (default: 1000,10000,50000)\n"
+              << "  --samples <N>             Timed samples per case (default: " << DEFAULT_SAMPLES << ")\n"
+              << "  --min-time <seconds>      Measured time per case, split over the samples (default: "
+              << DEFAULT_MIN_TIME << ")\n"
+              << "  --images <dir>            Image directory; the first set is used (default: images)\n"
+              << "  --csv <file>              Also write the results as CSV\n"
+              << "  --list                    List the case names and exit\n"
+              << "  --help                    Show this help message\n" << std::endl;
+}
+
+std::vector<std::string> split(const std::string& s, const char delimiter) {
+    std::vector<std::string> parts;
+    std::stringstream ss(s);
+    std::string part;
+    while (std::getline(ss, part, delimiter)) {
+        if (!part.empty()) parts.push_back(part);
+    }
+    return parts;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    std::string filter;
+    std::string imageDir = "images";
+    std::string csvPath;
+    std::vector<cv::Size> resolutions = DEFAULT_RESOLUTIONS;
+    std::vector<int> keypointCounts = DEFAULT_KEYPOINTS;
+    int samples = DEFAULT_SAMPLES;
+    double minTime = DEFAULT_MIN_TIME;
+    bool listOnly = false;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+
+            if (arg == "--help" || arg == "-h") {
+                printUsage(argv[0]);
+                return 0;
+            } else if (arg == "--list") {
+                listOnly = true;
+            } else if (arg == "--filter" && hasValue) {
+                filter = argv[++i];
+            } else if (arg == "--images" && hasValue) {
+                imageDir = argv[++i];
+            } else if (arg == "--csv" && hasValue) {
+                csvPath = argv[++i];
+            } else if (arg == "--samples" && hasValue) {
+                samples = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--min-time" && hasValue) {
+                minTime = std::max(0.0, std::stod(argv[++i]));
+            } else if (arg == "--resolutions" && hasValue) {
+                resolutions.clear();
+                for (const auto& r : split(argv[++i], ',')) {
+                    const auto wh = split(r, 'x');
+                    if (wh.size() != 2) throw std::invalid_argument("bad resolution " + r);
+                    resolutions.emplace_back(std::stoi(wh[0]), std::stoi(wh[1]));
+                }
+            } else if (arg == "--keypoints" && hasValue) {
+                keypointCounts.clear();
+                for (const auto& n : split(argv[++i], ',')) {
+                    keypointCounts.push_back(std::stoi(n));
+                }
+            } else {
+                std::cerr << "Unknown or incomplete argument: " << arg << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid argument: " << e.what() << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (resolutions.empty() || keypointCounts.empty()) {
+        std::cerr << "At least one resolution and one keypoint count are required" << std::endl;
+        return 1;
+    }
+
+    Fixtures fixtures(imageDir);
+    const std::vector<MicroCase> cases = makeCases(fixtures, resolutions, keypointCounts);
+
+    if (listOnly) {
+        for (const auto& c : cases) std::cout << c.name << std::endl;
+        return 0;
+    }
+
+    std::cout << "Inputs: " << fixtures.source() << ", " << samples << " samples per case\n" << std::endl;
+    std::cout << std::left << std::setw(40) << "Case" << std::right
+              << std::setw(10) << "Items" << std::setw(10) << "Iters"
+              << std::setw(13) << "Median" << std::setw(13) << "Min" << std::setw(13) << "P90"
+              << "  [" << BOOTSTRAP_CONFIDENCE * 100 << "% CI]  Throughput" << std::endl;
+    std::cout << std::string(130, '-') << std::endl;
+
+    std::vector<MicroResult> results;
+    for (const auto& c : cases) {
+        if (!filter.empty() && c.name.find(filter) == std::string::npos) continue;
+
+        double items = 0.0;
+        const std::function<void()> kernel = c.prepare(items);
+        if (items <= 0.0) {
+            std::cout << std::left << std::setw(40) << c.name << " skipped (no input)" << std::endl;
+            continue;
+        }
+
+        MicroResult result = measure(kernel, samples, minTime);
+        result.name = c.name;
+        result.unit = c.unit;
+        result.items = items;
+        printResult(result);
+        results.push_back(result);
+    }
+
+    if (!csvPath.empty()) {
+        writeCsv(csvPath, results);
+    }
+    return 0;
+}
@@ -0,0 +1,143 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * perfcounters.cpp
+ * Hardware performance counters and thread CPU time.
+ */
+
+#include "perfcounters.h"
+
+#include <ctime>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif
+
+namespace {
+
+int64_t threadCpuNs() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec ts{};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+#endif
+    return -1;
+}
+
+#ifdef __linux__
+// Same order as PerfSample's counter fields
+const uint64_t HARDWARE_EVENTS[] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_REFERENCES,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+int openCounter(const uint64_t event) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = event;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1; // allowed at the default perf_event_paranoid level
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // pid 0, cpu -1: the calling thread on any CPU
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+// Counter value scaled for the time it was actually scheduled (counters are multiplexed when oversubscribed)
+int64_t readCounter(const int fd) {
+    uint64_t values[3] = {0, 0, 0}; // value, time enabled, time running
+    if (fd < 0 || read(fd, values, sizeof(values)) != static_cast<ssize_t>(sizeof(values))) return -1;
+    if (values[2] == 0) return values[1] == 0 ? 0 : -1; // enabled but never scheduled
+    if (values[2] >= values[1]) return static_cast<int64_t>(values[0]);
+    return static_cast<int64_t>(static_cast<double>(values[0]) * values[1] / values[2]);
+}
+#endif
+
+} // anonymous namespace
+
+PerfSample& PerfSample::operator+=(const PerfSample& other) {
+    auto add = [](int64_t& a, const int64_t b) { a = (a < 0 || b < 0) ? -1 : a + b; };
+    add(cycles, other.cycles);
+    add(instructions, other.instructions);
+    add(cacheReferences, other.cacheReferences);
+    add(cacheMisses, other.cacheMisses);
+    add(branchMisses, other.branchMisses);
+    add(threadCpuNs, other.threadCpuNs);
+    return *this;
+}
+
+// ============================================================================
+// PerfCounters Implementation
+// ============================================================================
+
+PerfCounters::PerfCounters() {
+    for (int i = 0; i < NUM_COUNTERS; ++i) {
+#ifdef __linux__
+        fds_[i] = openCounter(HARDWARE_EVENTS[i]);
+#else
+        fds_[i] = -1;
+#endif
+    }
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (const int fd : fds_) {
+        if (fd >= 0) close(fd);
+    }
+#endif
+}
+
+bool PerfCounters::available() const {
+    for (const int fd : fds_) {
+        if (fd >= 0) return true;
+    }
+    return false;
+}
+
+void PerfCounters::start() {
+#ifdef __linux__
+    for (const int fd : fds_) {
+        if (fd < 0) continue;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+    startCpuNs_ = threadCpuNs();
+}
+
+PerfSample PerfCounters::stop() {
+    const int64_t endCpuNs = threadCpuNs();
+
+    int64_t values[NUM_COUNTERS];
+    for (int i = 0; i < NUM_COUNTERS; ++i) {
+#ifdef __linux__
+        if (fds_[i] >= 0) ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+        values[i] = readCounter(fds_[i]);
+#else
+        values[i] = -1;
+#endif
+    }
+
+    PerfSample sample;
+    sample.cycles = values[0];
+    sample.instructions = values[1];
+    sample.cacheReferences = values[2];
+    sample.cacheMisses = values[3];
+    sample.branchMisses = values[4];
+    sample.threadCpuNs = (startCpuNs_ >= 0 && endCpuNs >= 0) ? endCpuNs - startCpuNs_ : -1;
+    return sample;
+}
@@ -0,0 +1,70 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * perfcounters.h
+ * Hardware performance counters (Linux perf_event_open) and thread CPU time around pipeline stages,
+ * to tell memory-bound stages from compute- or call-overhead-bound ones.
+ */
+
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <cstdint>
+
+// Counter values of one measured interval; -1 where a counter is unavailable
+struct PerfSample {
+    int64_t cycles = -1;
+    int64_t instructions = -1;
+    int64_t cacheReferences = -1;
+    int64_t cacheMisses = -1;
+    int64_t branchMisses = -1;
+    int64_t threadCpuNs = -1; // CLOCK_THREAD_CPUTIME_ID
+
+    // Instructions per cycle, or -1
+    double ipc() const {
+        return cycles > 0 && instructions >= 0 ? static_cast<double>(instructions) / cycles : -1.0;
+    }
+
+    // Cache misses per cache reference (last-level cache on most CPUs), or -1
+    double cacheMissRate() const {
+        return cacheReferences > 0 && cacheMisses >= 0 ? static_cast<double>(cacheMisses) / cacheReferences : -1.0;
+    }
+
+    // Branch misses per 1000 instructions, or -1
+    double branchMpki() const {
+        return instructions > 0 && branchMisses >= 0 ? 1000.0 * branchMisses / instructions : -1.0;
+    }
+
+    // Accumulate another interval; a counter unavailable in either stays unavailable
+    PerfSample& operator+=(const PerfSample& other);
+};
+
+/*
+ * PerfCounters - Counts the calling thread's user-space events between start() and stop().
+ * Each counter is opened separately, so one the CPU or VM does not support (or perf_event_paranoid
+ * forbids) reads as -1 while the others still work; multiplexed counters are scaled to the full interval.
+ * Work OpenCV hands to its own worker threads is not included. Not copyable; use on one thread.
+ */
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /** @brief True if at least one hardware counter could be opened. */
+    bool available() const;
+
+    void start();
+    PerfSample stop();
+
+private:
+    static constexpr int NUM_COUNTERS = 5; // cycles, instructions, cache references, cache misses, branch misses
+
+    int fds_[NUM_COUNTERS];
+    int64_t startCpuNs_ = -1;
+};
+
+#endif //PERFCOUNTERS_H
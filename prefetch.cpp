@@ -0,0 +1,324 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * prefetch.cpp
+ * Image ingest and background decoding of benchmark image sets.
+ */
+
+#include "prefetch.h"
+#include "trace.h"
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Formats without a parsed header: assume roughly 10:1 compression
+constexpr size_t FALLBACK_COMPRESSION_RATIO = 10;
+
+int readBigEndian16(std::istream& in) {
+    const int hi = in.get();
+    const int lo = in.get();
+    return (hi << 8) | lo;
+}
+
+// Width and height from the JPEG start-of-frame segment
+bool readJpegSize(std::istream& in, int& width, int& height) {
+    if (in.get() != 0xFF || in.get() != 0xD8) return false; // SOI
+
+    while (in) {
+        // Markers start with 0xFF, optionally padded with more 0xFF bytes
+        int byte = in.get();
+        if (byte != 0xFF) return false;
+        while (byte == 0xFF) byte = in.get();
+        const int marker = byte;
+
+        if (marker == 0xD8 || marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) continue; // no payload
+        if (marker == 0xD9 || marker == 0xDA) return false; // end of image / start of scan before any SOF
+
+        const int length = readBigEndian16(in);
+        if (length < 2) return false;
+
+        // SOF0..SOF15, except DHT (C4), JPG (C8) and DAC (CC)
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            in.get(); // sample precision
+            height = readBigEndian16(in);
+            width = readBigEndian16(in);
+            return in && width > 0 && height > 0;
+        }
+
+        in.seekg(length - 2, std::ios::cur);
+    }
+    return false;
+}
+
+// Width and height from the PNG IHDR chunk
+bool readPngSize(std::istream& in, int& width, int& height) {
+    unsigned char header[24];
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header))) return false;
+    if (header[0] != 0x89 || header[1] != 'P' || header[2] != 'N' || header[3] != 'G') return false;
+    auto be32 = [&header](const int offset) {
+        return (header[offset] << 24) | (header[offset + 1] << 16) | (header[offset + 2] << 8) | header[offset + 3];
+    };
+    width = be32(16);
+    height = be32(20);
+    return width > 0 && height > 0;
+}
+
+double secondsSince(const std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// imread flags for a grayscale or color decode at the given reduction; JPEG downscales in the DCT domain
+int imreadFlags(const bool color, const int reduction) {
+    switch (reduction) {
+        case 2: return color ? cv::IMREAD_REDUCED_COLOR_2 : cv::IMREAD_REDUCED_GRAYSCALE_2;
+        case 4: return color ? cv::IMREAD_REDUCED_COLOR_4 : cv::IMREAD_REDUCED_GRAYSCALE_4;
+        case 8: return color ? cv::IMREAD_REDUCED_COLOR_8 : cv::IMREAD_REDUCED_GRAYSCALE_8;
+        default: return color ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE;
+    }
+}
+
+} // anonymous namespace
+
+size_t estimateDecodedBytes(const std::string& path, const int channels, const int reduction) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return 0;
+
+    const int r = std::max(1, reduction);
+    auto decodedBytes = [&](const int width, const int height) {
+        return static_cast<size_t>((width + r - 1) / r) * ((height + r - 1) / r) * channels; // 8-bit
+    };
+
+    int width = 0, height = 0;
+    if (readJpegSize(in, width, height)) {
+        return decodedBytes(width, height);
+    }
+
+    in.clear();
+    in.seekg(0);
+    if (readPngSize(in, width, height)) {
+        return decodedBytes(width, height);
+    }
+
+    std::error_code ec;
+    const auto fileSize = fs::file_size(path, ec);
+    return ec ? 0 : static_cast<size_t>(fileSize) * FALLBACK_COMPRESSION_RATIO * channels / 3 / (r * r);
+}
+
+// ============================================================================
+// IngestedImage Implementation
+// ============================================================================
+
+IngestedImage::IngestedImage(const std::string& path, const int reduction)
+    : state_(std::make_shared<State>()) {
+    state_->path = path;
+    state_->reduction = reduction;
+
+    const auto start = std::chrono::steady_clock::now();
+    state_->gray = cv::imread(path, imreadFlags(false, reduction));
+    state_->grayTime = secondsSince(start);
+}
+
+IngestedImage::IngestedImage(const YUVFrame& frame)
+    : state_(std::make_shared<State>()) {
+    state_->frame = frame;
+    state_->gray = frame.luma(); // header over the caller's Y plane, nothing decoded
+}
+
+IngestedImage IngestedImage::asCameraFrame(const std::string& path, const int reduction) {
+    const auto start = std::chrono::steady_clock::now();
+    const cv::Mat bgr = cv::imread(path, imreadFlags(true, reduction));
+    if (bgr.empty() || bgr.cols < 2 || bgr.rows < 2) return IngestedImage();
+
+    IngestedImage image(YUVFrame::fromBGR(bgr));
+    image.state_->path = path;
+    image.state_->reduction = reduction;
+    image.state_->grayTime = secondsSince(start);
+    return image;
+}
+
+void IngestedImage::chargeColorTo(std::shared_ptr<std::atomic<size_t>> counter) {
+    if (state_) state_->colorCounter = std::move(counter);
+}
+
+const cv::Mat& IngestedImage::gray() const {
+    static const cv::Mat none;
+    return state_ ? state_->gray : none;
+}
+
+const cv::Mat& IngestedImage::color() const {
+    static const cv::Mat none;
+    if (!state_) return none;
+
+    std::call_once(state_->colorOnce, [this] {
+        const auto start = std::chrono::steady_clock::now();
+        if (!state_->frame.empty()) {
+            state_->frame.toBGR(state_->color);
+        } else {
+            state_->color = cv::imread(state_->path, imreadFlags(true, state_->reduction));
+        }
+        if (state_->color.empty() && !state_->gray.empty()) {
+            cv::cvtColor(state_->gray, state_->color, cv::COLOR_GRAY2BGR);
+        }
+        state_->colorTime = secondsSince(start);
+        state_->colorReady = true;
+        if (state_->colorCounter) {
+            *state_->colorCounter += state_->color.total() * state_->color.elemSize();
+        }
+    });
+    return state_->color;
+}
+
+// ============================================================================
+// ImageSetPrefetcher Implementation
+// ============================================================================
+
+ImageSetPrefetcher::ImageSetPrefetcher(std::vector<std::string> setPaths, const Options& options)
+    : paths_(std::move(setPaths)),
+      options_(options) {
+    // Header reads are cheap; doing them up front lets the budget check run before each decode
+    for (const auto& path : paths_) {
+        const size_t grayBytes = estimateDecodedBytes(path + "/reference.jpg", 1, options_.reduction) +
+                                 estimateDecodedBytes(path + "/registered.jpg", 1, options_.reduction);
+        estimates_.push_back(options_.cameraFrames ? grayBytes * 3 / 2 : grayBytes); // NV12: Y plus half chroma
+    }
+
+    for (unsigned i = 0; i < options_.decodeThreads; ++i) {
+        threads_.emplace_back(&ImageSetPrefetcher::decodeLoop, this);
+    }
+}
+
+ImageSetPrefetcher::~ImageSetPrefetcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    changed_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+LoadedImageSet ImageSetPrefetcher::decode(const std::string& path) const {
+    LoadedImageSet set;
+    set.path = path;
+    set.name = fs::path(path).filename().string();
+
+    const trace::ContextScope context(set.name, "", "");
+    trace::Span span("decode image set");
+
+    // Grayscale only; color is decoded later, and only if a composite is written
+    if (options_.cameraFrames) {
+        set.registered = IngestedImage::asCameraFrame(path + "/registered.jpg", options_.reduction);
+        set.reference = IngestedImage::asCameraFrame(path + "/reference.jpg", options_.reduction);
+    } else {
+        set.registered = IngestedImage(path + "/registered.jpg", options_.reduction);
+        set.reference = IngestedImage(path + "/reference.jpg", options_.reduction);
+    }
+    set.decodeTime = set.reference.grayDecodeTime() + set.registered.grayDecodeTime();
+
+    set.bytes = set.reference.sourceBytes() + set.registered.sourceBytes();
+    set.colorBytes = std::make_shared<std::atomic<size_t>>(0);
+    set.reference.chargeColorTo(set.colorBytes);
+    set.registered.chargeColorTo(set.colorBytes);
+    span.arg("bytes", static_cast<int64_t>(set.bytes));
+    span.end();
+    return set;
+}
+
+// Decoded bytes held now, including the color the consumer decoded for its composites (mutex_ held)
+size_t ImageSetPrefetcher::heldBytes() const {
+    return bytesHeld_ + (consumerColorBytes_ ? consumerColorBytes_->load() : 0);
+}
+
+bool ImageSetPrefetcher::canStartNext() const {
+    if (nextToDecode_ >= paths_.size()) return false;
+
+    // Lookahead: sets beyond the one the consumer is currently benchmarking
+    if (nextToDecode_ >= nextToReturn_ + std::max<size_t>(1, options_.lookahead)) return false;
+
+    // Memory: always allow one set when nothing is held so an oversized set cannot stall loading
+    const size_t held = heldBytes();
+    return held == 0 || held + estimates_[nextToDecode_] <= options_.memoryBudgetBytes;
+}
+
+void ImageSetPrefetcher::reserve(const size_t bytes) {
+    bytesHeld_ += bytes;
+    peakBytes_ = std::max(peakBytes_, heldBytes());
+}
+
+void ImageSetPrefetcher::decodeLoop() {
+    trace::setThreadName("prefetch");
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        changed_.wait(lock, [this] { return stopping_ || nextToDecode_ >= paths_.size() || canStartNext(); });
+        if (stopping_ || nextToDecode_ >= paths_.size()) return;
+
+        const size_t index = nextToDecode_++;
+        const size_t estimate = estimates_[index];
+        reserve(estimate);
+
+        lock.unlock();
+        LoadedImageSet set = decode(paths_[index]);
+        lock.lock();
+
+        // Replace the header estimate with the actual decoded size
+        bytesHeld_ -= estimate;
+        reserve(set.bytes);
+
+        ready_.emplace(index, std::move(set));
+        changed_.notify_all();
+    }
+}
+
+std::optional<LoadedImageSet> ImageSetPrefetcher::next() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // The consumer is done with the previous set, including the color it decoded since
+    peakBytes_ = std::max(peakBytes_, heldBytes());
+    bytesHeld_ -= consumerBytes_;
+    consumerBytes_ = 0;
+    consumerColorBytes_.reset();
+
+    if (nextToReturn_ >= paths_.size()) return std::nullopt;
+
+    const auto waitStart = std::chrono::steady_clock::now();
+    LoadedImageSet set;
+
+    if (threads_.empty()) {
+        // Synchronous loading: decode on the calling thread
+        ++nextToDecode_;
+        lock.unlock();
+        set = decode(paths_[nextToReturn_]);
+        lock.lock();
+        reserve(set.bytes);
+    } else {
+        changed_.notify_all();
+        changed_.wait(lock, [this] { return ready_.count(nextToReturn_) > 0; });
+        auto it = ready_.find(nextToReturn_);
+        set = std::move(it->second);
+        ready_.erase(it);
+    }
+
+    set.waitTime = secondsSince(waitStart);
+    consumerBytes_ = set.bytes;
+    consumerColorBytes_ = set.colorBytes;
+    ++nextToReturn_;
+    changed_.notify_all(); // the lookahead window moved
+
+    return set;
+}
+
+size_t ImageSetPrefetcher::peakBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::max(peakBytes_, heldBytes());
+}
@@ -0,0 +1,177 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * prefetch.h
+ * Image ingest and background decoding of benchmark image sets (reference.jpg / registered.jpg):
+ *  - IngestedImage: grayscale decoded directly (or a camera frame's Y plane), color decoded lazily for the composite only
+ *  - ImageSetPrefetcher: decodes the next sets while the current one is benchmarked
+ */
+
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <opencv2/core.hpp>
+
+#include "yuvframe.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * IngestedImage - One input image as the pipeline consumes it.
+ * Every LP stage works on gray data, so the file is decoded straight to grayscale (IMREAD_GRAYSCALE),
+ * or with libjpeg's DCT-domain downscaling (IMREAD_REDUCED_GRAYSCALE_2/4/8) for a reduced resolution.
+ * Color is decoded at the same resolution on the first color() call, i.e. only for the stitched composite.
+ * A YUV camera frame is used in place: gray() is its Y plane and color() converts with the chroma plane.
+ * Copies share the decoded data, and the lazy color decode happens once across all copies and threads.
+ */
+class IngestedImage {
+public:
+    IngestedImage() = default;
+
+    /** @brief Decode the grayscale image.
+     *  @param path Image file path.
+     *  @param reduction Downscale factor: 1 (full resolution), 2, 4 or 8.
+     */
+    IngestedImage(const std::string& path, int reduction);
+
+    /** @brief Use a camera frame without copying; the frame's buffers are kept alive with this image.
+     *  @param frame NV12/NV21 frame view.
+     */
+    explicit IngestedImage(const YUVFrame& frame);
+
+    /** @brief Decode the file in color and ingest it as an NV12 camera frame (--ingest nv12).
+     *  Decoding and repacking count as the gray decode time; color() then converts from the frame.
+     */
+    static IngestedImage asCameraFrame(const std::string& path, int reduction);
+
+    /** @brief True if the file could not be decoded. */
+    bool empty() const { return !state_ || state_->gray.empty(); }
+
+    /** @brief Single-channel 8-bit image. */
+    const cv::Mat& gray() const;
+
+    /** @brief 8-bit BGR image, decoded on first use (falls back to gray converted to BGR). */
+    const cv::Mat& color() const;
+
+    bool colorDecoded() const { return state_ && state_->colorReady.load(); }
+
+    /** @brief Add the color bytes to counter once color() decodes them (memory accounting of the set). */
+    void chargeColorTo(std::shared_ptr<std::atomic<size_t>> counter);
+
+    int reduction() const { return state_ ? state_->reduction : 1; }
+
+    double grayDecodeTime() const { return state_ ? state_->grayTime : 0.0; }
+    double colorDecodeTime() const { return colorDecoded() ? state_->colorTime : 0.0; }
+
+    size_t grayBytes() const { return empty() ? 0 : state_->gray.total() * state_->gray.elemSize(); }
+    // Bytes held by the ingested source: the gray image, or both planes of a camera frame
+    size_t sourceBytes() const { return empty() ? 0 : state_->frame.empty() ? grayBytes() : state_->frame.bytes(); }
+    size_t colorBytes() const { return colorDecoded() ? state_->color.total() * state_->color.elemSize() : 0; }
+
+private:
+    struct State {
+        std::string path;
+        YUVFrame frame; // source when ingesting a camera frame instead of a file
+        int reduction = 1;
+        cv::Mat gray;
+        double grayTime = 0.0;
+        std::once_flag colorOnce;
+        std::atomic<bool> colorReady{false};
+        cv::Mat color;
+        double colorTime = 0.0;
+        std::shared_ptr<std::atomic<size_t>> colorCounter; // null: not accounted
+    };
+
+    std::shared_ptr<State> state_;
+};
+
+// One decoded image set
+struct LoadedImageSet {
+    std::string name;          // set directory name
+    std::string path;          // set directory path
+    IngestedImage reference;   // empty if reference.jpg could not be decoded
+    IngestedImage registered;  // empty if registered.jpg could not be decoded
+    double decodeTime = 0.0;   // seconds spent decoding both images (grayscale)
+    double waitTime = 0.0;     // seconds the consumer blocked in next() for this set
+    size_t bytes = 0;          // decoded size counted against the memory budget
+    std::shared_ptr<std::atomic<size_t>> colorBytes; // lazily decoded color, counted while the set is current
+};
+
+/** @brief Decoded size of an image file, read from its header (JPEG SOF or PNG IHDR).
+ *  Falls back to a multiple of the file size for other formats.
+ *  @param path Image file path.
+ *  @param channels Channels of the decoded image (1 for grayscale ingest, 3 for BGR).
+ *  @param reduction Downscale factor of the decode (1, 2, 4 or 8).
+ *  @return Estimated bytes of the imread() result, 0 if the file cannot be read.
+ */
+size_t estimateDecodedBytes(const std::string& path, int channels = 3, int reduction = 1);
+
+/*
+ * ImageSetPrefetcher - Decodes image sets on background threads, in order, ahead of the consumer.
+ * At most `lookahead` sets beyond the one being benchmarked are decoded, and a set is only started
+ * when the decoded bytes held (queued plus the consumer's current set, with the color it decoded for the
+ * composite) stay within the memory budget, estimated from the image headers before decoding. A set that
+ * alone exceeds the budget is still
+ * decoded once nothing else is held, so loading always makes progress.
+ */
+class ImageSetPrefetcher {
+public:
+    struct Options {
+        size_t lookahead = 2;                         // sets decoded ahead of the current one
+        size_t memoryBudgetBytes = size_t(1) << 30;   // decoded bytes held at once (1 GiB)
+        unsigned decodeThreads = 2;                   // 0 decodes synchronously inside next()
+        int reduction = 1;                            // ingest downscale factor: 1, 2, 4 or 8
+        bool cameraFrames = false;                    // ingest NV12 camera frames instead of grayscale decodes
+    };
+
+    ImageSetPrefetcher(std::vector<std::string> setPaths, const Options& options);
+    ~ImageSetPrefetcher();
+
+    ImageSetPrefetcher(const ImageSetPrefetcher&) = delete;
+    ImageSetPrefetcher& operator=(const ImageSetPrefetcher&) = delete;
+
+    /** @brief Next image set in input order, waiting for its decode if needed.
+     *  The set returned by the previous call is released from the memory budget.
+     *  @return The set, or std::nullopt after the last one.
+     */
+    std::optional<LoadedImageSet> next();
+
+    /** @brief Largest number of decoded bytes held at once so far. */
+    size_t peakBytes() const;
+
+private:
+    std::vector<std::string> paths_;
+    std::vector<size_t> estimates_;
+    Options options_;
+
+    std::map<size_t, LoadedImageSet> ready_; // decoded, not yet returned
+    size_t nextToDecode_ = 0;
+    size_t nextToReturn_ = 0;
+    size_t bytesHeld_ = 0;
+    size_t peakBytes_ = 0;
+    size_t consumerBytes_ = 0; // bytes of the set last returned by next()
+    std::shared_ptr<std::atomic<size_t>> consumerColorBytes_; // its color images decoded so far
+    bool stopping_ = false;
+
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<std::thread> threads_;
+
+    size_t heldBytes() const;
+    bool canStartNext() const;
+    void reserve(size_t bytes);
+    void decodeLoop();
+    LoadedImageSet decode(const std::string& path) const;
+};
+
+#endif //PREFETCH_H
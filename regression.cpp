@@ -0,0 +1,306 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * regression.cpp
+ * Results CSV reader and baseline comparison.
+ */
+
+#include "regression.h"
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <tuple>
+
+namespace {
+
+using RowKey = std::tuple<std::string, std::string, std::string>; // dataset, algorithm, window sizes
+
+enum class StageChange { None, Slower, Faster };
+
+RowKey keyOf(const ResultRow& row) {
+    return {row.dataset, row.algorithm, row.windowSizes};
+}
+
+// Next CSV record: lines are joined while a quoted field is open (e.g. an exception message with newlines)
+bool readCsvRecord(std::istream& in, std::string& record) {
+    if (!std::getline(in, record)) return false;
+    auto quoteOpen = [&record] { return std::count(record.begin(), record.end(), '"') % 2 != 0; };
+    std::string line;
+    while (quoteOpen() && std::getline(in, line)) {
+        record += '\n';
+        record += line;
+    }
+    return true;
+}
+
+// Fields of one CSV record; quoted fields may hold commas, newlines and doubled quotes
+std::vector<std::string> parseCsvLine(const std::string& line) {
+    std::vector<std::string> fields;
+    std::string field;
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); ++i) {
+        const char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                field += '"';
+                ++i;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                field += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.push_back(field);
+            field.clear();
+        } else if (c != '\r') {
+            field += c;
+        }
+    }
+    fields.push_back(field);
+    return fields;
+}
+
+// Number in a field, or fallback for "x", empty or malformed fields
+double parseNumber(const std::string& field, const double fallback) {
+    if (field.empty()) return fallback;
+    char* end = nullptr;
+    const double value = std::strtod(field.c_str(), &end);
+    return end && *end == '\0' ? value : fallback;
+}
+
+StageChange classify(const StageTiming& base, const StageTiming& now, const double threshold,
+                     const bool useIntervals, const double minDeltaMs) {
+    if (std::abs(now.medianMs - base.medianMs) < minDeltaMs) return StageChange::None;
+
+    // With repetitions on both sides the confidence intervals of the medians must not overlap either
+    if (now.medianMs > base.medianMs * (1.0 + threshold) && (!useIntervals || now.ciLowMs > base.ciHighMs)) {
+        return StageChange::Slower;
+    }
+    if (base.medianMs > now.medianMs * (1.0 + threshold) && (!useIntervals || base.ciLowMs > now.ciHighMs)) {
+        return StageChange::Faster;
+    }
+    return StageChange::None;
+}
+
+bool accuracyDropped(const double base, const double now, const CompareOptions& options) {
+    return now > base * (1.0 + options.accuracyTolerance) + options.accuracySlack;
+}
+
+std::string formatValue(const double value, const int precision) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(precision) << value;
+    return oss.str();
+}
+
+std::string formatPercentChange(const double base, const double now) {
+    if (base <= 0.0) return "x";
+    const double change = (now / base - 1.0) * 100.0;
+    return (change >= 0.0 ? "+" : "") + formatValue(change, 1) + "%";
+}
+
+std::string formatInterval(const StageTiming& t) {
+    return "[" + formatValue(t.ciLowMs, 3) + ", " + formatValue(t.ciHighMs, 3) + "]";
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Results CSV Implementation
+// ============================================================================
+
+bool loadResultsCsv(const std::string& path, std::vector<ResultRow>& rows, std::string& error) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "could not open " + path;
+        return false;
+    }
+
+    std::string line;
+    if (!readCsvRecord(file, line)) {
+        error = path + " is empty";
+        return false;
+    }
+    std::map<std::string, size_t> columns;
+    const std::vector<std::string> header = parseCsvLine(line);
+    for (size_t i = 0; i < header.size(); ++i) {
+        columns.emplace(header[i], i);
+    }
+    for (const char* required : {"Dataset", "Algorithm", "Window Size (L)"}) {
+        if (!columns.count(required)) {
+            error = path + " has no \"" + required + "\" column (not a results CSV?)";
+            return false;
+        }
+    }
+
+    rows.clear();
+    while (readCsvRecord(file, line)) {
+        if (line.empty() || line == "\r") continue;
+        const std::vector<std::string> fields = parseCsvLine(line);
+        auto field = [&](const std::string& name) -> std::string {
+            const auto it = columns.find(name);
+            return it != columns.end() && it->second < fields.size() ? fields[it->second] : std::string();
+        };
+
+        ResultRow row;
+        row.dataset = field("Dataset");
+        row.algorithm = field("Algorithm");
+        row.windowSizes = field("Window Size (L)");
+        row.success = field("Success") == "Yes";
+        row.repetitions = static_cast<int>(parseNumber(field("Repetitions"), 1.0));
+        row.homographyNorm = parseNumber(field("Homography L2 Norm"), -1.0);
+        row.cornerError = parseNumber(field("Corner Error (px)"), -1.0);
+
+        for (const auto& stage : timedStages()) {
+            const std::string prefix = stage.label;
+            StageTiming timing;
+            timing.medianMs = parseNumber(field(prefix + " Median (ms)"), -1.0);
+            timing.ciLowMs = parseNumber(field(prefix + " CI Low (ms)"), timing.medianMs);
+            timing.ciHighMs = parseNumber(field(prefix + " CI High (ms)"), timing.medianMs);
+            timing.valid = timing.medianMs >= 0.0;
+            row.stages.push_back(timing);
+        }
+        rows.push_back(row);
+    }
+    return true;
+}
+
+// ============================================================================
+// Comparison Implementation
+// ============================================================================
+
+int compareResults(const std::vector<ResultRow>& baseline, const std::vector<ResultRow>& current,
+                   const CompareOptions& options) {
+    std::map<RowKey, const ResultRow*> baselineByKey;
+    for (const auto& row : baseline) {
+        baselineByKey.emplace(keyOf(row), &row); // first occurrence wins, as in the results order
+    }
+
+    const size_t totalStage = timedStages().size() - 1;
+    std::cout << "\n" << std::string(120, '=') << std::endl;
+    std::cout << "COMPARISON WITH BASELINE (stage medians; threshold +" << formatValue(options.threshold * 100.0, 0)
+              << "% unless overridden)" << std::endl;
+    std::cout << std::string(120, '=') << std::endl;
+    std::cout << std::left
+              << std::setw(15) << "Dataset"
+              << std::setw(12) << "Algorithm"
+              << std::setw(24) << "Window(L)"
+              << std::setw(14) << "Base(ms)"
+              << std::setw(14) << "Now(ms)"
+              << std::setw(10) << "Change"
+              << std::setw(21) << "Error (base -> now)"
+              << "Status" << std::endl;
+    std::cout << std::string(120, '-') << std::endl;
+
+    int regressions = 0;
+    std::set<RowKey> matched;
+    std::vector<const ResultRow*> onlyCurrent;
+
+    for (const auto& now : current) {
+        const auto found = baselineByKey.find(keyOf(now));
+        if (found == baselineByKey.end()) {
+            onlyCurrent.push_back(&now);
+            continue;
+        }
+        const ResultRow& base = *found->second;
+        matched.insert(found->first);
+
+        bool regressed = false;
+        bool improved = false;
+        std::vector<std::string> details;
+
+        if (base.success && !now.success) {
+            regressed = true;
+            details.push_back("! stitch failed (succeeded in the baseline)");
+        } else if (!base.success && now.success) {
+            improved = true;
+        }
+
+        // Accuracy: the ground-truth corner error where both runs have one, else the distance from SIFT
+        std::string accuracy = "x";
+        if (base.success && now.success) {
+            const bool corners = base.cornerError >= 0.0 && now.cornerError >= 0.0;
+            const double baseError = corners ? base.cornerError : base.homographyNorm;
+            const double nowError = corners ? now.cornerError : now.homographyNorm;
+            if (baseError >= 0.0 && nowError >= 0.0) {
+                accuracy = formatValue(baseError, 2) + " -> " + formatValue(nowError, 2) + (corners ? " px" : "");
+                if (accuracyDropped(baseError, nowError, options)) {
+                    regressed = true;
+                    details.push_back(std::string("! homography ") + (corners ? "corner error" : "L2 norm from SIFT") +
+                                      " grew from " + formatValue(baseError, 3) + " to " + formatValue(nowError, 3));
+                }
+            }
+        }
+
+        // Stage timings, confirmed by the confidence intervals when both runs were repeated
+        const bool useIntervals = base.repetitions > 1 && now.repetitions > 1;
+        for (size_t i = 0; base.success && now.success && i < timedStages().size(); ++i) {
+            if (i >= base.stages.size() || i >= now.stages.size()) break;
+            const StageTiming& b = base.stages[i];
+            const StageTiming& n = now.stages[i];
+            if (!b.valid || !n.valid) continue;
+
+            const double threshold = options.thresholdFor(timedStages()[i].key);
+            const StageChange change = classify(b, n, threshold, useIntervals, options.minDeltaMs);
+            if (change == StageChange::None) continue;
+
+            std::string detail = (change == StageChange::Slower ? "! " : "+ ") + std::string(timedStages()[i].label) +
+                                 ": " + formatValue(b.medianMs, 3) + " -> " + formatValue(n.medianMs, 3) + " ms (" +
+                                 formatPercentChange(b.medianMs, n.medianMs) + ", limit +" +
+                                 formatValue(threshold * 100.0, 0) + "%)";
+            if (useIntervals) {
+                detail += ", CI " + formatInterval(b) + " -> " + formatInterval(n);
+            }
+            details.push_back(detail);
+            regressed = regressed || change == StageChange::Slower;
+            improved = improved || change == StageChange::Faster;
+        }
+
+        const bool haveTotal = totalStage < base.stages.size() && totalStage < now.stages.size() &&
+                               base.stages[totalStage].valid && now.stages[totalStage].valid;
+        std::cout << std::left
+                  << std::setw(15) << now.dataset.substr(0, 14)
+                  << std::setw(12) << now.algorithm
+                  << std::setw(24) << now.windowSizes
+                  << std::setw(14) << (haveTotal ? formatValue(base.stages[totalStage].medianMs, 3) : "x")
+                  << std::setw(14) << (haveTotal ? formatValue(now.stages[totalStage].medianMs, 3) : "x")
+                  << std::setw(10) << (haveTotal ? formatPercentChange(base.stages[totalStage].medianMs,
+                                                                       now.stages[totalStage].medianMs) : "x")
+                  << std::setw(21) << accuracy
+                  << (regressed ? "REGRESSED" : improved ? "improved" : "ok") << std::endl;
+        for (const auto& detail : details) {
+            std::cout << "    " << detail << std::endl;
+        }
+        if (regressed) ++regressions;
+    }
+
+    std::cout << std::string(120, '-') << std::endl;
+    for (const auto& [key, row] : baselineByKey) {
+        if (!matched.count(key)) {
+            std::cout << "Only in baseline: " << row->dataset << " / " << row->algorithm << " / " << row->windowSizes
+                      << std::endl;
+        }
+    }
+    for (const ResultRow* row : onlyCurrent) {
+        std::cout << "Only in this run: " << row->dataset << " / " << row->algorithm << " / " << row->windowSizes
+                  << std::endl;
+    }
+    if (baseline.empty() || matched.empty()) {
+        std::cout << "Note: no rows matched by (dataset, algorithm, window sizes)" << std::endl;
+    } else if (!current.empty() && (current.front().repetitions < 2 || baseline.front().repetitions < 2)) {
+        std::cout << "Note: single runs are compared by threshold only; --repeat in both runs also requires the "
+                  << "confidence intervals to separate" << std::endl;
+    }
+
+    std::cout << regressions << " of " << matched.size() << " matched results regressed" << std::endl;
+    return regressions;
+}
@@ -0,0 +1,67 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * regression.h
+ * Regression gate between two benchmark result files (--compare):
+ *  - loadResultsCsv: the rows of a results*.csv written by CSVExporter
+ *  - compareResults: rows matched by (dataset, algorithm, window sizes); per-stage slowdowns beyond a
+ *    threshold that the repetition confidence intervals confirm, failed stitches and homography
+ *    accuracy drops are reported as regressions
+ */
+
+#ifndef REGRESSION_H
+#define REGRESSION_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Exit code of a run whose comparison found a regression (errors exit with 1)
+constexpr int REGRESSION_EXIT_CODE = 2;
+
+struct CompareOptions {
+    double threshold = 0.10;                    // allowed slowdown of a stage median (fraction)
+    std::map<std::string, double> stageThresholds; // per timedStages() key, overriding threshold
+    double minDeltaMs = 1.0;                    // slowdowns smaller than this are timer noise
+    double accuracyTolerance = 0.25;            // allowed relative growth of the homography error
+    double accuracySlack = 1.0;                 // ... plus this much absolute (px, or L2 norm units)
+
+    double thresholdFor(const std::string& stageKey) const {
+        const auto it = stageThresholds.find(stageKey);
+        return it == stageThresholds.end() ? threshold : it->second;
+    }
+};
+
+// Median and bootstrap CI of one stage in a results file; valid is false where the file has none
+struct StageTiming {
+    bool valid = false;
+    double medianMs = 0.0;
+    double ciLowMs = 0.0;
+    double ciHighMs = 0.0;
+};
+
+// What the comparison needs of one results row
+struct ResultRow {
+    std::string dataset;
+    std::string algorithm;
+    std::string windowSizes;
+    bool success = false;
+    int repetitions = 1;
+    double homographyNorm = -1.0; // L2 norm of the difference from the SIFT homography, -1 if missing
+    double cornerError = -1.0;    // corner error against the ground truth (synthetic sets), -1 if missing
+    std::vector<StageTiming> stages; // one per timedStages() entry
+};
+
+/** @brief Read a results CSV; columns are found by header name, so older files load with fewer stages.
+ *  @return False (with error set) if the file cannot be read or lacks the identifying columns.
+ */
+bool loadResultsCsv(const std::string& path, std::vector<ResultRow>& rows, std::string& error);
+
+/** @brief Print a diff table of current against baseline and count the regressions.
+ *  @return Number of regressed rows (slower stage, failed stitch or accuracy drop).
+ */
+int compareResults(const std::vector<ResultRow>& baseline, const std::vector<ResultRow>& current,
+                   const CompareOptions& options);
+
+#endif //REGRESSION_H
@@ -0,0 +1,309 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * scaling.cpp
+ * Thread-count and resolution sweep with per-stage scaling tables.
+ */
+
+#include "scaling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+namespace {
+
+constexpr double MIN_STAGE_MS = 1.0; // shorter stages are dominated by timer and scheduling noise
+
+// Points of one (dataset, algorithm) stitch, by (reduction, threads)
+struct Series {
+    std::map<std::pair<int, unsigned>, const ScalingPoint*> points;
+    std::set<int> reductions;
+    std::set<unsigned> threads;
+
+    const ScalingPoint* at(const int reduction, const unsigned threads) const {
+        const auto it = points.find({reduction, threads});
+        return it == points.end() ? nullptr : it->second;
+    }
+
+    // Smallest thread count measured at a resolution, or 0
+    unsigned baseThreads(const int reduction) const {
+        for (const unsigned t : threads) {
+            if (at(reduction, t)) return t;
+        }
+        return 0;
+    }
+};
+
+std::map<std::pair<std::string, std::string>, Series> groupSeries(const std::vector<ScalingPoint>& points) {
+    std::map<std::pair<std::string, std::string>, Series> series;
+    for (const auto& p : points) {
+        Series& s = series[{p.datasetName, p.algorithmName}];
+        s.points[{p.reduction, p.threads}] = &p;
+        s.reductions.insert(p.reduction);
+        s.threads.insert(p.threads);
+    }
+    return series;
+}
+
+double stageMs(const ScalingPoint& p, const size_t stage) {
+    return stage < p.stageSeconds.size() ? p.stageSeconds[stage] * 1000.0 : 0.0;
+}
+
+// Speedup of `point` over `base` for one stage, or -1 if either time is missing
+double speedup(const ScalingPoint* base, const ScalingPoint* point, const size_t stage) {
+    if (!base || !point || stageMs(*point, stage) <= 0.0) return -1.0;
+    return stageMs(*base, stage) / stageMs(*point, stage);
+}
+
+std::string formatFixed(const double value, const int precision) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(precision) << value;
+    return oss.str();
+}
+
+std::string formatScaling(const double speedupValue, const double efficiency) {
+    if (speedupValue < 0.0) return "x";
+    return formatFixed(speedupValue, 2) + "x " + formatFixed(efficiency * 100.0, 0) + "%";
+}
+
+void printStageLabel(const TimedStage& stage) {
+    std::cout << "  " << std::left << std::setw(18) << stage.label << std::right;
+}
+
+// Strong scaling at the finest resolution, and the stages that stop scaling there
+void printStrongScaling(const Series& series, const ScalingOptions& scaling) {
+    const int reduction = *series.reductions.begin(); // reductions ascend: finest first
+    const unsigned t0 = series.baseThreads(reduction);
+    const ScalingPoint* base = series.at(reduction, t0);
+    if (!base) return;
+
+    std::cout << "  Strong scaling at 1/" << reduction << " scale (" << formatFixed(base->megapixels, 1)
+              << " MP), speedup and efficiency over " << t0 << " thread(s):" << std::endl;
+    std::cout << "  " << std::left << std::setw(18) << "Stage" << std::right << std::setw(12)
+              << (std::to_string(t0) + " thr (ms)");
+    for (const unsigned t : series.threads) {
+        if (t > t0) std::cout << std::setw(14) << (std::to_string(t) + " thr");
+    }
+    std::cout << std::endl;
+
+    std::vector<std::string> flags;
+    for (size_t i = 0; i < timedStages().size(); ++i) {
+        printStageLabel(timedStages()[i]);
+        std::cout << std::setw(12) << formatFixed(stageMs(*base, i), 2);
+
+        const ScalingPoint* previous = base;
+        unsigned previousThreads = t0;
+        bool flagged = stageMs(*base, i) < MIN_STAGE_MS; // too short to judge
+        for (const unsigned t : series.threads) {
+            if (t <= t0) continue;
+            const ScalingPoint* point = series.at(reduction, t);
+            const double s = speedup(base, point, i);
+            const double efficiency = s * t0 / t;
+            std::cout << std::setw(14) << formatScaling(s, efficiency);
+            if (s < 0.0) continue;
+
+            const double step = speedup(previous, point, i);
+            if (!flagged && (efficiency < scaling.minEfficiency || step < scaling.minStepSpeedup)) {
+                flags.push_back(std::string(timedStages()[i].label) + " stops scaling at " + std::to_string(t) +
+                                " threads: efficiency " + formatFixed(efficiency * 100.0, 0) + "%, " +
+                                formatFixed(step, 2) + "x over " + std::to_string(previousThreads));
+                flagged = true;
+            }
+            previous = point;
+            previousThreads = t;
+        }
+        std::cout << std::endl;
+    }
+
+    for (const auto& flag : flags) {
+        std::cout << "  ! " << flag << std::endl;
+    }
+}
+
+// Weak scaling: each thread count paired with the resolution whose pixel count grew the most alike
+void printWeakScaling(const Series& series) {
+    const int coarsest = *series.reductions.rbegin();
+    const unsigned t0 = series.baseThreads(coarsest);
+    const ScalingPoint* base = series.at(coarsest, t0);
+    if (!base || series.reductions.size() < 2 || series.threads.size() < 2) return;
+
+    std::vector<const ScalingPoint*> paired;
+    for (const unsigned t : series.threads) {
+        if (t <= t0) continue;
+        const ScalingPoint* best = nullptr;
+        double bestDistance = 0.0;
+        for (const int r : series.reductions) {
+            const ScalingPoint* point = series.at(r, t);
+            if (!point) continue;
+            const double distance = std::abs(std::log(point->megapixels / base->megapixels) -
+                                             std::log(static_cast<double>(t) / t0));
+            if (!best || distance < bestDistance) {
+                best = point;
+                bestDistance = distance;
+            }
+        }
+        if (best) paired.push_back(best);
+    }
+    if (paired.empty()) return;
+
+    std::cout << "  Weak scaling from " << t0 << " thread(s) at " << formatFixed(base->megapixels, 1)
+              << " MP, efficiency (time per MP per thread vs. the base):" << std::endl;
+    std::cout << "  " << std::left << std::setw(18) << "Stage" << std::right;
+    for (const ScalingPoint* p : paired) {
+        std::cout << std::setw(18) << (std::to_string(p->threads) + " thr @ " + formatFixed(p->megapixels, 1) + " MP");
+    }
+    std::cout << std::endl;
+
+    for (size_t i = 0; i < timedStages().size(); ++i) {
+        printStageLabel(timedStages()[i]);
+        for (const ScalingPoint* p : paired) {
+            const double s = speedup(base, p, i);
+            const double efficiency = s * (p->megapixels / base->megapixels) * t0 / p->threads;
+            std::cout << std::setw(18) << (s < 0.0 ? "x" : formatFixed(efficiency * 100.0, 0) + "%");
+        }
+        std::cout << std::endl;
+    }
+}
+
+// Time per megapixel at every resolution, with the most threads measured there
+void printTimePerMegapixel(const Series& series) {
+    std::vector<const ScalingPoint*> columns;
+    for (auto r = series.reductions.rbegin(); r != series.reductions.rend(); ++r) {
+        for (auto t = series.threads.rbegin(); t != series.threads.rend(); ++t) {
+            if (const ScalingPoint* p = series.at(*r, *t)) {
+                columns.push_back(p);
+                break;
+            }
+        }
+    }
+
+    std::cout << "  Time per megapixel (ms/MP):" << std::endl;
+    std::cout << "  " << std::left << std::setw(18) << "Stage" << std::right;
+    for (const ScalingPoint* p : columns) {
+        std::cout << std::setw(18) << (formatFixed(p->megapixels, 1) + " MP, " + std::to_string(p->threads) + " thr");
+    }
+    std::cout << std::endl;
+
+    for (size_t i = 0; i < timedStages().size(); ++i) {
+        printStageLabel(timedStages()[i]);
+        for (const ScalingPoint* p : columns) {
+            std::cout << std::setw(18) << formatFixed(stageMs(*p, i) / std::max(p->megapixels, 1e-9), 2);
+        }
+        std::cout << std::endl;
+    }
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Scaling sweep Implementation
+// ============================================================================
+
+std::vector<unsigned> defaultScalingThreads() {
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> threads;
+    for (unsigned t = 1; t < hardware; t *= 2) {
+        threads.push_back(t);
+    }
+    threads.push_back(hardware);
+    return threads;
+}
+
+std::vector<ScalingPoint> runScalingSweep(const BenchmarkRunner::Options& options,
+                                          const ScalingOptions& scaling,
+                                          const std::vector<std::string>& imageDirs,
+                                          const std::set<std::string>& filteredImageSets,
+                                          const std::map<std::string, BenchmarkRunner::DetectorFilter>& filteredDetectors,
+                                          const std::string& outputPath) {
+    const std::vector<unsigned> threadCounts = scaling.threads.empty() ? defaultScalingThreads() : scaling.threads;
+    const int savedOpenCVThreads = cv::getNumThreads();
+    std::vector<ScalingPoint> points;
+
+    for (const int reduction : scaling.reductions) {
+        for (const unsigned threads : threadCounts) {
+            std::cout << "\n=== Scaling: " << threads << " thread(s), ingest scale 1/" << reduction << " ===" << std::endl;
+
+            // OpenCV's parallel loops and the project's pool (task graph, throughput jobs) get the same count
+            BenchmarkRunner::Options pointOptions = options;
+            pointOptions.ingestReduction = reduction;
+            pointOptions.threads = threads;
+            cv::setNumThreads(static_cast<int>(threads));
+
+            BenchmarkRunner runner(pointOptions);
+            for (const auto& imageDir : imageDirs) {
+                for (const auto& m : runner.runOnDirectory(imageDir, filteredImageSets, filteredDetectors, outputPath)) {
+                    if (!m.stitchingSuccess || m.fromCache) continue; // cached baselines were not timed here
+
+                    ScalingPoint point;
+                    point.datasetName = m.datasetName;
+                    point.algorithmName = m.algorithmName;
+                    point.windowSizes = m.windowSizes;
+                    point.threads = threads;
+                    point.reduction = reduction;
+                    point.megapixels = static_cast<double>(m.referenceWidth) * m.referenceHeight / 1e6;
+                    for (const auto& stage : timedStages()) {
+                        point.stageSeconds.push_back(m.*stage.seconds);
+                    }
+                    points.push_back(point);
+                }
+            }
+
+            // --concurrent-stages bound OpenCV to this point's pool, which setNumThreads cannot resize
+            resetOpenCVParallelBackend();
+        }
+    }
+
+    cv::setNumThreads(savedOpenCVThreads);
+    return points;
+}
+
+void printScalingReport(const std::vector<ScalingPoint>& points, const ScalingOptions& scaling) {
+    std::cout << "\n" << std::string(120, '=') << std::endl;
+    std::cout << "SCALING SUMMARY" << std::endl;
+    std::cout << std::string(120, '=') << std::endl;
+
+    for (const auto& [key, series] : groupSeries(points)) {
+        std::cout << "\n" << key.first << " / " << key.second << std::endl;
+        printStrongScaling(series, scaling);
+        printWeakScaling(series);
+        printTimePerMegapixel(series);
+    }
+}
+
+bool writeScalingCsv(const std::string& path, const std::vector<ScalingPoint>& points) {
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file.is_open()) return false;
+
+    file << "Dataset,Algorithm,Window Sizes,Threads,Ingest Scale,Megapixels";
+    for (const auto& stage : timedStages()) {
+        const std::string prefix = std::string(",") + stage.label;
+        file << prefix << " (ms)" << prefix << " Speedup" << prefix << " Efficiency" << prefix << " Time per MP (ms)";
+    }
+    file << "\n";
+
+    const auto series = groupSeries(points);
+    for (const auto& p : points) {
+        const Series& s = series.at({p.datasetName, p.algorithmName});
+        const unsigned t0 = s.baseThreads(p.reduction);
+        const ScalingPoint* base = s.at(p.reduction, t0);
+
+        file << p.datasetName << "," << p.algorithmName << ",\"" << p.windowSizes << "\"," << p.threads
+             << ",1/" << p.reduction << "," << formatFixed(p.megapixels, 3);
+        for (size_t i = 0; i < timedStages().size(); ++i) {
+            const double sp = speedup(base, &p, i);
+            file << "," << formatFixed(stageMs(p, i), 3)
+                 << "," << (sp < 0.0 ? "x" : formatFixed(sp, 3))
+                 << "," << (sp < 0.0 ? "x" : formatFixed(sp * t0 / p.threads, 3))
+                 << "," << formatFixed(stageMs(p, i) / std::max(p.megapixels, 1e-9), 3);
+        }
+        file << "\n";
+    }
+    return file.good();
+}
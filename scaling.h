@@ -0,0 +1,66 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * scaling.h
+ * Strong- and weak-scaling sweep of the benchmark (--scaling):
+ *  - runScalingSweep: rerun the selected stitches at each thread count (cv::setNumThreads and the
+ *    project's pool) and each ingest scale (1/8, 1/4, 1/2, 1: 4x the pixels per step)
+ *  - printScalingReport: per-stage speedup, parallel efficiency and time per megapixel, with the stages
+ *    that stop scaling flagged
+ *  - writeScalingCsv: one row per (stitch, threads, resolution)
+ */
+
+#ifndef SCALING_H
+#define SCALING_H
+
+#include "benchmark.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+struct ScalingOptions {
+    std::vector<unsigned> threads;         // empty: 1, 2, 4, ... up to the hardware threads
+    std::vector<int> reductions = {8, 4, 2, 1}; // ingest scales, coarse to fine
+    double minEfficiency = 0.5;            // flag a stage whose parallel efficiency drops below this
+    double minStepSpeedup = 1.1;           // ... or that gains less than this from doubling the threads
+};
+
+// One stitch at one thread count and resolution
+struct ScalingPoint {
+    std::string datasetName;
+    std::string algorithmName;
+    std::string windowSizes;
+    unsigned threads = 1;
+    int reduction = 1;
+    double megapixels = 0.0;         // reference image as decoded
+    std::vector<double> stageSeconds; // one per timedStages() entry (medians with --repeat)
+};
+
+/** @brief 1, 2, 4, ... up to the hardware thread count, which is always included. */
+std::vector<unsigned> defaultScalingThreads();
+
+/** @brief Run the benchmark over imageDirs once per (resolution, thread count) with otherwise the same
+ *  options, and keep the stage times of every successful stitch that was not loaded from the cache.
+ */
+std::vector<ScalingPoint> runScalingSweep(const BenchmarkRunner::Options& options,
+                                          const ScalingOptions& scaling,
+                                          const std::vector<std::string>& imageDirs,
+                                          const std::set<std::string>& filteredImageSets,
+                                          const std::map<std::string, BenchmarkRunner::DetectorFilter>& filteredDetectors,
+                                          const std::string& outputPath);
+
+/** @brief Per stitch: strong-scaling speedup and efficiency at the largest resolution, weak-scaling
+ *  efficiency (resolution grown with the thread count), time per megapixel per resolution, and the
+ *  stages that stop scaling.
+ */
+void printScalingReport(const std::vector<ScalingPoint>& points, const ScalingOptions& scaling);
+
+/** @brief Stage times, speedup over the fewest threads, efficiency and time per megapixel per point.
+ *  @return False if the file could not be written.
+ */
+bool writeScalingCsv(const std::string& path, const std::vector<ScalingPoint>& points);
+
+#endif //SCALING_H
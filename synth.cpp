@@ -0,0 +1,193 @@
+/*
+ * David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * synth.cpp
+ * Synthetic workload generator (css587synth target).
+ * Warps a source image with random known homographies into image sets of any resolution (100+ MP),
+ * in the images/<set>/ layout the benchmark reads, each with a ground_truth.yml holding the true H.
+ * The benchmark then reports the corner reprojection error of every estimate against it.
+ *
+ * Usage:
+ *   ./css587synth [--source <image or set dir>] [--out <dir>] [--name <prefix>] [--count N]
+ *                 [--size WxH | --mp N] [--overlap F] [--rotation DEG] [--scale F] [--perspective F]
+ *                 [--margin F] [--blur SIGMA] [--gain F] [--bias F] [--noise SIGMA] [--seed N]
+ */
+
+#include "synthgen.h"
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr double ASPECT_RATIO = 16.0 / 9.0; // --mp
+
+// reference.jpg of the first image set (sorted by name), or empty
+std::string firstReference(const std::string& imageDir) {
+    std::vector<std::string> sets;
+    if (fs::is_directory(imageDir)) {
+        for (const auto& entry : fs::directory_iterator(imageDir)) {
+            if (entry.is_directory() && fs::exists(entry.path() / "reference.jpg")) {
+                sets.push_back(entry.path().string());
+            }
+        }
+    }
+    std::sort(sets.begin(), sets.end());
+    return sets.empty() ? std::string() : sets.front() + "/reference.jpg";
+}
+
+// Set names numbered when more than one pair is generated
+std::string setName(const std::string& prefix, const int index, const int count) {
+    if (count == 1) return prefix;
+    std::ostringstream oss;
+    oss << prefix << "_" << std::setw(3) << std::setfill('0') << index;
+    return oss.str();
+}
+
+void printUsage(const std::string& programName) {
+    const SynthParams defaults;
+    std::cout << "Usage: " << programName << " [options]\n\n"
+              << "  --source <path>           Source image, or an image set directory (its reference.jpg)\n"
+              << "                            (default: reference.jpg of the first set in images)\n"
+              << "  --out <dir>               Directory the sets are written to (default: images)\n"
+              << "  --name <prefix>           Set name; numbered prefix_000... with --count (default: synth)\n"
+              << "  --count <N>               Pairs to generate, seeds seed..seed+N-1 (default: 1)\n"
+              << "  --size <WxH>              Resolution of both images (default: " << defaults.size.width << "x"
+              << defaults.size.height << ")\n"
+              << "  --mp <N>                  Resolution in megapixels at 16:9, instead of --size\n"
+              << "  --overlap <0-1>           Share of the reference covered by the registered image (default: "
+              << defaults.overlap << ")\n"
+              << "  --rotation <deg>          Maximum rotation (default: " << defaults.maxRotationDeg << ")\n"
+              << "  --scale <F>               Maximum scale change, zoom in [1-F, 1+F] (default: "
+              << defaults.maxScaleChange << ")\n"
+              << "  --perspective <F>         Maximum perspective distortion (default: " << defaults.maxPerspective << ")\n"
+              << "  --margin <F>              Source context kept around the reference frame (default: "
+              << defaults.margin << ")\n"
+              << "  --blur <sigma>            Gaussian blur of the registered image (default: off)\n"
+              << "  --gain <F>                Illumination gain of the registered image (default: 1)\n"
+              << "  --bias <F>                Illumination offset of the registered image (default: 0)\n"
+              << "  --noise <sigma>           Gaussian noise of the registered image (default: off)\n"
+              << "  --seed <N>                Seed of the first pair (default: " << defaults.seed << ")\n"
+              << "  --help                    Show this help message\n" << std::endl;
+}
+
+std::vector<std::string> split(const std::string& s, const char delimiter) {
+    std::vector<std::string> parts;
+    std::stringstream ss(s);
+    std::string part;
+    while (std::getline(ss, part, delimiter)) {
+        if (!part.empty()) parts.push_back(part);
+    }
+    return parts;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    SynthParams params;
+    std::string source;
+    std::string outDir = "images";
+    std::string name = "synth";
+    int count = 1;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+
+            if (arg == "--help" || arg == "-h") {
+                printUsage(argv[0]);
+                return 0;
+            } else if (arg == "--source" && hasValue) {
+                source = argv[++i];
+            } else if (arg == "--out" && hasValue) {
+                outDir = argv[++i];
+            } else if (arg == "--name" && hasValue) {
+                name = argv[++i];
+            } else if (arg == "--count" && hasValue) {
+                count = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--size" && hasValue) {
+                const std::string size = argv[++i];
+                const auto wh = split(size, 'x');
+                if (wh.size() != 2) throw std::invalid_argument("bad size " + size);
+                params.size = cv::Size(std::stoi(wh[0]), std::stoi(wh[1]));
+            } else if (arg == "--mp" && hasValue) {
+                const double pixels = std::stod(argv[++i]) * 1e6;
+                const int height = static_cast<int>(std::lround(std::sqrt(pixels / ASPECT_RATIO)));
+                params.size = cv::Size(static_cast<int>(std::lround(height * ASPECT_RATIO)), height);
+            } else if (arg == "--overlap" && hasValue) {
+                params.overlap = std::clamp(std::stod(argv[++i]), 0.0, 1.0);
+            } else if (arg == "--rotation" && hasValue) {
+                params.maxRotationDeg = std::abs(std::stod(argv[++i]));
+            } else if (arg == "--scale" && hasValue) {
+                params.maxScaleChange = std::clamp(std::stod(argv[++i]), 0.0, 0.9);
+            } else if (arg == "--perspective" && hasValue) {
+                params.maxPerspective = std::clamp(std::stod(argv[++i]), 0.0, 0.5);
+            } else if (arg == "--margin" && hasValue) {
+                params.margin = std::max(0.0, std::stod(argv[++i]));
+            } else if (arg == "--blur" && hasValue) {
+                params.blurSigma = std::max(0.0, std::stod(argv[++i]));
+            } else if (arg == "--gain" && hasValue) {
+                params.gain = std::stod(argv[++i]);
+            } else if (arg == "--bias" && hasValue) {
+                params.bias = std::stod(argv[++i]);
+            } else if (arg == "--noise" && hasValue) {
+                params.noiseSigma = std::max(0.0, std::stod(argv[++i]));
+            } else if (arg == "--seed" && hasValue) {
+                params.seed = std::stoull(argv[++i]);
+            } else {
+                std::cerr << "Unknown or incomplete argument: " << arg << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid argument: " << e.what() << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (params.size.width <= 0 || params.size.height <= 0) {
+        std::cerr << "The resolution must be positive" << std::endl;
+        return 1;
+    }
+
+    if (source.empty()) source = firstReference("images");
+    else if (fs::is_directory(source)) source += "/reference.jpg";
+    const cv::Mat image = source.empty() ? cv::Mat() : cv::imread(source, cv::IMREAD_COLOR);
+    if (image.empty()) {
+        std::cerr << "Error: Could not read a source image" << (source.empty() ? "" : " from " + source) << std::endl;
+        return 1;
+    }
+
+    const double megapixels = static_cast<double>(params.size.area()) / 1e6;
+    std::cout << "Source: " << source << " (" << image.cols << "x" << image.rows << ")\n"
+              << "Output: " << count << " pair(s) at " << params.size.width << "x" << params.size.height
+              << " (" << std::fixed << std::setprecision(1) << megapixels << " MP) in " << outDir << "\n" << std::endl;
+
+    const uint64_t firstSeed = params.seed;
+    for (int i = 0; i < count; ++i) {
+        params.seed = firstSeed + static_cast<uint64_t>(i);
+        const std::string set = setName(name, i, count);
+        const SynthPair pair = generatePair(image, params);
+
+        if (!writePair(outDir + "/" + set, pair, params, source)) {
+            std::cerr << "Error: Could not write " << outDir << "/" << set << std::endl;
+            return 1;
+        }
+        std::cout << set << ": seed " << params.seed << ", overlap " << std::setprecision(3) << pair.overlap
+                  << (std::abs(pair.overlap - params.overlap) > 0.01 ? " (target out of reach)" : "") << std::endl;
+    }
+    return 0;
+}
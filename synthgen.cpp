@@ -0,0 +1,216 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * synthgen.cpp
+ * Synthetic image pairs with known homographies and corner reprojection error.
+ */
+
+#include "synthgen.h"
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int OVERLAP_BISECTION_STEPS = 40;
+constexpr int NOISE_STRIP_ROWS = 256; // noise is added in strips to bound the float buffer at 100+ MP
+constexpr int JPEG_QUALITY = 95;
+
+std::vector<cv::Point2d> frameCorners(const cv::Size& size) {
+    const double w = size.width, h = size.height;
+    return {{0.0, 0.0}, {w, 0.0}, {w, h}, {0.0, h}};
+}
+
+// Source pixel coordinates of reference-frame pixels: a centered crop leaving `margin` context around it
+cv::Mat referenceToSource(const cv::Size& source, const cv::Size& size, const double margin) {
+    const double scale = std::min(static_cast<double>(source.width) / size.width,
+                                  static_cast<double>(source.height) / size.height) / (1.0 + margin);
+    const double x0 = (source.width - size.width * scale) / 2.0;
+    const double y0 = (source.height - size.height * scale) / 2.0;
+    return (cv::Mat_<double>(3, 3) << scale, 0.0, x0, 0.0, scale, y0, 0.0, 0.0, 1.0);
+}
+
+// Fraction of the reference frame covered by the registered frame mapped through H
+double coverage(const cv::Mat& H, const cv::Size& size) {
+    std::vector<cv::Point2f> mapped;
+    for (const cv::Point2d& p : frameCorners(size)) {
+        const double w = H.at<double>(2, 0) * p.x + H.at<double>(2, 1) * p.y + H.at<double>(2, 2);
+        if (w <= 0.0) return 0.0; // a corner behind the camera: the frame does not map to a quad
+        mapped.emplace_back(static_cast<float>((H.at<double>(0, 0) * p.x + H.at<double>(0, 1) * p.y + H.at<double>(0, 2)) / w),
+                            static_cast<float>((H.at<double>(1, 0) * p.x + H.at<double>(1, 1) * p.y + H.at<double>(1, 2)) / w));
+    }
+    if (!cv::isContourConvex(mapped)) return 0.0;
+
+    std::vector<cv::Point2f> frame, intersection;
+    for (const cv::Point2d& p : frameCorners(size)) frame.emplace_back(p);
+    const double area = cv::intersectConvexConvex(mapped, frame, intersection);
+    return std::max(0.0, area) / (static_cast<double>(size.width) * size.height);
+}
+
+cv::Mat translation(const double tx, const double ty) {
+    return (cv::Mat_<double>(3, 3) << 1.0, 0.0, tx, 0.0, 1.0, ty, 0.0, 0.0, 1.0);
+}
+
+// Gaussian noise in horizontal strips
+void addNoise(cv::Mat& image, const double sigma, cv::RNG& rng) {
+    for (int y = 0; y < image.rows; y += NOISE_STRIP_ROWS) {
+        cv::Mat strip = image.rowRange(y, std::min(image.rows, y + NOISE_STRIP_ROWS));
+        cv::Mat noisy;
+        strip.convertTo(noisy, CV_32F);
+        cv::Mat noise(noisy.size(), noisy.type());
+        rng.fill(noise, cv::RNG::NORMAL, 0.0, sigma);
+        noisy += noise;
+        noisy.convertTo(strip, image.type());
+    }
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Synthetic pair Implementation
+// ============================================================================
+
+SynthPair generatePair(const cv::Mat& source, const SynthParams& params) {
+    CV_Assert(!source.empty() && params.size.width > 0 && params.size.height > 0);
+    const cv::Size size = params.size;
+
+    // Random geometry, all drawn from the seed so a pair can be regenerated
+    cv::RNG rng(params.seed);
+    const double angle = rng.uniform(-params.maxRotationDeg, params.maxRotationDeg) * CV_PI / 180.0;
+    const double scale = 1.0 + rng.uniform(-params.maxScaleChange, params.maxScaleChange);
+    const double px = rng.uniform(-params.maxPerspective, params.maxPerspective) / size.width;
+    const double py = rng.uniform(-params.maxPerspective, params.maxPerspective) / size.height;
+    const double direction = rng.uniform(0.0, 2.0 * CV_PI);
+
+    // Rotation, scale and perspective about the frame center; the translation sets the overlap
+    const double cx = size.width / 2.0, cy = size.height / 2.0;
+    const cv::Mat shape = (cv::Mat_<double>(3, 3) <<
+        scale * std::cos(angle), -scale * std::sin(angle), 0.0,
+        scale * std::sin(angle), scale * std::cos(angle), 0.0,
+        0.0, 0.0, 1.0) * (cv::Mat_<double>(3, 3) << 1.0, 0.0, 0.0, 0.0, 1.0, 0.0, px, py, 1.0);
+    auto homography = [&](const double shift) -> cv::Mat {
+        return translation(cx + shift * std::cos(direction), cy + shift * std::sin(direction)) *
+               shape * translation(-cx, -cy);
+    };
+
+    double shift = 0.0;
+    if (coverage(homography(0.0), size) > params.overlap) {
+        double low = 0.0, high = 2.0 * std::hypot(size.width, size.height); // no overlap at high
+        for (int i = 0; i < OVERLAP_BISECTION_STEPS; ++i) {
+            const double mid = (low + high) / 2.0;
+            (coverage(homography(mid), size) > params.overlap ? low : high) = mid;
+        }
+        shift = (low + high) / 2.0;
+    }
+
+    SynthPair pair;
+    pair.H = homography(shift);
+    pair.overlap = coverage(pair.H, size);
+
+    // Downscale large sources first so the warps only magnify (no aliasing)
+    cv::Mat src = source;
+    cv::Mat toSource = referenceToSource(src.size(), size, params.margin);
+    if (toSource.at<double>(0, 0) > 1.0) {
+        const double factor = 1.0 / toSource.at<double>(0, 0);
+        cv::resize(source, src, cv::Size(), factor, factor, cv::INTER_AREA);
+        toSource = referenceToSource(src.size(), size, params.margin);
+    }
+
+    cv::warpAffine(src, pair.reference, toSource.rowRange(0, 2), size, cv::INTER_LINEAR | cv::WARP_INVERSE_MAP);
+    cv::warpPerspective(src, pair.registered, toSource * pair.H, size, cv::INTER_LINEAR | cv::WARP_INVERSE_MAP,
+                        cv::BORDER_CONSTANT, cv::Scalar::all(0));
+
+    // Degrade the registered image: optics, then illumination, then sensor noise
+    if (params.blurSigma > 0.0) {
+        cv::GaussianBlur(pair.registered, pair.registered, cv::Size(), params.blurSigma);
+    }
+    if (params.gain != 1.0 || params.bias != 0.0) {
+        pair.registered.convertTo(pair.registered, -1, params.gain, params.bias);
+    }
+    if (params.noiseSigma > 0.0) {
+        addNoise(pair.registered, params.noiseSigma, rng);
+    }
+
+    return pair;
+}
+
+bool writePair(const std::string& setDir, const SynthPair& pair, const SynthParams& params,
+               const std::string& sourceName) {
+    std::error_code ec;
+    fs::create_directories(setDir, ec);
+
+    const std::vector<int> jpeg = {cv::IMWRITE_JPEG_QUALITY, JPEG_QUALITY};
+    if (!cv::imwrite(setDir + "/reference.jpg", pair.reference, jpeg) ||
+        !cv::imwrite(setDir + "/registered.jpg", pair.registered, jpeg)) {
+        return false;
+    }
+
+    cv::FileStorage out(setDir + "/" + GROUND_TRUTH_FILE, cv::FileStorage::WRITE);
+    if (!out.isOpened()) return false;
+    out << "H" << pair.H; // registered -> reference pixel coordinates
+    out << "reference_width" << pair.reference.cols << "reference_height" << pair.reference.rows;
+    out << "registered_width" << pair.registered.cols << "registered_height" << pair.registered.rows;
+    out << "overlap" << pair.overlap;
+    out << "target_overlap" << params.overlap;
+    out << "max_rotation_deg" << params.maxRotationDeg;
+    out << "max_scale_change" << params.maxScaleChange;
+    out << "max_perspective" << params.maxPerspective;
+    out << "blur_sigma" << params.blurSigma;
+    out << "gain" << params.gain;
+    out << "bias" << params.bias;
+    out << "noise_sigma" << params.noiseSigma;
+    out << "seed" << std::to_string(params.seed);
+    out << "source" << sourceName;
+    return true;
+}
+
+bool loadGroundTruth(const std::string& setDir, GroundTruth& truth) {
+    const std::string path = setDir + "/" + GROUND_TRUTH_FILE;
+    if (!fs::exists(path)) return false;
+
+    try {
+        cv::FileStorage in(path, cv::FileStorage::READ);
+        if (!in.isOpened()) return false;
+
+        cv::Mat H;
+        int width = 0, height = 0;
+        in["H"] >> H;
+        in["registered_width"] >> width;
+        in["registered_height"] >> height;
+        if (H.rows != 3 || H.cols != 3 || width <= 0 || height <= 0) return false;
+
+        H.convertTo(truth.H, CV_64F);
+        truth.registeredSize = cv::Size(width, height);
+        return true;
+    } catch (const cv::Exception&) {
+        return false;
+    }
+}
+
+double cornerReprojectionError(const cv::Mat& estimatedH, const GroundTruth& truth, const int reduction) {
+    // The estimate maps reduced registered pixels to reduced reference pixels: lift it to full resolution
+    const double r = std::max(1, reduction);
+    const cv::Mat toFull = (cv::Mat_<double>(3, 3) << r, 0.0, 0.0, 0.0, r, 0.0, 0.0, 0.0, 1.0);
+    cv::Mat estimated;
+    estimatedH.convertTo(estimated, CV_64F);
+    estimated = toFull * estimated * toFull.inv();
+
+    const std::vector<cv::Point2d> corners = frameCorners(truth.registeredSize);
+    std::vector<cv::Point2d> expected, actual;
+    cv::perspectiveTransform(corners, expected, truth.H);
+    cv::perspectiveTransform(corners, actual, estimated);
+
+    double sum = 0.0;
+    for (size_t i = 0; i < corners.size(); ++i) {
+        sum += cv::norm(actual[i] - expected[i]);
+    }
+    return sum / corners.size();
+}
@@ -0,0 +1,72 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * synthgen.h
+ * Synthetic image pairs with a known homography, and accuracy against it:
+ *  - generatePair: warp a source image with a random homography of controlled overlap, then degrade
+ *    the registered image (blur, illumination change, noise)
+ *  - writePair / loadGroundTruth: images/<set>/ layout plus ground_truth.yml
+ *  - cornerReprojectionError: estimated vs. true homography at the registered image's corners
+ */
+
+#ifndef SYNTHGEN_H
+#define SYNTHGEN_H
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <string>
+
+// Ground-truth file written next to reference.jpg and registered.jpg
+constexpr const char* GROUND_TRUTH_FILE = "ground_truth.yml";
+
+struct SynthParams {
+    cv::Size size{3840, 2160};   // resolution of both images
+    double overlap = 0.7;        // fraction of the reference frame covered by the registered image
+    double maxRotationDeg = 10.0;
+    double maxScaleChange = 0.1; // registered zoom drawn from [1 - x, 1 + x]
+    double maxPerspective = 0.05; // |h20| * width and |h21| * height drawn from [0, x]
+    double margin = 0.5;         // source context around the reference frame, as a fraction of its size
+    double blurSigma = 0.0;      // Gaussian blur of the registered image (pixels)
+    double gain = 1.0;           // registered = gain * I + bias
+    double bias = 0.0;
+    double noiseSigma = 0.0;     // additive Gaussian noise (gray levels)
+    uint64_t seed = 1;
+};
+
+struct SynthPair {
+    cv::Mat reference;
+    cv::Mat registered;
+    cv::Mat H;            // registered -> reference pixel coordinates (CV_64F), as the benchmark estimates it
+    double overlap = 0.0; // achieved overlap (the target may be out of reach at the drawn rotation/scale)
+};
+
+/** @brief Generate a pair from a source image (any size; resampled to params.size).
+ *  The reference is a centered crop of the source, the registered image sees it through a random
+ *  rotation, scale, perspective and translation, the translation found by bisection to reach the
+ *  requested overlap. Content outside the source is black.
+ */
+SynthPair generatePair(const cv::Mat& source, const SynthParams& params);
+
+/** @brief Write reference.jpg, registered.jpg and ground_truth.yml into setDir (created if missing).
+ *  @param sourceName Recorded in the ground-truth file.
+ */
+bool writePair(const std::string& setDir, const SynthPair& pair, const SynthParams& params,
+               const std::string& sourceName);
+
+struct GroundTruth {
+    cv::Mat H;                // registered -> reference, full-resolution pixels
+    cv::Size registeredSize;  // full-resolution size of registered.jpg
+};
+
+/** @brief Read setDir/ground_truth.yml; false if there is none. */
+bool loadGroundTruth(const std::string& setDir, GroundTruth& truth);
+
+/** @brief Mean distance in full-resolution reference pixels between the registered image's four corners
+ *  mapped by the estimated and by the true homography.
+ *  @param estimatedH Homography estimated on images decoded at 1/reduction resolution.
+ */
+double cornerReprojectionError(const cv::Mat& estimatedH, const GroundTruth& truth, int reduction = 1);
+
+#endif //SYNTHGEN_H
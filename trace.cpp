@@ -0,0 +1,339 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * trace.cpp
+ * Per-thread span ring buffers, recycled across threads, and Chrome trace event export.
+ */
+
+#include "trace.h"
+
+#ifdef LP_TRACING
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_set>
+#include <vector>
+
+namespace trace {
+
+namespace {
+
+struct Event {
+    const char* name;
+    int64_t startNs;
+    int64_t endNs;
+    Context context;
+    int argCount;
+    const char* argKeys[MAX_SPAN_ARGS];
+    int64_t argValues[MAX_SPAN_ARGS];
+};
+
+// Written only by its thread; read by writeChromeTrace once recording has stopped
+struct ThreadBuffer {
+    int tid = 0;
+    std::string name; // guarded by registryMutex
+    std::vector<Event> events = std::vector<Event>(RING_CAPACITY);
+    std::atomic<uint64_t> written{0};
+};
+
+// Events of an exited thread, copied out when a new thread took over its buffer
+struct RetiredThread {
+    int tid;
+    std::string name;
+    std::vector<Event> events; // oldest first
+    uint64_t dropped;
+};
+
+std::atomic<bool> tracingEnabled{false};
+std::chrono::steady_clock::time_point epoch;
+std::once_flag epochOnce;
+
+std::mutex registryMutex; // guards the buffers, free list, retired threads, thread names and lastTid
+std::mutex internMutex;
+int lastTid = 0;
+size_t retiredEvents = 0;   // events held by retiredThreads() (registryMutex)
+uint64_t retiredDropped = 0; // events of retired threads dropped beyond RETIRED_CAPACITY (registryMutex)
+
+// Never destroyed: threads may still record during static destruction
+std::vector<std::unique_ptr<ThreadBuffer>>& registry() {
+    static auto* buffers = new std::vector<std::unique_ptr<ThreadBuffer>>();
+    return *buffers;
+}
+
+// Buffers of exited threads, still holding their events until reused
+std::vector<ThreadBuffer*>& freeBuffers() {
+    static auto* buffers = new std::vector<ThreadBuffer*>();
+    return *buffers;
+}
+
+// Oldest exited thread first
+std::deque<RetiredThread>& retiredThreads() {
+    static auto* threads = new std::deque<RetiredThread>();
+    return *threads;
+}
+
+std::unordered_set<std::string>& internTable() {
+    static auto* table = new std::unordered_set<std::string>();
+    return *table;
+}
+
+thread_local ThreadBuffer* tlsBuffer = nullptr; // owned by the registry
+thread_local Context tlsContext;
+
+// Hands the thread's buffer to the free list when the thread exits
+struct BufferReturn {
+    ThreadBuffer* buffer = nullptr;
+
+    ~BufferReturn() {
+        if (!buffer) return;
+        std::lock_guard<std::mutex> lock(registryMutex);
+        freeBuffers().push_back(buffer);
+        tlsBuffer = nullptr;
+    }
+};
+thread_local BufferReturn tlsBufferReturn;
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+// Copy an exited thread's events out of its buffer and empty it for reuse (registryMutex held)
+void retire(ThreadBuffer& buffer) {
+    const uint64_t written = buffer.written.load(std::memory_order_acquire);
+    const uint64_t first = written > RING_CAPACITY ? written - RING_CAPACITY : 0;
+    if (written > 0) {
+        RetiredThread thread{buffer.tid, std::move(buffer.name), {}, first};
+        thread.events.reserve(static_cast<size_t>(written - first));
+        for (uint64_t i = first; i < written; ++i) {
+            thread.events.push_back(buffer.events[i % RING_CAPACITY]);
+        }
+        retiredEvents += thread.events.size();
+        retiredThreads().push_back(std::move(thread));
+
+        // Keep the most recent exited threads within the cap
+        while (retiredEvents > RETIRED_CAPACITY) {
+            const RetiredThread& oldest = retiredThreads().front();
+            retiredEvents -= oldest.events.size();
+            retiredDropped += oldest.dropped + oldest.events.size();
+            retiredThreads().pop_front();
+        }
+    }
+    buffer.name.clear();
+    buffer.written.store(0, std::memory_order_relaxed);
+}
+
+// The calling thread's buffer: an exited thread's if one is free, else a new one
+ThreadBuffer& threadBuffer() {
+    if (!tlsBuffer) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        if (freeBuffers().empty()) {
+            registry().push_back(std::make_unique<ThreadBuffer>());
+            tlsBuffer = registry().back().get();
+        } else {
+            tlsBuffer = freeBuffers().back();
+            freeBuffers().pop_back();
+            retire(*tlsBuffer);
+        }
+        tlsBuffer->tid = ++lastTid;
+        tlsBufferReturn.buffer = tlsBuffer;
+    }
+    return *tlsBuffer;
+}
+
+std::string escapeJson(const char* s) {
+    std::ostringstream r;
+    for (; *s; ++s) {
+        const char c = *s;
+        switch (c) {
+            case '"': r << "\\\""; break;
+            case '\\': r << "\\\\"; break;
+            case '\n': r << "\\n"; break;
+            case '\t': r << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    r << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec;
+                } else {
+                    r << c;
+                }
+        }
+    }
+    return r.str();
+}
+
+void writeMicroseconds(std::ostream& out, const int64_t ns) {
+    out << ns / 1000 << "." << std::setw(3) << std::setfill('0') << ns % 1000 << std::setfill(' ');
+}
+
+void writeThreadName(std::ostream& out, const int tid, const std::string& name) {
+    if (name.empty()) return;
+    out << ",\n  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << tid
+        << ", \"args\": {\"name\": \"" << escapeJson(name.c_str()) << "\"}}";
+}
+
+void writeEvent(std::ostream& out, const Event& e, const int tid) {
+    out << ",\n  {\"name\": \"" << escapeJson(e.name) << "\", \"cat\": \"pipeline\", \"ph\": \"X\", "
+        << "\"pid\": 1, \"tid\": " << tid << ", \"ts\": ";
+    writeMicroseconds(out, e.startNs);
+    out << ", \"dur\": ";
+    writeMicroseconds(out, e.endNs - e.startNs);
+    out << ", \"args\": {";
+
+    const char* separator = "";
+    const std::pair<const char*, const char*> context[] = {
+        {"dataset", e.context.dataset},
+        {"detector", e.context.detector},
+        {"window_sizes", e.context.windowSizes},
+    };
+    for (const auto& entry : context) {
+        if (!entry.second || !*entry.second) continue;
+        out << separator << "\"" << entry.first << "\": \"" << escapeJson(entry.second) << "\"";
+        separator = ", ";
+    }
+    for (int a = 0; a < e.argCount; ++a) {
+        out << separator << "\"" << escapeJson(e.argKeys[a]) << "\": " << e.argValues[a];
+        separator = ", ";
+    }
+    out << "}}";
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// Tracing Implementation
+// ============================================================================
+
+void enable() {
+    std::call_once(epochOnce, [] { epoch = std::chrono::steady_clock::now(); });
+    tracingEnabled.store(true, std::memory_order_release);
+}
+
+bool enabled() {
+    return tracingEnabled.load(std::memory_order_acquire);
+}
+
+void setThreadName(const std::string& name) {
+    if (!enabled()) return;
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    buffer.name = name;
+}
+
+Context currentContext() {
+    return tlsContext;
+}
+
+// Stable copy of a string for events that outlive it (set nodes never move)
+const char* intern(const std::string& s) {
+    std::lock_guard<std::mutex> lock(internMutex);
+    return internTable().insert(s).first->c_str();
+}
+
+bool writeChromeTrace(const std::string& path) {
+    std::ofstream file(path, std::ios::out | std::ios::trunc);
+    if (!file.is_open()) return false;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    uint64_t dropped = retiredDropped;
+
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n"
+         << "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"css587project\"}}";
+
+    for (const auto& thread : retiredThreads()) {
+        writeThreadName(file, thread.tid, thread.name);
+        dropped += thread.dropped;
+        for (const Event& e : thread.events) {
+            writeEvent(file, e, thread.tid);
+        }
+    }
+
+    for (const auto& buffer : registry()) {
+        writeThreadName(file, buffer->tid, buffer->name);
+
+        const uint64_t written = buffer->written.load(std::memory_order_acquire);
+        const uint64_t first = written > RING_CAPACITY ? written - RING_CAPACITY : 0;
+        dropped += first;
+        for (uint64_t i = first; i < written; ++i) {
+            writeEvent(file, buffer->events[i % RING_CAPACITY], buffer->tid);
+        }
+    }
+
+    file << "\n], \"otherData\": {\"dropped_events\": " << dropped << "}}\n";
+    return file.good();
+}
+
+// ============================================================================
+// ContextScope Implementation
+// ============================================================================
+
+ContextScope::ContextScope(const std::string& dataset, const std::string& detector, const std::string& windowSizes)
+    : previous_(tlsContext) {
+    if (!enabled()) return;
+    tlsContext.dataset = intern(dataset);
+    tlsContext.detector = intern(detector);
+    tlsContext.windowSizes = intern(windowSizes);
+}
+
+ContextScope::ContextScope(const Context& context) : previous_(tlsContext) {
+    tlsContext = context;
+}
+
+ContextScope::~ContextScope() {
+    tlsContext = previous_;
+}
+
+// ============================================================================
+// Span Implementation
+// ============================================================================
+
+Span::Span(const std::string& name) {
+    if (enabled()) begin(intern(name));
+}
+
+void Span::begin(const char* name) {
+    end();
+    if (!tracingEnabled.load(std::memory_order_relaxed)) return;
+    name_ = name;
+    argCount_ = 0;
+    startNs_ = nowNs();
+}
+
+void Span::end() {
+    if (!name_) return;
+
+    Event event;
+    event.endNs = nowNs();
+    event.name = name_;
+    event.startNs = startNs_;
+    event.context = tlsContext;
+    event.argCount = argCount_;
+    for (int a = 0; a < argCount_; ++a) {
+        event.argKeys[a] = argKeys_[a];
+        event.argValues[a] = argValues_[a];
+    }
+
+    ThreadBuffer& buffer = threadBuffer();
+    const uint64_t slot = buffer.written.load(std::memory_order_relaxed);
+    buffer.events[slot % RING_CAPACITY] = event;
+    buffer.written.store(slot + 1, std::memory_order_release);
+    name_ = nullptr;
+}
+
+Span& Span::arg(const char* key, const int64_t value) {
+    if (name_ && argCount_ < MAX_SPAN_ARGS) {
+        argKeys_[argCount_] = key;
+        argValues_[argCount_] = value;
+        ++argCount_;
+    }
+    return *this;
+}
+
+} // namespace trace
+
+#endif // LP_TRACING
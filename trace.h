@@ -0,0 +1,143 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * trace.h
+ * Low-overhead tracing of pipeline stages and worker threads (--trace):
+ *  - Span: scoped begin/end event with up to three numeric arguments
+ *  - ContextScope: dataset, detector and window sizes attached to every span of the calling thread
+ *  - writeChromeTrace: Chrome trace event JSON, viewable in chrome://tracing or ui.perfetto.dev
+ *
+ * Spans go to a fixed-size ring buffer per thread, so recording a span named by a static or interned
+ * string takes no lock and no allocation once the thread has its buffer. Buffers of exited threads are
+ * reused by new ones, their events copied out until the dump; those copies are capped at
+ * RETIRED_CAPACITY events, dropping the oldest exited threads first.
+ * Built without LP_TRACING (CMake option) every class here is empty and inline, and compiles to nothing.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace trace {
+
+// Events kept per thread; older events are overwritten (and counted as dropped) when a thread records more
+constexpr size_t RING_CAPACITY = size_t(1) << 14;
+// Events kept of exited threads in total; beyond it the oldest exited threads are dropped (and counted)
+constexpr size_t RETIRED_CAPACITY = RING_CAPACITY * 16;
+constexpr int MAX_SPAN_ARGS = 3;
+
+// Identification of the stitch a thread is working on (interned strings, null when unset)
+struct Context {
+    const char* dataset = nullptr;
+    const char* detector = nullptr;
+    const char* windowSizes = nullptr;
+};
+
+#ifdef LP_TRACING
+
+/** @brief Start recording; spans before this call are no-ops. Timestamps are relative to the first call. */
+void enable();
+
+/** @brief True once enable() was called. */
+bool enabled();
+
+/** @brief Name the calling thread in the trace (e.g. "worker 3"). */
+void setThreadName(const std::string& name);
+
+/** @brief Context of the calling thread, to hand to helper threads working on the same stitch. */
+Context currentContext();
+
+/** @brief Stable copy of a span name built at run time. Takes a lock: call it once, outside the hot path. */
+const char* intern(const std::string& s);
+
+/** @brief Write every recorded span as Chrome trace event JSON. Call when no thread is recording.
+ *  @return False if the file could not be written.
+ */
+bool writeChromeTrace(const std::string& path);
+
+// Sets the calling thread's context for its lifetime and restores the previous one
+class ContextScope {
+public:
+    ContextScope(const std::string& dataset, const std::string& detector, const std::string& windowSizes);
+    explicit ContextScope(const Context& context);
+    ~ContextScope();
+
+    ContextScope(const ContextScope&) = delete;
+    ContextScope& operator=(const ContextScope&) = delete;
+
+private:
+    Context previous_;
+};
+
+/*
+ * Span - One timed event on the calling thread, recorded when it ends (at destruction or end()).
+ * A default-constructed span records nothing until begin().
+ */
+class Span {
+public:
+    Span() = default;
+    explicit Span(const char* name) { begin(name); }
+    explicit Span(const std::string& name); // interns name (locks); prefer a static or interned string
+    ~Span() { end(); }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    /** @param name Static string (or interned); it is not copied. */
+    void begin(const char* name);
+    void end();
+
+    /** @brief Attach a numeric argument; ignored past MAX_SPAN_ARGS or when not recording. */
+    Span& arg(const char* key, int64_t value);
+
+private:
+    const char* name_ = nullptr; // null when not recording
+    int64_t startNs_ = 0;
+    int argCount_ = 0;
+    const char* argKeys_[MAX_SPAN_ARGS] = {};
+    int64_t argValues_[MAX_SPAN_ARGS] = {};
+};
+
+#else // LP_TRACING
+
+inline void enable() {}
+inline bool enabled() { return false; }
+inline void setThreadName(const std::string&) {}
+inline Context currentContext() { return {}; }
+inline const char* intern(const std::string&) { return ""; }
+inline bool writeChromeTrace(const std::string&) { return false; }
+
+class ContextScope {
+public:
+    ContextScope(const std::string&, const std::string&, const std::string&) {}
+    explicit ContextScope(const Context&) {}
+};
+
+class Span {
+public:
+    Span() = default;
+    explicit Span(const char*) {}
+    explicit Span(const std::string&) {}
+    void begin(const char*) {}
+    void end() {}
+    Span& arg(const char*, int64_t) { return *this; }
+};
+
+#endif // LP_TRACING
+
+/** @brief True if this build records spans (LP_TRACING). */
+constexpr bool compiledIn() {
+#ifdef LP_TRACING
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace trace
+
+#endif //TRACE_H
@@ -0,0 +1,81 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * yuvframe.cpp
+ * Zero-copy view of semi-planar YUV 4:2:0 camera frames.
+ */
+
+#include "yuvframe.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <vector>
+
+YUVFrame YUVFrame::wrap(const Layout layout, const int width, const int height,
+                        const uchar* y, const size_t yStride,
+                        const uchar* uv, const size_t uvStride,
+                        std::shared_ptr<const void> keepAlive) {
+    CV_Assert(y != nullptr && uv != nullptr);
+    CV_Assert(width > 0 && height > 0 && width % 2 == 0 && height % 2 == 0); // 4:2:0 subsampling
+    CV_Assert(yStride >= static_cast<size_t>(width) && uvStride >= static_cast<size_t>(width));
+
+    YUVFrame frame;
+    frame.layout_ = layout;
+    frame.width_ = width;
+    frame.height_ = height;
+    frame.y_ = y;
+    frame.yStride_ = yStride;
+    frame.uv_ = uv;
+    frame.uvStride_ = uvStride;
+    frame.keepAlive_ = std::move(keepAlive);
+    return frame;
+}
+
+YUVFrame YUVFrame::fromBGR(const cv::Mat& bgr, const Layout layout) {
+    CV_Assert(bgr.type() == CV_8UC3 && bgr.cols >= 2 && bgr.rows >= 2);
+    const int width = bgr.cols & ~1;
+    const int height = bgr.rows & ~1;
+
+    // Planar I420 (Y, U, V), then U and V interleaved into the semi-planar chroma plane
+    cv::Mat i420;
+    cv::cvtColor(bgr(cv::Rect(0, 0, width, height)), i420, cv::COLOR_BGR2YUV_I420);
+    const size_t lumaBytes = static_cast<size_t>(width) * height;
+    const size_t planeBytes = lumaBytes / 4;
+    auto buffer = std::make_shared<std::vector<uchar>>(lumaBytes + 2 * planeBytes);
+    std::copy(i420.data, i420.data + lumaBytes, buffer->data());
+
+    uchar* u = i420.data + lumaBytes;
+    uchar* v = u + planeBytes;
+    const cv::Mat planes[] = {
+        cv::Mat(height / 2, width / 2, CV_8UC1, layout == Layout::NV12 ? u : v),
+        cv::Mat(height / 2, width / 2, CV_8UC1, layout == Layout::NV12 ? v : u)
+    };
+    cv::Mat uv(height / 2, width / 2, CV_8UC2, buffer->data() + lumaBytes);
+    cv::merge(planes, 2, uv);
+
+    const uchar* data = buffer->data();
+    return wrap(layout, width, height, data, width, data + lumaBytes, width, std::move(buffer));
+}
+
+const cv::Mat YUVFrame::luma() const {
+    if (empty()) return cv::Mat();
+    // Mat has no read-only header; the const return and the class contract keep writers away
+    return cv::Mat(height_, width_, CV_8UC1, const_cast<uchar*>(y_), yStride_);
+}
+
+const cv::Mat YUVFrame::chroma() const {
+    if (empty()) return cv::Mat();
+    return cv::Mat(height_ / 2, width_ / 2, CV_8UC2, const_cast<uchar*>(uv_), uvStride_);
+}
+
+void YUVFrame::toBGR(cv::OutputArray dst) const {
+    if (empty()) {
+        dst.release();
+        return;
+    }
+    // Two-plane conversion reads the planes in place, whatever their strides and relative position
+    const int code = layout_ == Layout::NV12 ? cv::COLOR_YUV2BGR_NV12 : cv::COLOR_YUV2BGR_NV21;
+    cv::cvtColorTwoPlane(luma(), chroma(), dst, code);
+}
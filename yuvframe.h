@@ -0,0 +1,86 @@
+/*
+* David Li, Ben Schipunov, Kris Yu
+ * CSS 587 - Final Project: LP-SIFT
+ *
+ * yuvframe.h
+ * Zero-copy view of externally owned semi-planar YUV 4:2:0 camera frames (NV12 / NV21).
+ */
+
+#ifndef YUVFRAME_H
+#define YUVFRAME_H
+
+#include <opencv2/core.hpp>
+
+#include <cstddef>
+#include <memory>
+
+/*
+ * YUVFrame - View of a camera frame in the caller's buffers: a full-resolution Y plane and a half-resolution
+ * interleaved chroma plane, each with its own stride. Nothing is copied. The optional keep-alive handle is
+ * shared by every copy of the view, so the buffers outlive all of them (e.g. a capture buffer returned to
+ * the driver in the handle's deleter).
+ * luma() is the grayscale image LP detection and description run on; chroma is only read by toBGR().
+ * The view is immutable: luma() and chroma() return const headers that do not own the buffers. Never write
+ * through them (cv::Mat cannot enforce this), and keep the view alive while they are used.
+ */
+class YUVFrame {
+public:
+    enum class Layout {
+        NV12, // Y plane, then interleaved U/V
+        NV21  // Y plane, then interleaved V/U
+    };
+
+    YUVFrame() = default;
+
+    /** @brief Wrap a semi-planar frame without copying.
+     *  @param layout Chroma order.
+     *  @param width Frame width in pixels (even).
+     *  @param height Frame height in pixels (even).
+     *  @param y First byte of the Y plane (height rows of width bytes).
+     *  @param yStride Bytes between Y rows (>= width).
+     *  @param uv First byte of the chroma plane (height/2 rows of width/2 pairs).
+     *  @param uvStride Bytes between chroma rows (>= width).
+     *  @param keepAlive Owner of the buffers, released with the last copy of the view; may be null
+     *                   if the caller guarantees the buffers outlive the view.
+     */
+    static YUVFrame wrap(Layout layout, int width, int height,
+                         const uchar* y, size_t yStride,
+                         const uchar* uv, size_t uvStride,
+                         std::shared_ptr<const void> keepAlive = nullptr);
+
+    /** @brief Repack an 8-bit BGR image as a frame owning its buffers, as a camera would deliver it.
+     *  An odd last row or column is dropped (4:2:0 subsampling needs even sizes).
+     */
+    static YUVFrame fromBGR(const cv::Mat& bgr, Layout layout = Layout::NV12);
+
+    bool empty() const { return y_ == nullptr; }
+    int width() const { return width_; }
+    int height() const { return height_; }
+    Layout layout() const { return layout_; }
+
+    /** @brief CV_8UC1 header over the Y plane (no copy); never written through. */
+    const cv::Mat luma() const;
+
+    /** @brief CV_8UC2 header over the chroma plane, width/2 x height/2 (no copy); never written through. */
+    const cv::Mat chroma() const;
+
+    /** @brief Bytes of both planes (without row padding). */
+    size_t bytes() const { return empty() ? 0 : static_cast<size_t>(width_) * height_ * 3 / 2; }
+
+    /** @brief Convert to 8-bit BGR; the only place the chroma plane is read.
+     *  @param dst Output image, width x height, CV_8UC3.
+     */
+    void toBGR(cv::OutputArray dst) const;
+
+private:
+    Layout layout_ = Layout::NV12;
+    int width_ = 0;
+    int height_ = 0;
+    const uchar* y_ = nullptr;
+    size_t yStride_ = 0;
+    const uchar* uv_ = nullptr;
+    size_t uvStride_ = 0;
+    std::shared_ptr<const void> keepAlive_;
+};
+
+#endif //YUVFRAME_H